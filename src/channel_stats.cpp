@@ -0,0 +1,142 @@
+/**
+ * channel_stats.cpp — kanal başına akan istatistik penceresi
+ * ------------------------------------------------------------
+ *  › Sorun: panolar yalnız 10 s’de bir anlık W görüyordu; kısa tepeler
+ *    hiç görünmüyor, kaydedici veritabanı ise gereksiz büyüyordu.
+ *  › Her taze Irms (kanal başına ≈240 ms) tek gözlem: W = Irms × 230.
+ *    Toplam, pencere sayısı, ON sayısı artımlı → bellek sabit.
+ *  › p95: P² (Jain & Chlamtac 1985) — 5 işaretçi (yükseklik + konum).
+ *    İşaretçi 0 ve 4 gözlenen en küçük / en büyük değerdir → min / max
+ *    bedava. Yükseklikler 1 W çözünürlükte uint16; istenen konumlar
+ *    gözlem sayısından her seferinde hesaplanır (ayrıca saklanmaz).
+ *    İlk 5 gözlem sıralanarak işaretçilere yazılır; n < 5 → p95 = max.
+ *  › Görev oranı pencere sayısıyla: pencereler eşit aralıklı olduğu için
+ *    ON pencere / tüm pencere = ON süresi oranı.
+ *  › Yalnız sensörlü 12 kanal yer kaplar (slot tablosu).
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "channel_stats.h"
+#include "current_sense.h"
+#include "tanimlamalar.h"
+
+#define STATS_MAINS_V   230.0f      // energyTick() ile aynı varsayım
+#define STATS_SLOTS     12          // sensörlü Y kanalı
+#define STATS_NO_SLOT   0xFF
+#define STATS_N_MAX     60000       // uint16 konumlar taşmasın (≈4 saat)
+
+struct ChanStats {
+    uint16_t q[5];                  // P² işaretçi yükseklikleri (W)
+    uint16_t pos[5];                // işaretçi konumları (1 tabanlı)
+    uint32_t sumW;
+    uint16_t n;
+    uint16_t onN;                   // pinState ON pencereleri
+    uint16_t actN;                  // ON ve W > 0
+};
+
+static ChanStats st[STATS_SLOTS];
+static uint8_t   slotOf[NUM_Y_CHANNELS];
+static uint32_t  tStart = 0;
+
+/* p = 0.95 için işaretçilerin istenen konum oranları */
+static const float P2_DN[5] = { 0.0f, 0.475f, 0.95f, 0.975f, 1.0f };
+
+//--------------------------------------------------------------
+//  P²
+//--------------------------------------------------------------
+static void p2Add(ChanStats& c, uint16_t x)
+{
+    uint16_t n = c.n;                               // bu gözlemden önceki sayı
+    if (n < 5) {                                    // ilk 5: sıralı ekle
+        uint8_t i = n;
+        while (i > 0 && c.q[i - 1] > x) { c.q[i] = c.q[i - 1]; --i; }
+        c.q[i]   = x;
+        c.pos[n] = n + 1;
+        return;
+    }
+
+    uint8_t k;
+    if      (x <  c.q[0]) { c.q[0] = x; k = 0; }
+    else if (x >= c.q[4]) { c.q[4] = x; k = 3; }
+    else { k = 0; while (x >= c.q[k + 1]) ++k; }
+    for (uint8_t i = k + 1; i < 5; ++i) c.pos[i]++;
+
+    float total = n;                                // gözlem sayısı − 1
+    for (uint8_t i = 1; i < 4; ++i) {
+        float d  = 1.0f + total * P2_DN[i] - c.pos[i];
+        int16_t gapR = c.pos[i + 1] - c.pos[i];
+        int16_t gapL = c.pos[i - 1] - c.pos[i];
+        if (!((d >= 1.0f && gapR > 1) || (d <= -1.0f && gapL < -1))) continue;
+
+        int8_t s = (d > 0) ? 1 : -1;
+        float nL = c.pos[i - 1], nI = c.pos[i], nR = c.pos[i + 1];
+        float qL = c.q[i - 1],   qI = c.q[i],   qR = c.q[i + 1];
+        float qp = qI + s / (nR - nL) *
+                   ((nI - nL + s) * (qR - qI) / (nR - nI) +
+                    (nR - nI - s) * (qI - qL) / (nI - nL));
+        if (!(qL < qp && qp < qR)) {                // parabol taştı → doğrusal
+            float nS = c.pos[i + s], qS = c.q[i + s];
+            qp = qI + s * (qS - qI) / (nS - nI);
+        }
+        c.q[i]    = (uint16_t)(qp + 0.5f);
+        c.pos[i] += s;
+    }
+}
+
+//--------------------------------------------------------------
+//  KAMUYA AÇIK
+//--------------------------------------------------------------
+void statsInit()
+{
+    uint8_t s = 0;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ++ch)
+        slotOf[ch] = (hasCurrentSensor(ch) && s < STATS_SLOTS) ? s++ : STATS_NO_SLOT;
+    statsReset();
+}
+
+void statsReset()
+{
+    memset(st, 0, sizeof(st));
+    tStart = millis();
+}
+
+void statsOnIrms(uint8_t ch, float amps)
+{
+    if (ch >= NUM_Y_CHANNELS || slotOf[ch] == STATS_NO_SLOT) return;
+    ChanStats& c = st[slotOf[ch]];
+    if (c.n >= STATS_N_MAX) return;                 // yayınlanamayan çok uzun pencere
+
+    uint16_t w = (uint16_t)(amps * STATS_MAINS_V + 0.5f);
+    p2Add(c, w);
+    c.sumW += w;
+    c.n++;
+    if (pinState[ch]) {
+        c.onN++;
+        if (w) c.actN++;
+    }
+}
+
+bool statsDue()
+{
+    return millis() - tStart >= (uint32_t)STATS_PERIOD_S * 1000UL;
+}
+
+uint32_t statsSeconds() { return (millis() - tStart) / 1000UL; }
+
+bool statsGet(uint8_t ch, StatsSummary& s)
+{
+    if (ch >= NUM_Y_CHANNELS || slotOf[ch] == STATS_NO_SLOT) return false;
+    const ChanStats& c = st[slotOf[ch]];
+    if (!c.n) return false;
+
+    uint8_t top = (c.n < 5) ? c.n - 1 : 4;
+    s.n      = c.n;
+    s.minW   = c.q[0];
+    s.maxW   = c.q[top];
+    s.meanW  = (c.sumW + c.n / 2) / c.n;
+    s.p95W   = (c.n < 5) ? c.q[top] : c.q[2];
+    s.duty   = (uint32_t)c.onN * 100 / c.n;
+    s.active = c.onN ? (uint32_t)c.actN * 100 / c.onN : 0;
+    return true;
+}
@@ -0,0 +1,25 @@
+/**
+ *  channel_stats.h
+ *  ---------------
+ *  – Sensörlü Y kanalı başına akan istatistik: min / max / ortalama W,
+ *    görev oranı (pinState ON süresi), ON iken akım çekme oranı ve
+ *    P² kestirimli p95 — kanal başına sabit 30 byte,
+ *  – Her Irms penceresinde (sampleCurrentSensors) artımlı güncellenir,
+ *  – STATS_PERIOD_S’de bir tek özet → <FLOOR_ID>/stats, sonra sıfırlanır.
+ */
+#pragma once
+#include <Arduino.h>
+
+struct StatsSummary {
+    uint16_t n;         // Irms penceresi (≈240 ms)
+    uint16_t minW, maxW, meanW, p95W;
+    uint8_t  duty;      // pinState ON süresi, %
+    uint8_t  active;    // ON iken akım çekilen süre, % (termostat çevrimi)
+};
+
+void     statsInit();
+void     statsOnIrms(uint8_t ch, float amps);  // kesmeler açıkken, taze Irms başına
+bool     statsDue();                           // STATS_PERIOD_S doldu mu?
+uint32_t statsSeconds();                       // bu pencerenin süresi (s)
+bool     statsGet(uint8_t ch, StatsSummary& s); // sensörsüz / boş kanal → false
+void     statsReset();                         // yeni pencere
@@ -88,6 +88,73 @@
 
 #define FAN_RESTORE_HYST      3       // Soğuyunca (°C) çıkışları geri aç
 
+/*********************************************************************
+ *  SIFIR GEÇİŞ ANAHTARLAMA (outputs.cpp)
+ *********************************************************************/
+
+#define ZC_STAGGER_HALFCYCLES 2       // Ardışık iki ON arası ZCD kenarı (50 Hz’de ≈10 ms/kenar)
+#define ZC_TIMEOUT_MS         50      // Bu kadar ZCD yoksa doğrudan yaz (şebeke algısı yok)
+
+/*********************************************************************
+ *  YÜK İMZASI (load_signature.cpp)
+ *********************************************************************/
+
+#ifndef CS_HARMONICS                  // platformio.ini: -DCS_HARMONICS=1
+#define CS_HARMONICS          0       // 1 → Goertzel 50/150/250 Hz, THD, anomali (~600 B RAM)
+#endif
+
+/*********************************************************************
+ *  GÜÇ BÜTÇESİ / YÜK ATMA (power_budget.cpp)
+ *********************************************************************/
+
+#define PB_BUDGET_W           3500    // EEPROM boşsa (16 A × 230 V ≈ 3680 W sigorta)
+#define PB_DEFAULT_PRIO       5       // sensörlü Y çıkışları; sensörsüzler 0 (atılmaz)
+#define PB_SHED_CYCLES        25      // aşım bu kadar şebeke periyodu sürerse at (50 Hz → 0.5 s)
+#define PB_RESTORE_HYST_W     300     // geri açmak için: toplam + yük + bu ≤ bütçe
+#define PB_RESTORE_MS         30000   // … ve bu kadar kesintisiz sürmeli
+
+/*********************************************************************
+ *  TELEMETRİ / İSTATİSTİK (channel_stats.cpp)
+ *********************************************************************/
+
+#define STATS_PERIOD_S        300     // <FLOOR_ID>/stats özet aralığı (en çok ≈4 saat)
+#ifndef TELEMETRY_FIXED               // platformio.ini: -DTELEMETRY_FIXED=0
+#define TELEMETRY_FIXED       1       // 0 → 10 s’lik W/Wh yayını kapalı; Y<n>/power
+#endif                                //     ve /energy özetle birlikte (ortalama W)
+
+/*********************************************************************
+ *  MQTT-SN / UDP TAŞIMA (mqtt_sn.cpp, tools/mqttsn_gw.py)
+ *********************************************************************/
+
+#ifndef MQTT_SN                       // platformio.ini: [env:megaatmega2560_sn]
+#define MQTT_SN               0       // 1 → TCP + PubSubClient yerine UDP, broker IP’sinde gateway
+#endif
+#define MQTT_SN_PORT          1885    // gateway UDP portu (mqttsn_gw.py --listen)
+#define SN_PACKET_MAX         256     // alınan en büyük datagram; rules/set hex’i ≤ ~120 B bytecode
+
+/*********************************************************************
+ *  DALGA BİÇİMİ YAKALAMA (wave_capture.cpp, tools/wave_plot.py)
+ *********************************************************************/
+
+#ifndef WAVE_CAPTURE                  // platformio.ini: -DWAVE_CAPTURE=0
+#define WAVE_CAPTURE          1       // 0 → <FLOOR_ID>/wave/set yok, tampon RAM’i geri gelir
+#endif
+#define WAVE_SAMPLES          320     // 10 bit paketli halka: 4 örnek / 5 byte → 400 B
+#define WAVE_CHUNK            80      // <FLOOR_ID>/diag/wave parçası başına veri (5’in katı)
+#define WAVE_CHUNK_MS         50      // parçalar arası en az süre (canlı trafik önce)
+#define WAVE_TRIG_TIMEOUT_MS  5000    // tetik gelmezse zorla yakala (osiloskop “auto”)
+#define WAVE_ZC_HYST          8       // sıfır geçişi: önce −8 LSB (≈0.4 A) altına inmeli
+
+/*********************************************************************
+ *  HOME ASSISTANT DISCOVERY (mqtt_haberlesme.cpp)
+ *********************************************************************/
+
+#define DISC_HASH_WAIT_MS     1500    // retained <FLOOR_ID>/discovery_hash gelmezse hepsini yayınla
+#define DISC_PER_LOOP         2       // mqttLoop() başına en çok bu kadar config
+#ifndef HA_DEVICE_DISCOVERY           // platformio.ini: -DHA_DEVICE_DISCOVERY=1
+#define HA_DEVICE_DISCOVERY   0       // 1 → tek homeassistant/device/<id>/config (HA ≥ 2024.11)
+#endif
+
 
 #endif // CONFIG_H
 
@@ -32,6 +32,11 @@
 #include <Arduino.h>
 #include "config.h"           // Y çıkış & sensör pinleri burada
 #include "current_sense.h"    // Bu modülün publik prototipleri
+#include "log.h"
+#include "load_signature.h"   // CS_HARMONICS: ISR’de Goertzel
+#include "power_budget.h"     // artımlı toplam güç
+#include "channel_stats.h"    // min / max / ortalama / p95 penceresi
+#include "wave_capture.h"     // WAVE_CAPTURE: ISR’de ham örnek yakalama
 
 volatile float Y_powerW [NUM_Y_CHANNELS] = {0};
 volatile float Y_energyWh[NUM_Y_CHANNELS] = {0};
@@ -82,15 +87,35 @@ inline uint8_t nextValidChannel(uint8_t ch) {
   return 0; // ulaşılmaz
 }
 
+// Dalga yakalaması tetiklenince yalnız maskedeki kanallar (maskede yalnız sensörlüler)
+inline uint8_t nextMaskChannel(uint8_t ch, uint16_t mask) {
+  for (uint8_t k = 0; k < NUM_Y_CHANNELS; k++) {
+    uint8_t idx = (ch + k) & 0x0F;
+    if (mask & (1U << idx)) return idx;
+  }
+  return 0; // ulaşılmaz
+}
+
 // ------ 5. Timer1 Kesmesi -------------------------------------------
 ISR(TIMER1_COMPA_vect) {
-  curChanISR = nextValidChannel(curChanISR);
+#if WAVE_CAPTURE
+  uint16_t wm = waveMask, ws = waveStep;
+#else
+  const uint16_t ws = 0;
+#endif
+  curChanISR = ws ? nextMaskChannel(curChanISR, ws) : nextValidChannel(curChanISR);
   uint8_t analogPin = pgm_read_byte(curMap + curChanISR);
 
   uint16_t raw = analogRead(analogPin);
   int32_t diff = (int32_t)raw - (int32_t)offsetADC[curChanISR];
   accSq[curChanISR]     += (uint32_t)(diff * diff);
   sampleCnt[curChanISR]++;
+#if WAVE_CAPTURE
+  if (wm & (1U << curChanISR)) waveSample(curChanISR, raw, (int16_t)diff);
+#endif
+#if CS_HARMONICS
+  if (!ws) lsSample(curChanISR, (int16_t)diff);   // tam hız yakalamada kanal başına hız değişir
+#endif
 
   curChanISR = (curChanISR + 1) & 0x0F;  // sıradaki kanal
 }
@@ -100,7 +125,7 @@ static void setupTimer1() {
   TCCR1A = 0;
   TCCR1B = 0;
   TCNT1  = 0;
-  OCR1A  = 499;            // 4 kHz
+  OCR1A  = F_CPU / 8 / CS_SAMPLE_HZ - 1;   // 16 MHz / 8 / 4 kHz − 1 = 499
   TCCR1B |= (1 << WGM12);  // CTC
   TCCR1B |= (1 << CS11);   // prescaler 8
   TIMSK1 |= (1 << OCIE1A); // interrupt enable
@@ -134,10 +159,12 @@ void initCurrentSense() {
     offsetADC[ch] = sum / CAL_SAMPLES;
   }
 
-  // >>> BURAYA DEBUG SATIRLARINI EKLE <<<
-    Serial.print(F("Offset Y0 raw = "));
-    Serial.println(offsetADC[0]);   // gerekirse diğer kanallar da
+  // Tüm ofsetler için seri konsolda "cal" komutu
+  LOG_I("Offset Y0 raw = %u", offsetADC[0]);
 
+#if CS_HARMONICS
+  lsInit();
+#endif
   setupTimer1();
 }
 
@@ -160,6 +187,9 @@ void cs_resumeADC() {
     cs_pause_depth--;
     if (cs_pause_depth == 0) {
       TIMSK1 |= (1 << OCIE1A);
+#if CS_HARMONICS
+      lsInvalidate();               // boşluklu örnek → yarım bloklar atılır
+#endif
     }
   }
   SREG = s;
@@ -168,6 +198,7 @@ void cs_resumeADC() {
 // 6.2. sampleCurrentSensors  (ana döngü => 10 ms'de bir çağrılmalı)
 void sampleCurrentSensors()
 {
+  uint16_t fresh = 0;             // bu turda Irms’i yenilenen kanallar
   noInterrupts();                 // Tutarlı okuma için ISR’i kısa süre durdur
   for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++)
   {
@@ -182,12 +213,18 @@ void sampleCurrentSensors()
         IrmsAmp = 0.0f;
 
       Y_current[ch]  = IrmsAmp;                         // Dışarıya sun
+      pbOnIrms(ch, IrmsAmp);                            // toplam += fark
+      fresh |= 1U << ch;
 
       accSq[ch]      = 0;                               // Yeni periyot için sıfırla
       sampleCnt[ch]  = 0;
     }
   }
   interrupts();
+
+  /* P² güncellemesi float ağırlıklı → kesmeler açıkken (Timer1 örnek kaçırmasın) */
+  for (uint8_t ch = 0; fresh; ch++, fresh >>= 1)
+    if (fresh & 1) statsOnIrms(ch, Y_current[ch]);
 }
 
 // 6.3. getIrms  🪄  (kolay erişim yardımcı fonksiyon)
@@ -197,6 +234,19 @@ float getIrms(uint8_t yIndex)
   return Y_current[yIndex];
 }
 
+// 6.4. Kalibrasyon bilgisi (seri konsol "cal" komutu)
+bool hasCurrentSensor(uint8_t ch)
+{
+  if (ch >= NUM_Y_CHANNELS) return false;
+  return pgm_read_byte(curMap + ch) != ANALOG_INVALID;
+}
+
+uint16_t getOffsetADC(uint8_t ch)
+{
+  if (ch >= NUM_Y_CHANNELS) return 0;
+  return offsetADC[ch];
+}
+
 
 /* -------------------------------------------------
  * energyTick(dtMs)
@@ -2,6 +2,7 @@
 #include <Arduino.h>
 
 #define NUM_Y_CHANNELS 16
+#define CS_SAMPLE_HZ   4000         // Timer1 ISR’i: her kesmede sıradaki kanaldan 1 örnek
 extern volatile float Y_current[NUM_Y_CHANNELS];   // Irms  (A)
 extern volatile float Y_powerW [NUM_Y_CHANNELS];   // P     (W)
 extern volatile float Y_energyWh[NUM_Y_CHANNELS];  // ∑Wh
@@ -12,6 +13,8 @@ void  energyTick(uint32_t dtMs);   // dt = ms  (ana döngüde 1 s)
 float getIrms (uint8_t ch);        // A
 float getPower(uint8_t ch);        // W
 float getEnergy(uint8_t ch);       // Wh
+bool     hasCurrentSensor(uint8_t ch); // Y3/Y7/Y11/Y15 → false
+uint16_t getOffsetADC(uint8_t ch);     // Boot kalibrasyon ofseti (ADC LSB)
 
 void cs_pauseADC();   // NTC okurken Timer1 Compare A kesmesini kapat
 void cs_resumeADC();  // NTC okuması biter bitmez tekrar aç
\ No newline at end of file
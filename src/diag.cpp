@@ -0,0 +1,320 @@
+/**
+ * diag.cpp — örneklemeli profil + watchdog ölüm kaydı
+ * ------------------------------------------------------------
+ *  › Sorun: 2 s watchdog (ör. reconnect() içinde bloklanınca) sessizce
+ *    reset atıyordu; kartın nerede takıldığına dair hiçbir iz kalmıyordu.
+ *
+ *  › PC yakalama (her iki kesmede aynı): kesme girişinde donanım 3 byte
+ *    dönüş adresini yığına itmiştir ([SP+1] = PC[21:16] … [SP+3] = PC[7:0],
+ *    kelime adresi). ISR_NAKED gövde yalnız r24/r30/r31’i kullanıp bu
+ *    byte’ları ve SP’yi diagCapPc / diagCapSp’ye kopyalar, sonra asıl işi
+ *    yapan “signal” fonksiyonuna jmp eder (o da reti ile döner).
+ *    Bayrak etkilenmez → SREG saklamaya gerek yok.
+ *
+ *  › Profil: Timer3 CTC, /64, OCR3A 250 → 996 Hz (Timer1’in 4 kHz’ine
+ *    katlı değil → örnekler kaymaz). Kesilen PC >> PROF_SHIFT ile
+ *    PROF_BUCKETS bölgeye, activeTask ile görev histogramına yazılır;
+ *    sayaç doyunca tüm histogram yarılanır (oranlar korunur).
+ *    Not: Timer1 ISR’i (≈120 µs) sürerken gelen örnek ISR bitince alınır
+ *    → ISR süresi, reti sonrası ilk komutun bölgesine yazılır.
+ *
+ *  › Watchdog: WDE + WDIE → ilk zaman aşımında önce WDT_vect çalışır.
+ *    Kayıt .noinit’e (açılışta sıfırlanmayan RAM) yazılır ve 15 ms’lik
+ *    WDT ile hemen reset atılır. Açılışta MCUSR .init3’te okunur
+ *    (WDRF silinmezse WDT açık kalır → reset döngüsü).
+ *    Güç kesilirse (PORF/BORF) .noinit çöp → kayıt geçersiz sayılır.
+ *    Kesmeler kapalıyken takılırsa WDT_vect çalışamaz; ikinci zaman
+ *    aşımı kayıtsız reset atar (n sayacı artmaz).
+ *
+ *  › RAM: .init1’de (SP kurulmadan, C çalışma ortamı yokken) _end‥RAMEND
+ *    arası DIAG_PAINT ile boyanır. _end .noinit’ten sonra → ölüm kaydı
+ *    bozulmaz. Boyası duran ilk byte yığının ulaştığı en derin nokta;
+ *    heap tepesiyle (__brkval) arası görülen en az boş RAM’dir.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <avr/wdt.h>
+#include "diag.h"
+#include "tanimlamalar.h"
+#include "telemetry_buffer.h"
+#include "log.h"
+
+//--------------------------------------------------------------
+//  PC YAKALAMA
+//--------------------------------------------------------------
+extern "C" {
+volatile uint8_t  diagCapPc[3];     // LE, kelime adresi
+volatile uint16_t diagCapSp;        // r30/r31 itildikten sonraki SP
+}
+
+#define DIAG_CAPTURE_AND_JMP(handler)           \
+    asm volatile(                               \
+        "push r30              \n\t"            \
+        "push r31              \n\t"            \
+        "in   r30, __SP_L__    \n\t"            \
+        "in   r31, __SP_H__    \n\t"            \
+        "sts  diagCapSp,   r30 \n\t"            \
+        "sts  diagCapSp+1, r31 \n\t"            \
+        "push r24              \n\t"            \
+        "ldd  r24, Z+3         \n\t"            \
+        "sts  diagCapPc+2, r24 \n\t"            \
+        "ldd  r24, Z+4         \n\t"            \
+        "sts  diagCapPc+1, r24 \n\t"            \
+        "ldd  r24, Z+5         \n\t"            \
+        "sts  diagCapPc,   r24 \n\t"            \
+        "pop  r24              \n\t"            \
+        "pop  r31              \n\t"            \
+        "pop  r30              \n\t"            \
+        "jmp  " handler "      \n\t")
+
+static inline uint32_t capturedPc()
+{
+    return diagCapPc[0] | ((uint16_t)diagCapPc[1] << 8) | ((uint32_t)diagCapPc[2] << 16);
+}
+
+//--------------------------------------------------------------
+//  GÖREV ADLARI  (konsol "stat" / "prof", diag/crash)
+//--------------------------------------------------------------
+static const char taskN0[] PROGMEM = "mqtt";
+static const char taskN1[] PROGMEM = "fan";
+static const char taskN2[] PROGMEM = "current";
+static const char taskN3[] PROGMEM = "energy";
+static const char taskN4[] PROGMEM = "publish";
+static const char taskN5[] PROGMEM = "rules";
+static const char taskN6[] PROGMEM = "other";
+static const char taskN7[] PROGMEM = "setup";
+static PGM_P const taskNames[TASK_SETUP + 1] PROGMEM = {
+    taskN0, taskN1, taskN2, taskN3, taskN4, taskN5, taskN6, taskN7
+};
+
+void diagTaskName(uint8_t t, char* buf, size_t n)
+{
+    if (t > TASK_SETUP) t = TASK_OTHER;
+    strncpy_P(buf, (PGM_P)pgm_read_ptr(&taskNames[t]), n);
+    buf[n - 1] = '\0';
+}
+
+//--------------------------------------------------------------
+//  PROFİL
+//--------------------------------------------------------------
+static volatile uint16_t hist[PROF_BUCKETS];
+static volatile uint16_t taskHist[TASK_SETUP + 1];
+static volatile uint8_t  recent[PROF_RECENT][3];
+static volatile uint8_t  recentHead = 0;
+static volatile uint32_t total      = 0;
+
+static void halveAll()
+{
+    for (uint8_t i = 0; i < PROF_BUCKETS; ++i)  hist[i]     >>= 1;
+    for (uint8_t i = 0; i <= TASK_SETUP; ++i)   taskHist[i] >>= 1;
+}
+
+extern "C" void __vector_prof_sample() __attribute__((signal, used, externally_visible));
+void __vector_prof_sample()
+{
+    uint32_t pc = capturedPc();
+    uint16_t b  = pc >> PROF_SHIFT;
+    if (b >= PROF_BUCKETS) b = PROF_BUCKETS - 1;          // son bölge: geri kalan her şey
+    if (++hist[b] == 0xFFFF) halveAll();
+
+    uint8_t t = activeTask;
+    if (t > TASK_SETUP) t = TASK_OTHER;
+    if (++taskHist[t] == 0xFFFF) halveAll();
+
+    uint8_t h = recentHead;
+    recent[h][0] = diagCapPc[0];
+    recent[h][1] = diagCapPc[1];
+    recent[h][2] = diagCapPc[2];
+    recentHead = (h + 1) % PROF_RECENT;
+    total++;
+}
+
+ISR(TIMER3_COMPA_vect, ISR_NAKED)
+{
+    DIAG_CAPTURE_AND_JMP("__vector_prof_sample");
+}
+
+void profStart()
+{
+    uint8_t s = SREG; cli();
+    TCCR3A = 0;
+    TCCR3B = _BV(WGM32) | _BV(CS31) | _BV(CS30);   // CTC, /64 → 250 kHz
+    OCR3A  = 250;                                  // 996 Hz
+    TCNT3  = 0;
+    TIFR3  = _BV(OCF3A);
+    TIMSK3 |= _BV(OCIE3A);
+    SREG = s;
+}
+
+void profStop()    { TIMSK3 &= ~_BV(OCIE3A); }
+bool profRunning() { return TIMSK3 & _BV(OCIE3A); }
+
+void profReset()
+{
+    uint8_t s = SREG; cli();
+    for (uint8_t i = 0; i < PROF_BUCKETS; ++i) hist[i] = 0;
+    for (uint8_t i = 0; i <= TASK_SETUP; ++i)  taskHist[i] = 0;
+    for (uint8_t i = 0; i < PROF_RECENT; ++i)  recent[i][0] = recent[i][1] = recent[i][2] = 0;
+    recentHead = 0;
+    total      = 0;
+    SREG = s;
+}
+
+uint32_t profTotal()
+{
+    uint8_t s = SREG; cli();
+    uint32_t n = total;
+    SREG = s;
+    return n;
+}
+
+uint16_t profBucket(uint8_t b)
+{
+    if (b >= PROF_BUCKETS) return 0;
+    uint8_t s = SREG; cli();
+    uint16_t n = hist[b];
+    SREG = s;
+    return n;
+}
+
+uint16_t profTaskHits(uint8_t t)
+{
+    if (t > TASK_SETUP) return 0;
+    uint8_t s = SREG; cli();
+    uint16_t n = taskHist[t];
+    SREG = s;
+    return n;
+}
+
+uint32_t profRecentPc(uint8_t i)
+{
+    if (i >= PROF_RECENT) return 0;
+    uint8_t s = SREG; cli();
+    uint8_t k = (recentHead + PROF_RECENT - 1 - i) % PROF_RECENT;
+    uint32_t pc = recent[k][0] | ((uint16_t)recent[k][1] << 8) | ((uint32_t)recent[k][2] << 16);
+    SREG = s;
+    return pc << 1;                                 // kelime → byte adresi
+}
+
+//--------------------------------------------------------------
+//  WATCHDOG ÖLÜM KAYDI
+//--------------------------------------------------------------
+#define CRASH_MAGIC 0xC0DE
+
+struct NoinitCrash {
+    uint16_t  magic;
+    CrashInfo ci;
+    uint8_t   sum;
+};
+
+static NoinitCrash nc        __attribute__((section(".noinit")));
+static uint8_t     mcusrCopy __attribute__((section(".noinit")));
+
+static uint8_t crashSum()
+{
+    const uint8_t* p = (const uint8_t*)&nc.ci;
+    uint8_t s = 0x5A;
+    for (uint8_t i = 0; i < sizeof(nc.ci); ++i) s = (s << 1 | s >> 7) ^ p[i];
+    return s;
+}
+
+static bool crashValid() { return nc.magic == CRASH_MAGIC && nc.sum == crashSum(); }
+
+/* Arduino çekirdeğinden ve C++ kurucularından önce (.init3) */
+extern "C" void diagEarly() __attribute__((naked, used, section(".init3")));
+void diagEarly()
+{
+    mcusrCopy = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+extern "C" void __vector_wdt_dump() __attribute__((signal, used, externally_visible));
+void __vector_wdt_dump()
+{
+    uint8_t n = crashValid() ? nc.ci.count : 0;    // yayınlanmamış önceki kayıt
+
+    nc.ci.pc     = capturedPc() << 1;
+    nc.ci.sp     = diagCapSp + 5;                   // r30, r31 + 3 byte PC
+    nc.ci.task   = activeTask;
+    nc.ci.uptime = tbUptime();
+    nc.ci.count  = (n < 255) ? n + 1 : 255;
+    nc.magic     = CRASH_MAGIC;
+    nc.sum       = crashSum();
+
+    wdt_enable(WDTO_15MS);                          // ikinci zaman aşımını bekleme
+    for (;;) {}
+}
+
+ISR(WDT_vect, ISR_NAKED)
+{
+    DIAG_CAPTURE_AND_JMP("__vector_wdt_dump");
+}
+
+void diagInit()
+{
+    if (mcusrCopy & (_BV(PORF) | _BV(BORF))) nc.magic = 0;   // .noinit çöp
+
+    if (crashValid())
+        LOG_W("WDT reset x%u: pc=0x%05lx gorev=%u sp=0x%04x",
+              nc.ci.count, (unsigned long)nc.ci.pc, nc.ci.task, nc.ci.sp);
+}
+
+void diagWatchdogEnable()
+{
+    uint8_t s = SREG; cli();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | _BV(WDE) | _BV(WDP2) | _BV(WDP1) | _BV(WDP0);   // 2 s, kesme + reset
+    SREG = s;
+}
+
+bool diagCrashPending(CrashInfo& ci)
+{
+    if (!crashValid()) return false;
+    ci = nc.ci;
+    return true;
+}
+
+void diagCrashClear() { nc.magic = 0; }
+
+//--------------------------------------------------------------
+//  RAM  (yığın boyama)
+//--------------------------------------------------------------
+#define DIAG_PAINT 0xC5
+
+extern uint8_t _end;                // .bss + .noinit sonu (= __heap_start)
+extern char*   __brkval;            // malloc tepesi; 0 → hiç ayrılmadı
+
+extern "C" void diagPaint() __attribute__((naked, used, section(".init1")));
+void diagPaint()
+{
+    asm volatile(
+        "ldi  r30, lo8(_end)        \n\t"
+        "ldi  r31, hi8(_end)        \n\t"
+        "ldi  r24, %0               \n\t"
+        "ldi  r25, hi8(%1)          \n\t"
+        "1:                         \n\t"
+        "st   Z+, r24               \n\t"
+        "cpi  r30, lo8(%1)          \n\t"
+        "cpc  r31, r25              \n\t"
+        "brlo 1b                    \n\t"
+        :: "M"(DIAG_PAINT), "i"(RAMEND));
+}
+
+static inline uint16_t heapTop()
+{
+    return __brkval ? (uintptr_t)__brkval : (uintptr_t)&_end;
+}
+
+static uint16_t deepestStack()      // boyası bozulmuş ilk adres
+{
+    uint16_t a = heapTop();
+    while (a < RAMEND && *(const uint8_t*)(uintptr_t)a == DIAG_PAINT) ++a;
+    return a;
+}
+
+uint16_t diagFreeRam()      { return SP - heapTop(); }
+uint16_t diagMinFreeRam()   { return deepestStack() - heapTop(); }
+uint16_t diagStackMax()     { return RAMEND - deepestStack(); }
+uint16_t diagHeapUsed()     { return heapTop() - (uintptr_t)&_end; }
@@ -0,0 +1,47 @@
+/**
+ *  diag.h
+ *  ------
+ *  – Örneklemeli profil çıkarıcı: Timer3 ≈1 kHz, kesilen PC → flash bölge
+ *    histogramı + görev (activeTask) histogramı + son PC’ler,
+ *  – Watchdog “önce kesme, sonra reset” modu: takıldığı PC, görev ve SP
+ *    .noinit’e yazılır, açılışta okunur → <FLOOR_ID>/diag/crash,
+ *  – Açılışta boyanan RAM’den yığın tavanı / en az boş RAM
+ *    → <FLOOR_ID>/diag/ram,
+ *  – Adres → fonksiyon: tools/pc2sym.py, RAM dökümü: tools/ram_report.py
+ */
+#pragma once
+#include <Arduino.h>
+
+#define PROF_BUCKETS     64         // histogram bölgesi
+#define PROF_SHIFT       10         // kelime adresi >> 10 → 2 KB flash bölgesi
+#define PROF_RECENT      8          // ham PC halkası
+
+struct CrashInfo {
+    uint32_t pc;        // byte adresi (ELF ile aynı)
+    uint16_t sp;        // kesme anındaki yığın işaretçisi
+    uint8_t  task;      // activeTask (TASK_OTHER / TASK_SETUP dahil)
+    uint32_t uptime;    // s
+    uint8_t  count;     // üst üste kaç WDT reseti
+};
+
+void diagInit();                    // setup()’ın başında (MCUSR, .noinit)
+void diagWatchdogEnable();          // wdt_enable(WDTO_2S) yerine: kesme + reset
+
+bool diagCrashPending(CrashInfo& ci);
+void diagCrashClear();              // yayınlandı → bir daha gönderme
+
+void     profStart();
+void     profStop();
+void     profReset();
+bool     profRunning();
+uint32_t profTotal();
+uint16_t profBucket(uint8_t b);     // b. bölgedeki örnek
+uint16_t profTaskHits(uint8_t t);   // 0‥TASK_SETUP
+uint32_t profRecentPc(uint8_t i);   // i = 0 en yeni, byte adresi; 0 → yok
+
+void diagTaskName(uint8_t t, char* buf, size_t n);
+
+uint16_t diagFreeRam();             // şu an: SP − heap tepesi
+uint16_t diagMinFreeRam();          // açılıştan beri en az (boyadan)
+uint16_t diagStackMax();            // açılıştan beri en derin yığın (byte)
+uint16_t diagHeapUsed();            // __heap_start‥__brkval
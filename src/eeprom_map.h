@@ -0,0 +1,19 @@
+/**
+ *  eeprom_map.h
+ *  ------------
+ *  Mega 2560: 4 KB EEPROM. Her alt sistem kendi bölgesini burada alır;
+ *  bölge başında sürüm/sihirli byte tutulur, düzen değişirse artırılır.
+ */
+#pragma once
+
+#define EE_SCENES_ADDR     0        // scenes.cpp   (8 × 21 byte)
+#define EE_SCENES_SIZE     256
+
+#define EE_RULES_ADDR      256      // rules.cpp    (başlık + bytecode)
+#define EE_RULES_SIZE      256
+
+#define EE_ALERTS_ADDR     512      // telemetry_buffer.cpp (çevrimdışı uyarılar)
+#define EE_ALERTS_SIZE     80
+
+#define EE_POWER_ADDR      592      // power_budget.cpp (bütçe + öncelikler)
+#define EE_POWER_SIZE      32
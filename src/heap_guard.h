@@ -0,0 +1,31 @@
+/**
+ *  heap_guard.h
+ *  ------------
+ *  – Yalnız [env:megaatmega2560_noheap]: src/ içindeki her .cpp’nin başına
+ *    “-include heap_guard.h” ile eklenir (kütüphanelere değil),
+ *  – Projenin kullandığı sistem / kütüphane başlıkları önce açılır,
+ *    ardından heap ayıran isimler zehirlenir → src/ içinde malloc,
+ *    String, strdup … yazmak derleme hatası verir,
+ *  – Bilinen tek istisna: PubSubClient kurucusu paket tamponunu
+ *    (MQTT_MAX_PACKET_SIZE) açılışta bir kez malloc’lar; kütüphane
+ *    içinde kaldığı için zehirden etkilenmez, diag/ram “heap”inde görünür
+ *    (MQTT_SN derlemesinde PubSubClient yok → heap 0 olmalı).
+ */
+#pragma once
+#if HEAP_FREE
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/wdt.h>
+#include <EEPROM.h>
+#include <UIPEthernet.h>
+#if !MQTT_SN
+#include <PubSubClient.h>
+#endif
+#include <ArduinoJson.h>
+
+#pragma GCC poison malloc calloc realloc free strdup String
+
+#endif
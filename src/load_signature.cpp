@@ -0,0 +1,281 @@
+/**
+ * load_signature.cpp — kanal başına harmonik / yük imzası analizi
+ * ------------------------------------------------------------
+ *  › Sorun: Irms tek başına “motor zorlanıyor” ya da “ısıtıcı teli yarı
+ *    kopuk” ayrımını yapamıyor; ISR dalga şeklini görüp yalnız accSq’yi
+ *    tutuyordu.
+ *  › Örnekleme: Timer1 4 kHz, 12 sensörlü kanal sırayla → kanal başına
+ *    fs = 333.3 Hz (Nyquist 166.7 Hz). LS_BLOCK = 80 örnek = 240 ms
+ *    = 12 şebeke periyodu; üç frekans da tam bin’e düşer (sızıntı yok):
+ *        50 Hz  → k = 12
+ *       150 Hz  → k = 36
+ *       250 Hz  → 333.3 − 250 = 83.3 Hz’e katlanır → k = 20
+ *    ACS712 önünde kenar yumuşatma filtresi yok; 7. ve üstü harmonikler
+ *    de başka bin’lere katlanır, THD burada yalnız 3. + 5. harmoniktir.
+ *  › ISR (lsSample): her örnekte üç Goertzel adımı, Q12 katsayı, int32
+ *    durum (80 örnekte en kötü |s| ≈ 66k → çarpım 2^31’in altında).
+ *    Blok bitince durum tek yuvalı posta kutusuna kopyalanır; kutu
+ *    doluysa blok atılır ve sayılır. Kanalların blok sınırları
+ *    başlangıçta kaydırılmıştır → ≈20 ms’de bir blok biter.
+ *  › loop (lsService): |X|², I1 (RMS), r3 = H3/H1, r5 = H5/H1, THD ve
+ *    sınıf. Çıkış açıkken LS_LEARN_BLOCKS blokta taban öğrenilir
+ *    (sonra yavaş EWMA). LS_STREAK_BLOCKS ardışık blok sapma → anomali,
+ *    aynı sayıda normal blok → temizlenir. Yük gerçekten değiştiyse
+ *    LS_RELEARN_BLOCKS sonra taban yeniden öğrenilir.
+ *  › NTC okuması (cs_pauseADC) örnek akışını keser → o anki bloklar
+ *    lsInvalidate() ile atılır.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "config.h"
+
+#if CS_HARMONICS
+
+#include "load_signature.h"
+#include "current_sense.h"
+#include "tanimlamalar.h"
+#include "log.h"
+
+//--------------------------------------------------------------
+//  KONFİG
+//--------------------------------------------------------------
+#define LS_SLOTS           12          // sensörlü kanal (Y3/Y7/Y11/Y15 yok)
+#define LS_BLOCK           80          // örnek / blok
+#define LS_Q               12          // katsayı kesir biti
+#define LS_C1              4815        // round(4096 · 2cos(2π·12/80))
+#define LS_C3            (-7791)       // round(4096 · 2cos(2π·36/80))
+                                       // k = 20 → 2cos(π/2) = 0
+
+#define LS_MIN_I1_CA       50          // 0.50 A altı → OFF (Irms ölü bölgesi)
+#define LS_LEARN_BLOCKS    32          // ≈ 8 s açık kalma
+#define LS_STREAK_BLOCKS   8           // ≈ 2 s
+#define LS_RELEARN_BLOCKS  1200        // ≈ 5 dk süren sapma → yeni yük
+#define LS_EWMA            (1.0f / 64)
+#define LS_I1_TOL          0.30f       // I1 tabandan ±%30
+#define LS_HARM_TOL        10.0f       // r3 / r5 tabandan ±10 puan
+#define LS_THD_RESISTIVE   8           // % altı → rezistif
+#define LS_THD_ELECTRONIC  30          // % üstü → elektronik
+#define LS_THD_REPORT      2           // bu kadar değişmezse yayın yok
+
+static const float ADC_TO_AMP = (5.0f / 1023.0f) / 0.100f;   // current_sense.cpp ile aynı
+
+/* ch → yuva: her 4 kanaldan sonuncusu sensörsüz */
+static inline uint8_t slotOf(uint8_t ch) { return ch - (ch >> 2); }
+static inline uint8_t chOf(uint8_t s)    { return s + s / 3; }
+
+//--------------------------------------------------------------
+//  ISR TARAFI
+//--------------------------------------------------------------
+struct Goertzel {
+    int32_t a[3];       // s[n-1]
+    int32_t b[3];       // s[n-2]
+    uint8_t n;
+};
+
+static Goertzel          gz[LS_SLOTS];
+static volatile uint16_t skipMask = 0;            // bit → bu yuvanın bloğu geçersiz
+
+static volatile bool     mbFull = false;          // posta kutusu
+static volatile uint8_t  mbSlot;
+static volatile int32_t  mbA[3], mbB[3];
+static volatile uint16_t mbLost = 0;
+
+void lsSample(uint8_t ch, int16_t x)
+{
+    uint8_t   s = slotOf(ch);
+    Goertzel& g = gz[s];
+    int32_t   t;
+
+    t = x + (((int32_t)LS_C1 * g.a[0]) >> LS_Q) - g.b[0];  g.b[0] = g.a[0];  g.a[0] = t;
+    t = x + (((int32_t)LS_C3 * g.a[1]) >> LS_Q) - g.b[1];  g.b[1] = g.a[1];  g.a[1] = t;
+    t = x - g.b[2];                                        g.b[2] = g.a[2];  g.a[2] = t;
+
+    if (++g.n < LS_BLOCK) return;
+    g.n = 0;
+
+    if (skipMask & (1u << s)) {
+        skipMask &= ~(1u << s);
+    } else if (!mbFull) {
+        for (uint8_t k = 0; k < 3; ++k) { mbA[k] = g.a[k]; mbB[k] = g.b[k]; }
+        mbSlot = s;
+        mbFull = true;
+    } else {
+        mbLost++;
+    }
+    for (uint8_t k = 0; k < 3; ++k) g.a[k] = g.b[k] = 0;
+}
+
+/* cs_resumeADC() içinden, kesmeler kapalıyken */
+void lsInvalidate() { skipMask = (1u << LS_SLOTS) - 1; }
+
+//--------------------------------------------------------------
+//  ANA DÖNGÜ TARAFI
+//--------------------------------------------------------------
+struct LsChan {
+    uint16_t i1;            // 0.01 A
+    uint8_t  r3, r5, thd;   // %
+    uint8_t  cls;           // LsClass
+    uint8_t  anom;          // LsAnomaly (onaylanmış)
+    uint8_t  cand;          // aday durum
+    uint8_t  streak;        // adayın ardışık blok sayısı
+    uint8_t  learn;         // öğrenilen blok (LS_LEARN_BLOCKS’ta doyar)
+    uint16_t stuck;         // DRIFT süresi (blok)
+    float    bI1, bR3, bR5; // taban (A, %, %)
+    uint8_t  pubThd, pubCls, pubAnom;
+};
+
+static LsChan   chan[LS_SLOTS];
+static uint16_t dirtyMask = 0;
+
+/* Blok sınırlarını kaydır + ilk (kısa) blokları at — Timer1 açılmadan */
+void lsInit()
+{
+    for (uint8_t s = 0; s < LS_SLOTS; ++s) {
+        memset(&gz[s], 0, sizeof(gz[s]));
+        gz[s].n = s * (LS_BLOCK / LS_SLOTS);
+    }
+    memset(chan, 0, sizeof(chan));
+    skipMask = (1u << LS_SLOTS) - 1;
+    mbFull   = false;
+}
+
+static float magnitude(int32_t a, int32_t b, float c)
+{
+    float fa = a, fb = b;
+    float m2 = fa * fa + fb * fb - c * fa * fb;
+    return (m2 > 0.0f) ? sqrtf(m2) * (2.0f / LS_BLOCK) : 0.0f;    // tepe genliği (LSB)
+}
+
+static uint8_t pct(float v) { return (v > 255.0f) ? 255 : (uint8_t)(v + 0.5f); }
+
+static uint8_t classify(const LsChan& c)
+{
+    if (c.i1 < LS_MIN_I1_CA)                              return LS_OFF;
+    if (c.thd < LS_THD_RESISTIVE)                         return LS_RESISTIVE;
+    if (c.thd >= LS_THD_ELECTRONIC || c.r3 >= LS_THD_ELECTRONIC) return LS_ELECTRONIC;
+    return LS_INDUCTIVE;
+}
+
+static void update(uint8_t s, const float* amp)
+{
+    LsChan& c  = chan[s];
+    uint8_t ch = chOf(s);
+
+    float i1 = amp[0] * ADC_TO_AMP * 0.70710678f;                   // tepe → RMS
+    c.i1 = (i1 * 100.0f > 65535.0f) ? 65535 : (uint16_t)(i1 * 100.0f + 0.5f);
+    if (c.i1 >= LS_MIN_I1_CA) {
+        float r3 = 100.0f * amp[1] / amp[0];
+        float r5 = 100.0f * amp[2] / amp[0];
+        c.r3  = pct(r3);
+        c.r5  = pct(r5);
+        c.thd = pct(sqrtf(r3 * r3 + r5 * r5));
+    } else {
+        c.r3 = c.r5 = c.thd = 0;
+    }
+    c.cls = classify(c);
+
+    /* ---- tabana göre durum ---- */
+    bool    learned = c.learn >= LS_LEARN_BLOCKS;
+    uint8_t why     = LS_NORMAL;
+    if (learned) {
+        if (c.cls == LS_OFF)
+            why = pinState[ch] ? LS_OPEN : LS_NORMAL;
+        else if (fabsf(i1 - c.bI1) > c.bI1 * LS_I1_TOL ||
+                 fabsf(c.r3 - c.bR3) > LS_HARM_TOL ||
+                 fabsf(c.r5 - c.bR5) > LS_HARM_TOL)
+            why = LS_DRIFT;
+    }
+
+    if (why == c.anom) {
+        c.streak = 0;
+    } else {
+        if (why != c.cand) { c.cand = why; c.streak = 0; }
+        if (++c.streak >= LS_STREAK_BLOCKS) {
+            c.anom   = why;
+            c.streak = 0;
+            c.stuck  = 0;
+            if (why == LS_NORMAL) LOG_I("Y%u yuk imzasi normal", ch);
+            else LOG_W("Y%u yuk anomalisi (%S) I1=%u taban=%u cA", ch,
+                       why == LS_OPEN ? PSTR("acik devre") : PSTR("sapma"),
+                       c.i1, (uint16_t)(c.bI1 * 100.0f));
+        }
+    }
+
+    /* ---- taban öğrenme ---- */
+    if (c.cls != LS_OFF && why == LS_NORMAL && c.anom == LS_NORMAL) {
+        float k = learned ? LS_EWMA : 1.0f / (c.learn + 1);       // önce düz ortalama
+        c.bI1 += k * (i1   - c.bI1);
+        c.bR3 += k * (c.r3 - c.bR3);
+        c.bR5 += k * (c.r5 - c.bR5);
+        if (!learned) c.learn++;
+    }
+    if (c.anom == LS_DRIFT && ++c.stuck >= LS_RELEARN_BLOCKS) {
+        LOG_I("Y%u yeni yuk, taban yeniden ogreniliyor", ch);
+        c.learn = 0;
+        c.anom  = c.cand = LS_NORMAL;
+        c.stuck = 0;
+    }
+
+    /* ---- yayın gerekli mi ---- */
+    int8_t dThd = (int8_t)(c.thd - c.pubThd);
+    if (c.cls != c.pubCls || c.anom != c.pubAnom ||
+        dThd >= LS_THD_REPORT || dThd <= -LS_THD_REPORT)
+        dirtyMask |= 1u << s;
+}
+
+//--------------------------------------------------------------
+//  KAMUYA AÇIK
+//--------------------------------------------------------------
+void lsService()
+{
+    if (!mbFull) return;
+
+    uint8_t s = mbSlot;
+    float amp[3];
+    amp[0] = magnitude(mbA[0], mbB[0], LS_C1 / 4096.0f);
+    amp[1] = magnitude(mbA[1], mbB[1], LS_C3 / 4096.0f);
+    amp[2] = magnitude(mbA[2], mbB[2], 0.0f);
+    mbFull = false;                          // ISR kutuyu yeniden doldurabilir
+
+    update(s, amp);
+}
+
+static inline bool sensed(uint8_t ch) { return ch < NUM_Y_CHANNELS && (ch & 3) != 3; }
+
+uint16_t lsFundamentalCA(uint8_t ch) { return sensed(ch) ? chan[slotOf(ch)].i1  : 0; }
+uint8_t  lsThd(uint8_t ch)           { return sensed(ch) ? chan[slotOf(ch)].thd : 0; }
+uint8_t  lsClass(uint8_t ch)         { return sensed(ch) ? chan[slotOf(ch)].cls  : (uint8_t)LS_OFF; }
+uint8_t  lsAnomaly(uint8_t ch)       { return sensed(ch) ? chan[slotOf(ch)].anom : (uint8_t)LS_NORMAL; }
+uint16_t lsLostBlocks()              { uint16_t n; noInterrupts(); n = mbLost; interrupts(); return n; }
+
+uint8_t lsRatio(uint8_t ch, uint8_t h)
+{
+    if (!sensed(ch)) return 0;
+    return (h == 3) ? chan[slotOf(ch)].r3 : chan[slotOf(ch)].r5;
+}
+
+uint16_t lsBaselineCA(uint8_t ch)
+{
+    if (!sensed(ch)) return 0;
+    const LsChan& c = chan[slotOf(ch)];
+    return (c.learn >= LS_LEARN_BLOCKS) ? (uint16_t)(c.bI1 * 100.0f + 0.5f) : 0;
+}
+
+int8_t lsTakeDirty()
+{
+    for (uint8_t s = 0; s < LS_SLOTS; ++s) {
+        if (!(dirtyMask & (1u << s))) continue;
+        dirtyMask &= ~(1u << s);
+        LsChan& c = chan[s];
+        c.pubThd  = c.thd;
+        c.pubCls  = c.cls;
+        c.pubAnom = c.anom;
+        return chOf(s);
+    }
+    return -1;
+}
+
+void lsMarkAllDirty() { dirtyMask = (1u << LS_SLOTS) - 1; }
+
+
+#endif // CS_HARMONICS
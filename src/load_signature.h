@@ -0,0 +1,47 @@
+/**
+ *  load_signature.h
+ *  ----------------
+ *  – Akım dalga şeklinden kanal başına harmonik analiz (CS_HARMONICS),
+ *  – Timer1 ISR’inde her örnekte sabit noktalı Goertzel (tampon yok),
+ *  – Temel bileşen, THD, yük sınıfı ve öğrenilmiş tabandan sapma uyarısı.
+ *
+ *  MQTT:  <FLOOR_ID>/Y4/thd      "12"          (%)
+ *         <FLOOR_ID>/Y4/load     "inductive"
+ *         <FLOOR_ID>/Y4/anomaly  {"state":"ON","why":"drift",…}
+ */
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+enum LsClass : uint8_t {
+    LS_OFF = 0,         // temel bileşen LS_MIN_I1_CA altında
+    LS_RESISTIVE,       // ısıtıcı, akkor lamba
+    LS_INDUCTIVE,       // motor, trafo, balast
+    LS_ELECTRONIC       // SMPS, LED sürücü, doğrultuculu yük
+};
+
+enum LsAnomaly : uint8_t {
+    LS_NORMAL = 0,
+    LS_DRIFT,           // I1 / harmonik oranları tabandan saptı
+    LS_OPEN             // çıkış ON ama akım yok (kopuk eleman, sigorta)
+};
+
+#if CS_HARMONICS
+
+void     lsInit();                          // initCurrentSense(), Timer1’den önce
+void     lsSample(uint8_t ch, int16_t x);   // yalnız ISR(TIMER1_COMPA_vect)
+void     lsInvalidate();                    // örnek akışı kesildi (cs_resumeADC)
+void     lsService();                       // loop(): biten bloğu işle
+
+uint16_t lsFundamentalCA(uint8_t ch);       // 50 Hz RMS, 0.01 A
+uint8_t  lsThd(uint8_t ch);                 // %, 3. + 5. harmonik
+uint8_t  lsRatio(uint8_t ch, uint8_t h);    // h = 3 | 5 → % (temel bileşene göre)
+uint8_t  lsClass(uint8_t ch);               // LsClass
+uint8_t  lsAnomaly(uint8_t ch);             // LsAnomaly
+uint16_t lsBaselineCA(uint8_t ch);          // öğrenilmiş I1, 0 → henüz yok
+uint16_t lsLostBlocks();                    // posta kutusu doluyken atılan blok
+
+int8_t   lsTakeDirty();                     // yayınlanacak sıradaki kanal, yoksa -1
+void     lsMarkAllDirty();                  // yeniden bağlanınca hepsini yayınla
+
+#endif
@@ -0,0 +1,214 @@
+/**
+ * log.cpp — halka tamponlu, bloklamayan log
+ * ------------------------------------------------------------
+ *  › Sorun: 9600 baud'da her karakter ≈1 ms; 64 byte'lık TX tamponu
+ *    dolunca Serial.print() döngüyü onlarca ms bekletiyordu.
+ *  › Çözüm:
+ *    – logWrite_P() kaydı önce küçük bir yığın tamponunda hazırlar,
+ *      halkada yer varsa TEK PARÇA kopyalar, yoksa atar ve sayar.
+ *    – logService() her turda yalnız TX tamponundaki boş yer kadar
+ *      byte yollar (Serial.availableForWrite()) → hiç beklemez.
+ *    – Halkadaki her kayıt [uzunluk][byte…] olarak tutulur; uzunluk
+ *      byte'ı porta gitmez, yalnız kayıt sınırını bilmek için.
+ *      Böylece konsol (serial_console.cpp) logIdle() ile yarım kalmış
+ *      bir log satırının ortasına yazmaz.
+ *
+ *  Kayıt biçimleri
+ *    Metin (LOG_BINARY 0):  "[I 12345] mesaj\r\n"
+ *    İkili (LOG_BINARY 1):  A5 | len | lvl | fmt(2, LE) | ms(4, LE) | arg…
+ *      – fmt  : flash'taki format dizgisinin adresi (ELF'ten çözülür)
+ *      – arg  : formattaki sırayla; %d/%u/%x/%c → 2 byte, %l… → 4 byte,
+ *               %s/%S → '\0' ile biten dizgi (en çok LOG_STR_MAX)
+ *      – fmt == 0 → “N kayıt atıldı” bildirimi, arg: uint16
+ *    Çözümleyici: tools/log_decode.py
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "log.h"
+
+//--------------------------------------------------------------
+//  KONFİG
+//--------------------------------------------------------------
+#define LOG_REC_MAX   72        // tek kaydın en fazla boyu (byte)
+#define LOG_STR_MAX   16        // ikili kayıtta %s başına en fazla karakter
+#define LOG_SYNC      0xA5      // ikili kayıt başlangıcı
+
+//--------------------------------------------------------------
+//  HALKA TAMPON
+//--------------------------------------------------------------
+static uint8_t  ring[LOG_RING_SIZE];
+static uint16_t rHead = 0;          // yazma
+static uint16_t rTail = 0;          // okuma
+static uint16_t rUsed = 0;
+
+static uint8_t  sendLeft   = 0;     // porta gidiyor olan kaydın kalan byte'ı
+static uint16_t dropCount  = 0;     // toplam atılan
+static uint16_t dropNoted  = 0;     // en son bildirilen atılan sayısı
+
+static inline void ringPut(uint8_t b)
+{
+    ring[rHead] = b;
+    if (++rHead == LOG_RING_SIZE) rHead = 0;
+}
+
+static inline uint8_t ringGet()
+{
+    uint8_t b = ring[rTail];
+    if (++rTail == LOG_RING_SIZE) rTail = 0;
+    return b;
+}
+
+/** Kaydı tek parça halkaya koy; yer yoksa false */
+static bool ringPush(const uint8_t* rec, uint8_t len)
+{
+    if (len == 0) return true;
+    if ((uint16_t)(LOG_RING_SIZE - rUsed) < (uint16_t)len + 1) return false;
+
+    ringPut(len);
+    for (uint8_t i = 0; i < len; ++i) ringPut(rec[i]);
+    rUsed += len + 1;
+    return true;
+}
+
+//--------------------------------------------------------------
+//  KAYIT HAZIRLAMA
+//--------------------------------------------------------------
+#if LOG_BINARY
+
+static uint8_t binHeader(uint8_t* rec, uint8_t level, uint16_t fmt)
+{
+    uint32_t t = millis();
+    rec[0] = LOG_SYNC;
+    rec[1] = 0;                         // uzunluk sonra yazılır
+    rec[2] = level;
+    rec[3] = fmt & 0xFF;  rec[4] = fmt >> 8;
+    rec[5] = t;  rec[6] = t >> 8;  rec[7] = t >> 16;  rec[8] = t >> 24;
+    return 9;
+}
+
+/** Formatı yürü, argümanları ham byte olarak ekle */
+static uint8_t buildRecord(uint8_t* rec, uint8_t level, PGM_P fmt, va_list ap)
+{
+    uint8_t n = binHeader(rec, level, (uint16_t)(uintptr_t)fmt);
+
+    for (PGM_P p = fmt; ; ) {
+        char c = pgm_read_byte(p++);
+        if (c == '\0') break;
+        if (c != '%') continue;
+
+        c = pgm_read_byte(p++);
+        while (c == '-' || c == '+' || c == ' ' || c == '#' || c == '0' ||
+               c == '.' || (c >= '1' && c <= '9'))
+            c = pgm_read_byte(p++);
+
+        bool isLong = false;
+        if (c == 'l') { isLong = true; c = pgm_read_byte(p++); }
+
+        if (c == '%' || c == '\0') { if (c == '\0') break; continue; }
+
+        if (c == 's' || c == 'S') {
+            const char* s = va_arg(ap, const char*);
+            for (uint8_t k = 0; k < LOG_STR_MAX && n < LOG_REC_MAX - 1; ++k) {
+                char ch = (c == 'S') ? pgm_read_byte(s + k) : s[k];
+                if (ch == '\0') break;
+                rec[n++] = ch;
+            }
+            rec[n++] = '\0';
+        }
+        else if (isLong) {
+            if (n + 4 > LOG_REC_MAX) break;
+            uint32_t v = va_arg(ap, uint32_t);
+            rec[n++] = v;  rec[n++] = v >> 8;  rec[n++] = v >> 16;  rec[n++] = v >> 24;
+        }
+        else {
+            if (n + 2 > LOG_REC_MAX) break;
+            uint16_t v = (uint16_t)va_arg(ap, int);
+            rec[n++] = v;  rec[n++] = v >> 8;
+        }
+    }
+    rec[1] = n - 2;
+    return n;
+}
+
+static uint8_t buildDropNote(uint8_t* rec, uint16_t cnt)
+{
+    uint8_t n = binHeader(rec, LOG_LVL_WARN, 0);
+    rec[n++] = cnt;  rec[n++] = cnt >> 8;
+    rec[1] = n - 2;
+    return n;
+}
+
+#else   // ---- metin kayıt ----
+
+static const char lvlChar[] PROGMEM = "-EWID";
+
+static uint8_t buildRecord(uint8_t* rec, uint8_t level, PGM_P fmt, va_list ap)
+{
+    char* out = (char*)rec;
+    int n = snprintf_P(out, LOG_REC_MAX, PSTR("[%c %lu] "),
+                       pgm_read_byte(lvlChar + level), (unsigned long)millis());
+    n += vsnprintf_P(out + n, LOG_REC_MAX - 2 - n, fmt, ap);
+    if (n > LOG_REC_MAX - 3) n = LOG_REC_MAX - 3;     // kırpıldı
+    out[n++] = '\r';
+    out[n++] = '\n';
+    return n;
+}
+
+static uint8_t buildDropNote(uint8_t* rec, uint16_t cnt)
+{
+    return snprintf_P((char*)rec, LOG_REC_MAX,
+                      PSTR("[W %lu] log: %u kayit atildi\r\n"),
+                      (unsigned long)millis(), cnt);
+}
+
+#endif
+
+//--------------------------------------------------------------
+//  KAMUYA AÇIK
+//--------------------------------------------------------------
+void logInit()
+{
+    rHead = rTail = rUsed = 0;
+    sendLeft  = 0;
+    dropCount = dropNoted = 0;
+}
+
+void logWrite_P(uint8_t level, PGM_P fmt, ...)
+{
+    uint8_t rec[LOG_REC_MAX];
+
+    /* Önceden atılan kayıt varsa önce onu bildir */
+    if (dropCount != dropNoted) {
+        uint8_t len = buildDropNote(rec, dropCount - dropNoted);
+        if (!ringPush(rec, len)) { dropCount++; return; }
+        dropNoted = dropCount;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    uint8_t len = buildRecord(rec, level, fmt, ap);
+    va_end(ap);
+
+    if (!ringPush(rec, len)) dropCount++;
+}
+
+void logService()
+{
+    int room = Serial.availableForWrite();
+
+    while (room > 0 && rUsed > 0) {
+        if (sendLeft == 0) {            // yeni kayıt: uzunluk byte'ı
+            sendLeft = ringGet();
+            rUsed--;
+            continue;
+        }
+        Serial.write(ringGet());
+        rUsed--;
+        sendLeft--;
+        room--;
+    }
+}
+
+bool     logIdle()    { return sendLeft == 0; }
+uint16_t logDropped() { return dropCount; }
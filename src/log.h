@@ -0,0 +1,63 @@
+/**
+ *  log.h
+ *  -----
+ *  – Seviyeli, derleme zamanında süzülen log makroları (LOG_E/W/I/D),
+ *  – Format dizgileri flash'ta (PSTR), kayıtlar RAM halka tamponunda,
+ *  – Tampon loop()’ta logService() ile TX'te yer oldukça boşaltılır;
+ *    dolarsa kayıt atılır ve sayılır → log asla bekletmez.
+ *
+ *  Kullanım:   LOG_I("Offset Y0 raw = %u", ofs);
+ *  Not      :  AVR printf'i %f desteklemez → sabit noktalı tamsayı ver.
+ *              ISR içinden çağırma.
+ */
+#pragma once
+#include <Arduino.h>
+
+#define LOG_LVL_NONE   0
+#define LOG_LVL_ERROR  1
+#define LOG_LVL_WARN   2
+#define LOG_LVL_INFO   3
+#define LOG_LVL_DEBUG  4
+
+#ifndef LOG_LEVEL              // platformio.ini: -DLOG_LEVEL=LOG_LVL_WARN
+#define LOG_LEVEL      LOG_LVL_DEBUG
+#endif
+
+#ifndef LOG_BINARY             // 1 → kompakt ikili kayıt (tools/log_decode.py)
+#define LOG_BINARY     0
+#endif
+
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE  256     // byte
+#endif
+
+void logInit();                // setup()’ta, Serial.begin()’den sonra
+void logService();             // her loop() turunda — bloklamaz
+bool logIdle();                // yarım kalmış kayıt yok → başkası yazabilir
+uint16_t logDropped();         // tampon dolduğu için atılan kayıt sayısı
+
+void logWrite_P(uint8_t level, PGM_P fmt, ...);
+
+#if LOG_LEVEL >= LOG_LVL_ERROR
+#define LOG_E(fmt, ...) logWrite_P(LOG_LVL_ERROR, PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LVL_WARN
+#define LOG_W(fmt, ...) logWrite_P(LOG_LVL_WARN,  PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LVL_INFO
+#define LOG_I(fmt, ...) logWrite_P(LOG_LVL_INFO,  PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LVL_DEBUG
+#define LOG_D(fmt, ...) logWrite_P(LOG_LVL_DEBUG, PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) do {} while (0)
+#endif
@@ -5,7 +5,12 @@
  *  • MQTT/Ethernet başlatır    → mqttInit / mqttLoop
  *  • Fan & sıcaklık FSM’i      → updateTemperatureControl  (≈2 s)
  *  • Triyak tetiklemesi        → serviceTriac (her döngü)
- *  • Watch-Dog (2 s)           → kilitlenmeye karşı güvence
+ *  • Seri konsol               → serviceSerialConsole (her döngü, bloklamaz)
+ *  • Log halka tamponu         → logService (TX’te yer oldukça boşaltır)
+ *  • Yerel kurallar            → rulesTick (10 ms, broker gerekmez)
+ *  • Güç bütçesi               → pbService (10 ms, öncelikli yük atma)
+ *  • Watch-Dog (2 s)           → kilitlenmeye karşı güvence; takıldığı
+ *                                yer bir sonraki açılışta diag/crash’e
  *********************************************************************/
 
 #include <Arduino.h>
@@ -17,12 +22,29 @@
 #include "mqtt_haberlesme.h"      // mqttInit / mqttLoop / mqttProcess…
 #include "tanimlamalar.h"         // pinState[] / dirty[] global dizileri
 #include "current_sense.h"   
+#include "serial_console.h"       // T<mod> / cur / stat / cal komutları
+#include "log.h"                  // LOG_E/W/I/D + logService
+#include "rules.h"                // yerel kural motoru (10 ms)
+#include "output_timers.h"        // "ON:300" süreli çıkışlar
+#include "outputs.h"              // sıfır geçiş kuyruğu (outputsService)
+#include "telemetry_buffer.h"     // çevrimdışı tampon + uptime
+#include "load_signature.h"       // CS_HARMONICS: THD / yük sınıfı
+#include "diag.h"                 // profil + WDT ölüm kaydı
+#include "power_budget.h"         // toplam güç bütçesi / yük atma
+#include "channel_stats.h"        // kanal başına min / max / p95 özeti
 
 bool          pinState[32] = {false};     // Home Assistant gösterimi
 volatile bool dirty[32]    = {false};     // Publish kuyruğu işareti
 
 volatile bool moduleLocked[8] = {false};   // hepsi açık
 
+uint32_t loopCount  = 0;                   // Konsol "stat" komutu için
+uint32_t loopLastUs = 0;
+uint32_t loopMaxUs  = 0;
+uint32_t taskMaxUs[TASK_COUNT] = {0};
+
+volatile uint8_t activeTask = TASK_SETUP;
+
 
 /* ---------- Zamanlayıcılar ---------- */
 static uint32_t tFan = 0;          // Son fan-FSM güncellemesi (ms)
@@ -30,6 +52,23 @@ static uint32_t tFan = 0;          // Son fan-FSM güncellemesi (ms)
 static uint32_t tCurrent = 0;   // 10 ms Irms
 static uint32_t tEnergy  = 0;   // 1000 ms enerji
 static uint32_t tMqtt    = 0;   // 10 s MQTT publish
+static uint32_t tDiag    = 0;   // 60 s RAM raporu
+static uint32_t tTimers  = 0;   // 100 ms çıkış zamanlayıcı çarkı
+
+/* Görev başlangıcı: profil / WDT kaydı için etiketle */
+static inline uint32_t taskBegin(uint8_t task)
+{
+    activeTask = task;
+    return micros();
+}
+
+/* Görev süresini ölç, en uzununu sakla */
+static inline void taskDone(uint8_t task, uint32_t t0)
+{
+    uint32_t dt = micros() - t0;
+    if (dt > taskMaxUs[task]) taskMaxUs[task] = dt;
+    activeTask = TASK_OTHER;
+}
 
 /*********************************************************************
  *  SETUP  –  yalnızca 1 kez
@@ -37,23 +76,31 @@ static uint32_t tMqtt    = 0;   // 10 s MQTT publish
 void setup()
 {
     Serial.begin(9600);
+    logInit();                             // log halka tamponu (bloklamaz)
+    diagInit();                            // önceki WDT resetinin kaydı
 
     /* 1) Donanım pinlerini hazırla */
     setupAllPins();                        // Röle-triyak çıkışlarını LOW
+    outputTimersInit();                    // süreli çıkış çarkı boş
+    tbInit();                              // uptime + çevrimdışı tampon
 
     /* 2) Fan kontrol alt-sistemi */
     initTemperatureControl();              // ZCD pini + triyağı yapılandır
 
     /* 3) Ethernet + MQTT */
     mqttInit();                            // ENC28J60 & broker bağlantısı
-    mqttPublishDiscovery();                // Home Assistant auto-discovery
+    mqttDiscoveryInit();                   // HA discovery özeti (bağlanınca karşılaştırılır)
 
+    pbInit();           // güç bütçesi + öncelikler (EEPROM)
+    statsInit();        // istatistik penceresi
     initCurrentSense(); // akım ölçümü başlat
 
-    
+    initSerialConsole();  // komut satırı (bloklamayan)
+    rulesInit();          // EEPROM’daki kuralları doğrula
 
-    /* 4) Watch-Dog (2 s) */
-    wdt_enable(WDTO_2S);
+    /* 4) Watch-Dog (2 s) — önce kesme (kayıt), sonra reset */
+    activeTask = TASK_OTHER;
+    diagWatchdogEnable();
 }
 
 /*********************************************************************
@@ -61,18 +108,31 @@ void setup()
  *********************************************************************/
 void loop()
 {
+    uint32_t tLoop = micros();
+    uint32_t t0;
+
     /****  A) Triyak tetiklemesini servis et  ****/
     serviceTriac();                        // Her döngüde çağır ↻
+    outputsService();                      // ZCD yoksa çıkış kuyruğunu yaz
+    tbTick();                              // uptime saniyesi
 
     /****  B) MQTT işle  ****/
+    t0 = taskBegin(TASK_MQTT);
     mqttLoop();                            // mesaj al-gönder
     mqttProcessStateQueue();               // kirli çıkışları publish et
+    taskDone(TASK_MQTT, t0);
 
-    /****  C) Fan & sıcaklık FSM’i  ****/
+    /****  C) Seri konsol (byte byte, asla beklemez)  ****/
+    serviceSerialConsole();
+    logService();                          // TX’te yer kadar log boşalt
+
+    /****  D) Fan & sıcaklık FSM’i  ****/
     if (millis() - tFan >= 2000)           // ≈ 2 s
     {
+        t0 = taskBegin(TASK_FAN);
         updateTemperatureControl();
         tFan = millis();
+        taskDone(TASK_FAN, t0);
     }
 
 //    akım sensörleri ksımı güç hesaplama vs.
@@ -80,21 +140,62 @@ void loop()
           /* 10 ms: Irms örneklerini topla */
     if (millis() - tCurrent >= 10) {
         tCurrent = millis();
+        t0 = taskBegin(TASK_CURRENT);
         sampleCurrentSensors();
+        pbService();                  // bütçe aşımı → yük at / geri aç
+#if CS_HARMONICS
+        lsService();                  // biten Goertzel bloğu (en çok 1)
+#endif
+        taskDone(TASK_CURRENT, t0);
+
+        t0 = taskBegin(TASK_RULES);
+        rulesTick();                  // kurallar taze Irms ile
+        taskDone(TASK_RULES, t0);
+    }
+
+    /* 100 ms: çıkış zamanlayıcıları (gecikmede adım kaçırma, yetiş) */
+    for (uint8_t n = 0; n < 4 && millis() - tTimers >= OUT_TIMER_TICK_MS; ++n) {
+        tTimers += OUT_TIMER_TICK_MS;
+        outputTimersTick();
     }
+    if (millis() - tTimers >= OUT_TIMER_TICK_MS) tTimers = millis();   // uzun kopukluk
 
     /* 1 s: güç + enerji entegrasyonu */
     if (millis() - tEnergy >= 1000) {
         uint32_t dt = millis() - tEnergy;
         tEnergy = millis();
+        t0 = taskBegin(TASK_ENERGY);
         energyTick(dt);               // Wh güncelle
+        taskDone(TASK_ENERGY, t0);
     }
 
-    /* 10 s: MQTT’ye gönder */
+    /* 10 s: MQTT’ye gönder (TELEMETRY_FIXED 0 → yalnız bütçe durumu + çevrimdışı tampon) */
     if (millis() - tMqtt >= 10000) {  // her 10 s
         tMqtt = millis();
+        t0 = taskBegin(TASK_PUBLISH);
         mqttPublishPowerEnergy();     // AZ SONRA tanımlayacağız
+        taskDone(TASK_PUBLISH, t0);
+    }
+
+    /* STATS_PERIOD_S: kanal özeti, sonra yeni pencere */
+    if (statsDue()) {
+        t0 = taskBegin(TASK_PUBLISH);
+        mqttPublishStats();
+        statsReset();
+        taskDone(TASK_PUBLISH, t0);
+    }
+
+    /* 60 s: boş RAM / yığın tavanı */
+    if (millis() - tDiag >= 60000) {
+        tDiag = millis();
+        t0 = taskBegin(TASK_PUBLISH);
+        mqttPublishDiag();
+        taskDone(TASK_PUBLISH, t0);
     }
 
     wdt_reset();
+
+    loopCount++;
+    loopLastUs = micros() - tLoop;
+    if (loopLastUs > loopMaxUs) loopMaxUs = loopLastUs;
 }
@@ -0,0 +1,113 @@
+/**
+ * mqtt_cmd.cpp — MQTT komut ayrıştırıcıları
+ * ------------------------------------------------------------
+ *  › mqtt_haberlesme.cpp’deki callback() yardımcıları buraya taşındı:
+ *    kart ve test/test_dispatch (native) aynı kodu çalıştırır.
+ *  › Yalnız sabit uzunluklu karşılaştırma ve strtoul; her sayı bir
+ *    rakamla başlamalı (strtoul’un kabul ettiği " 5", "-1", "+3"
+ *    sessizce 0xFFFFFFFF / 5 olmasın) ve 32 bite sığmalı. Taban açık:
+ *    "0x" öneki → on altılık, aksi onluk ("010" = 10, sekizlik değil).
+ * ------------------------------------------------------------*/
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mqtt_cmd.h"
+
+static inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+static inline bool isHex(char c)   { return isDigit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f'); }
+static inline bool isHexPrefix(const char* s) { return s[0] == '0' && (s[1] | 0x20) == 'x'; }
+
+/** Rakamla başlayan 32 bitlik onluk sayı; hex → "0x…" de olur */
+static bool parseU32(const char* s, bool hex, uint32_t* out, char** end)
+{
+    int base = 10;
+    if (hex && isHexPrefix(s)) {
+        s += 2;
+        base = 16;
+        if (isHexPrefix(s)) { *end = (char*)s; return false; }     // strtoul "0x0x5"i de yer
+    }
+    if (!(base == 16 ? isHex(*s) : isDigit(*s))) { *end = (char*)s; return false; }
+    errno = 0;
+    unsigned long v = strtoul(s, end, base);
+    if (errno == ERANGE || v > 0xFFFFFFFFUL) return false;
+    *out = (uint32_t)v;
+    return true;
+}
+
+const char* mqttCmdStrip(const char* floorId, const char* topic)
+{
+    size_t n = strlen(floorId);
+    if (strncmp(topic, floorId, n) != 0 || topic[n] != '/') return nullptr;
+    return topic + n + 1;
+}
+
+int8_t mqttCmdOutputIdx(const char* cmd)
+{
+    char type = cmd[0];
+    if (type != 'Y' && type != 'X') return -1;
+
+    const char* p = cmd + 1;
+    if (!isDigit(*p)) return -1;
+    uint8_t num = *p++ - '0';
+    if (isDigit(*p)) {
+        if (num == 0) return -1;                // "Y07" kabul etme
+        num = num * 10 + (*p++ - '0');
+    }
+    if (num > 15 || strcmp(p, "/set") != 0) return -1;
+
+    return (type == 'Y') ? num : 16 + num;
+}
+
+uint32_t mqttCmdDurationMs(const char* s, uint32_t maxS)
+{
+    char*    end;
+    uint32_t sec;
+    if (!parseU32(s, false, &sec, &end)) return 0;
+
+    uint32_t ms = sec * 1000UL;
+    if (*end == '.' && isDigit(end[1])) {
+        ms += (end[1] - '0') * 100UL;           // yalnız onda bir
+        end += 2;
+    }
+    if (*end != '\0' || sec > maxS || ms > maxS * 1000UL) return 0;   // "86400.5" de dışarıda
+    return ms;
+}
+
+int8_t mqttCmdOnOff(const char* arg, uint32_t maxS, uint32_t* ms)
+{
+    *ms = 0;
+    if (strcmp(arg, "ON")  == 0) return MQTT_CMD_ON;
+    if (strcmp(arg, "OFF") == 0) return MQTT_CMD_OFF;
+    if (strncmp(arg, "ON:", 3) == 0 && (*ms = mqttCmdDurationMs(arg + 3, maxS)) != 0)
+        return MQTT_CMD_ON;
+    return MQTT_CMD_BAD;
+}
+
+bool mqttCmdMask(const char* arg, uint32_t* mask, uint32_t* change)
+{
+    char* end;
+    *change = 0xFFFFFFFFUL;
+    if (!parseU32(arg, true, mask, &end)) return false;
+    if (*end == ':' && !parseU32(end + 1, true, change, &end)) return false;
+    return *end == '\0';
+}
+
+int8_t mqttCmdScene(const char* arg, uint8_t slotMax, char* name, size_t nameLen,
+                    uint8_t* slot, uint32_t* mask, uint32_t* change)
+{
+    if (!isDigit(arg[0]) || arg[1] != ':' || (uint8_t)(arg[0] - '0') >= slotMax)
+        return MQTT_SCENE_BAD_SLOT;
+    *slot = arg[0] - '0';
+
+    const char* nm  = arg + 2;
+    const char* sep = strchr(nm, ':');
+    if (!sep) return (*nm == '\0') ? MQTT_SCENE_DELETE : MQTT_SCENE_NO_MASK;
+
+    size_t n = sep - nm;
+    if (n == 0 || n >= nameLen) return MQTT_SCENE_BAD_NAME;
+    memcpy(name, nm, n);
+    name[n] = '\0';
+
+    return mqttCmdMask(sep + 1, mask, change) ? MQTT_SCENE_DEFINE : MQTT_SCENE_BAD_MASK;
+}
@@ -0,0 +1,44 @@
+/**
+ *  mqtt_cmd.h
+ *  ----------
+ *  – Komut dağıtıcının (mqtt_haberlesme.cpp, callback) saf ayrıştırıcıları:
+ *    önek, Y<n>/X<n> konusu, ON/OFF/ON:<sn> yükü, outputs/set maskesi,
+ *    scene/define yükü,
+ *  – Arduino’ya bağımlı değil, heap yok → kartta ve Linux’ta aynı kod
+ *    (test/test_dispatch: bozuk girdi taraması + gecikme ölçümü).
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define MQTT_CMD_OFF   0
+#define MQTT_CMD_ON    1
+#define MQTT_CMD_BAD  -1
+
+/* mqttCmdScene() sonucu: ≥ 0 geçerli, < 0 hangi alanın bozuk olduğu */
+#define MQTT_SCENE_DELETE     0
+#define MQTT_SCENE_DEFINE     1
+#define MQTT_SCENE_BAD_SLOT  -1
+#define MQTT_SCENE_NO_MASK   -2
+#define MQTT_SCENE_BAD_NAME  -3
+#define MQTT_SCENE_BAD_MASK  -4
+
+/** "<floorId>/" önekini doğrula, kalan kısmı döndür; tutmazsa nullptr */
+const char* mqttCmdStrip     (const char* floorId, const char* topic);
+
+/** "Y7/set" → 7, "X10/set" → 26, aksi → -1 (n = 0‥15, baştaki 0 yok) */
+int8_t      mqttCmdOutputIdx (const char* cmd);
+
+/** "300" / "1.5" saniye → ms (yalnız onda bir); hatalı ya da maxS·1000 ms’den uzunsa 0 */
+uint32_t    mqttCmdDurationMs(const char* s, uint32_t maxS);
+
+/** "ON" | "OFF" | "ON:<sn>" → MQTT_CMD_ON / _OFF / _BAD; *ms = süre (yoksa 0) */
+int8_t      mqttCmdOnOff     (const char* arg, uint32_t maxS, uint32_t* ms);
+
+/** outputs/set yükü "<mask>[:<change>]" (onluk ya da 0x…, baştaki 0 sekizlik değil); change yoksa hepsi */
+bool        mqttCmdMask      (const char* arg, uint32_t* mask, uint32_t* change);
+
+/** scene/define yükü "<slot>:<ad>:<mask>[:<change>]" | "<slot>:" (sil);
+ *  slot tek hane < slotMax, ad 1‥nameLen−1 karakter, maske mqttCmdMask */
+int8_t      mqttCmdScene     (const char* arg, uint8_t slotMax, char* name, size_t nameLen,
+                              uint8_t* slot, uint32_t* mask, uint32_t* change);
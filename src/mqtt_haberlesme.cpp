@@ -1,133 +1,1132 @@
-#define MQTT_MAX_PACKET_SIZE 1024
 #include <UIPEthernet.h>
-#include <PubSubClient.h>
 #include <ArduinoJson.h>
+#include <avr/wdt.h>
 #include "config.h"
+#if MQTT_SN
+#include "mqtt_sn.h"
+#else
+#include <PubSubClient.h>
+#endif
 #include "mqtt_haberlesme.h"
 #include "pinmap.h"
 #include "tanimlamalar.h"
 #include "current_sense.h"
+#include "log.h"
+#include "outputs.h"
+#include "scenes.h"
+#include "rules.h"
+#include "output_timers.h"
+#include "telemetry_buffer.h"
+#include "mqtt_payload.h"
+#include "mqtt_cmd.h"
+#include "load_signature.h"
+#include "diag.h"
+#include "power_budget.h"
+#include "channel_stats.h"
+#include "wave_capture.h"
 
 
 static const byte MAC[6] = { 0xDE,0xAD,0xBE,0xEF,0xFE,FLOOR_ID[0] };
 static IPAddress broker(192,168,1,113);   // Mosquitto’nun IP’sini buraya yaz
+#if MQTT_SN
+EthernetUDP    snUdp;                     // gateway broker’la aynı makinede
+MqttSnClient   mqttClient(snUdp);
+#define MQTT_PORT MQTT_SN_PORT
+#else
 EthernetClient ethClient;
 PubSubClient   mqttClient(ethClient);
+#define MQTT_PORT 1883
+#endif
+
+/*  Paket tamponu tek yerden: platformio.ini -DMQTT_MAX_PACKET_SIZE=512
+ *  (kütüphane de aynı değerle derlenir). publish() ile giden her sabit
+ *  tampon derleme anında bu boya karşı denetlenir; daha uzun JSON’lar
+ *  publishJson() ile tampona hiç girmeden akıtılır. MQTT_SN derlemesi
+ *  tampon tutmaz ama aynı sınır korunur (iki taşıma aynı yükleri kabul etsin). */
+#define MQTT_HEADER_MAX 5               // sabit başlık + kalan boy (en çok 4 byte)
+#define MQTT_FITS(topicBuf, payloadBuf)                                          \
+    static_assert(MQTT_HEADER_MAX + 2 + sizeof(topicBuf) + sizeof(payloadBuf)    \
+                  <= MQTT_MAX_PACKET_SIZE, "MQTT paketi tampona sigmiyor")
+
+#define FLOOR_ID_MAX 12                 // 32 byte’lık konu tamponları buna göre
+static_assert(sizeof(FLOOR_ID) - 1 <= FLOOR_ID_MAX, "FLOOR_ID cok uzun");
+
+/*********************************************************************
+ *  📤 JSON’u tampon tutmadan yayınla
+ *  beginPublish(boy) → serializeJson(doc, yazıcı) → endPublish
+ *  ChunkWriter byte’ları MQTT_CHUNK’lık parçalarla yollar (UIPEthernet’e
+ *  byte başına ayrı write() gitmesin).
+ *********************************************************************/
+#define MQTT_CHUNK 32
+
+class ChunkWriter : public Print {
+public:
+    using Print::write;
+    size_t write(uint8_t c) override
+    {
+        buf[n++] = c;
+        if (n == MQTT_CHUNK) drain();
+        return 1;
+    }
+    void drain()
+    {
+        if (n) mqttClient.write(buf, n);
+        n = 0;
+    }
+private:
+    uint8_t buf[MQTT_CHUNK];
+    uint8_t n = 0;
+};
+
+static bool publishJson(const char* topic, const JsonDocument& doc, bool retained)
+{
+    if (!mqttClient.beginPublish(topic, measureJson(doc), retained)) return false;
+    ChunkWriter w;
+    serializeJson(doc, w);
+    w.drain();
+    return mqttClient.endPublish();
+}
+
+
+/*********************************************************************
+ *  🏠 Home Assistant discovery — içerik özetli, yalnız değişen
+ *  ------------------------------------------------------------------
+ *  Öğeler (tek sıra, her derlemede sabit):
+ *    0‥63    mqttDiscoveryItem   (32 switch + 16 güç + 16 enerji)
+ *    64‥71   sahne slotları      (boş slot → boş retained → HA siler)
+ *    72‥87   Y<n> p95            (sensörsüz kanal → öğe yok)
+ *    88‥135  THD / yük / anomali (CS_HARMONICS)
+ *  – Açılışta her MQTT_DISC_BLOCK’luk bloğun FNV-1a özeti (konu + yük)
+ *    hesaplanır; sahneler EEPROM’da olduğu için derleme anında olmaz.
+ *  – Bağlanınca retained <FLOOR_ID>/discovery_hash beklenir
+ *    (DISC_HASH_WAIT_MS): tutan bloklar atlanır, tutmayanlar
+ *    mqttLoop() başına DISC_PER_LOOP config ile yayınlanır, sonunda
+ *    yeni özet retained yazılır. Değişiklik yoksa yeniden bağlanma
+ *    yalnız bir SUBSCRIBE + bir alınan mesajdır.
+ *  – Yayını başarısız olan bloğun özeti ters çevrilmiş yazılır (tutmaz →
+ *    sonraki bağlanmada yeniden gider); kip temizliği yarım kaldıysa özet
+ *    hiç yazılmaz. Özetin kendisi yazılamazsa sonraki turda yeniden denenir.
+ *  – HA_DEVICE_DISCOVERY=1: tüm öğeler tek homeassistant/device/<id>/config
+ *    yükünde ("cmps"), beginPublish ile akıtılır. Kip değişince eski
+ *    kipin konuları boş retained ile temizlenir.
+ *********************************************************************/
+#if HA_DEVICE_DISCOVERY && MQTT_SN
+#error "HA_DEVICE_DISCOVERY tek büyük yük ister; MQTT_SN datagramına sığmaz"
+#endif
+
+#define DISC_SCENE0   MQTT_DISCOVERY_ITEMS
+#define DISC_STATS0   (DISC_SCENE0 + SCENE_MAX)
+#define DISC_SIG0     (DISC_STATS0 + NUM_Y_CHANNELS)
+#if CS_HARMONICS
+#define DISC_ITEMS    (DISC_SIG0 + NUM_Y_CHANNELS * MQTT_SIG_KINDS)
+#else
+#define DISC_ITEMS    DISC_SIG0
+#endif
+#define DISC_BLOCKS   ((DISC_ITEMS + MQTT_DISC_BLOCK - 1) / MQTT_DISC_BLOCK)
+static_assert(DISC_ITEMS <= 255 && DISC_BLOCKS <= 32, "discovery ogeleri uint8 / bit maskesine sigmiyor");
+
+#if HA_DEVICE_DISCOVERY
+#define DISC_MODE 'd'
+#else
+#define DISC_MODE 'e'
+#endif
+
+enum : uint8_t { DISC_NONE, DISC_EMPTY, DISC_CONFIG };     // discoveryItem() sonucu
+enum : uint8_t { DISC_IDLE, DISC_WAIT, DISC_SEND };        // bağlantı sonrası akış
+
+static uint32_t discHash[DISC_BLOCKS];
+static uint32_t discStale   = 0;        // bit b → blok b yayınlanacak
+static uint32_t discFailed  = 0;        // bit b → blok b’nin bir yayını başarısız
+static uint8_t  discState   = DISC_IDLE;
+static uint8_t  discNext    = 0;        // sıradaki öğe
+static bool     discMigrate = false;    // broker’da başka kip / özet yok
+static bool     discMigFail = false;    // kip temizliğinde başarısız yayın
+static uint32_t tDisc       = 0;
+
+/** Boş slot: yalnız konu + unique_id (cihaz kipinde bileşeni silmek için) */
+static uint8_t sceneItem(uint8_t slot, char* topic, size_t n, JsonDocument& doc)
+{
+    snprintf_P(topic, n, PSTR("homeassistant/scene/%s/scene%u/config"), FLOOR_ID, slot);
+
+    char uid[24], cmdT[32];
+    snprintf_P(uid, sizeof(uid), PSTR("%s_scene%u"), FLOOR_ID, slot);
+    Scene sc;
+    if (!sceneGet(slot, sc)) {
+        doc["unique_id"] = uid;
+        return DISC_EMPTY;
+    }
+
+    JsonObject dev = doc.createNestedObject("device");
+    dev["identifiers"][0] = FLOOR_ID;
+    snprintf_P(cmdT, sizeof(cmdT), PSTR("%s/scene/set"), FLOOR_ID);
+    doc["name"]          = sc.name;
+    doc["command_topic"] = cmdT;
+    doc["payload_on"]    = sc.name;
+    doc["unique_id"]     = uid;
+    return DISC_CONFIG;
+}
+
+static uint8_t discoveryItem(uint8_t i, char* topic, size_t n, JsonDocument& doc)
+{
+    doc.clear();
+    if (i < DISC_SCENE0) {
+        if (mqttDiscoveryItem(FLOOR_ID, i, topic, n, doc)) return DISC_CONFIG;
+        LOG_E("discovery %u: JsonDocument kucuk", i);
+        return DISC_NONE;
+    }
+    if (i < DISC_STATS0) return sceneItem(i - DISC_SCENE0, topic, n, doc);
+    if (i < DISC_SIG0) {
+        uint8_t ch = i - DISC_STATS0;
+        return (hasCurrentSensor(ch) && mqttStatsItem(FLOOR_ID, ch, topic, n, doc))
+               ? DISC_CONFIG : DISC_NONE;
+    }
+#if CS_HARMONICS
+    if (i < DISC_ITEMS) {
+        uint8_t ch = (i - DISC_SIG0) / MQTT_SIG_KINDS, k = (i - DISC_SIG0) % MQTT_SIG_KINDS;
+        return (hasCurrentSensor(ch) && mqttSignatureItem(FLOOR_ID, ch, k, topic, n, doc))
+               ? DISC_CONFIG : DISC_NONE;
+    }
+#endif
+    return DISC_NONE;
+}
+
+/** serializeJson’u tampon tutmadan FNV-1a’ya akıtır */
+class HashWriter : public Print {
+public:
+    using Print::write;
+    size_t write(uint8_t c) override { h = mqttHashAdd(h, &c, 1); return 1; }
+    uint32_t h = MQTT_HASH_SEED;
+};
+
+static void discoveryHashBlock(uint8_t b)
+{
+    char topic[64];
+    StaticJsonDocument<MQTT_DISCOVERY_DOC> doc;
+    HashWriter w;
+    uint8_t end = min(DISC_ITEMS, (b + 1) * MQTT_DISC_BLOCK);
+    for (uint8_t i = b * MQTT_DISC_BLOCK; i < end; ++i) {
+        uint8_t kind = discoveryItem(i, topic, sizeof(topic), doc);
+        if (kind == DISC_NONE) continue;
+        w.write((const uint8_t*)topic, strlen(topic) + 1);     // \0 ayırıcı
+        if (kind == DISC_CONFIG) serializeJson(doc, w);
+    }
+    discHash[b] = w.h;
+}
+
+static void discoveryHashTopic(char* buf, size_t n)
+{
+    snprintf_P(buf, n, PSTR("%s/discovery_hash"), FLOOR_ID);
+}
+
+static void discoveryDeviceTopic(char* buf, size_t n)
+{
+    snprintf_P(buf, n, PSTR("homeassistant/device/%s/config"), FLOOR_ID);
+}
+
+#if HA_DEVICE_DISCOVERY
+/*  {"dev":{…},"o":{…},"cmps":{"<unique_id>":{"p":"<platform>",…},…}}
+ *  Bileşen alanları öğe yükünden birebir (device hariç); boş öğe
+ *  {"p":…} olarak kalır → HA o bileşeni siler. İki geçiş: boy, sonra yük. */
+struct DevSink {
+    ChunkWriter* w;                     // nullptr → yalnız say
+    size_t       len;
+    void put(const char* s)
+    {
+        size_t n = strlen(s);
+        if (w) w->write((const uint8_t*)s, n);
+        len += n;
+    }
+    void json(JsonVariantConst v) { len += w ? serializeJson(v, *w) : measureJson(v); }
+};
+
+static void deviceEmit(DevSink& o)
+{
+    char topic[64], b[40];
+    StaticJsonDocument<MQTT_DISCOVERY_DOC> doc;
+
+    mqttDiscoveryItem(FLOOR_ID, 0, topic, sizeof(topic), doc);     // tam device bloğu
+    o.put("{\"dev\":");
+    o.json(doc.as<JsonObjectConst>()["device"]);
+    o.put(",\"o\":{\"name\":\"Merisoft\"},\"cmps\":{");
+
+    bool first = true;
+    for (uint8_t i = 0; i < DISC_ITEMS; ++i) {
+        uint8_t kind = discoveryItem(i, topic, sizeof(topic), doc);
+        if (kind == DISC_NONE) continue;
+
+        const char* p   = topic + 14;                               // homeassistant/<p>/…
+        const char* end = strchr(p, '/');
+        uint8_t     pl  = end ? min((size_t)(end - p), (size_t)15) : 0;
+        snprintf_P(b, sizeof(b), PSTR("%s\"%s\":{\"p\":\"%.*s\""),
+                   first ? "" : ",", doc["unique_id"] | "", pl, p);
+        o.put(b);
+        first = false;
+
+        if (kind == DISC_CONFIG) {
+            for (JsonPairConst kv : doc.as<JsonObjectConst>()) {
+                if (strcmp_P(kv.key().c_str(), PSTR("device")) == 0) continue;
+                snprintf_P(b, sizeof(b), PSTR(",\"%s\":"), kv.key().c_str());
+                o.put(b);
+                o.json(kv.value());
+            }
+        }
+        o.put("}");
+        if (o.w) wdt_reset();           // ≈20 kB TCP’ye akarken WDT_2S dolmasın
+    }
+    o.put("}}");
+}
+
+static bool publishDevice()
+{
+    char topic[48];
+    discoveryDeviceTopic(topic, sizeof(topic));
+    DevSink m = { nullptr, 0 };
+    deviceEmit(m);
+    if (!mqttClient.beginPublish(topic, m.len, true)) return false;
+    ChunkWriter w;
+    DevSink s = { &w, 0 };
+    deviceEmit(s);
+    w.drain();
+    return mqttClient.endPublish();
+}
+#endif
+
+/** Son adım: yeni özet retained → sonraki bağlanmada karşılaştırılır.
+ *  Başarısız bloklar tutmayan özetle yazılır; özet yazılamazsa DISC_SEND
+ *  kalır → sonraki turda yeniden. */
+static void discoveryFinish()
+{
+    if (discMigFail) {                          // broker’da eski kip kalsın
+        LOG_W("Discovery: kip temizligi yarim, ozet yazilmadi");
+        discState = DISC_IDLE;
+        return;
+    }
+    uint32_t h[DISC_BLOCKS];
+    for (uint8_t b = 0; b < DISC_BLOCKS; ++b)
+        h[b] = (discFailed & (1UL << b)) ? ~discHash[b] : discHash[b];
 
+    char topic[40], payload[2 + DISC_BLOCKS * 9];
+    MQTT_FITS(topic, payload);
+    discoveryHashTopic(topic, sizeof(topic));
+    mqttDiscHashText(DISC_MODE, h, DISC_BLOCKS, payload, sizeof(payload));
+    if (!mqttClient.publish(topic, payload, true)) {
+        LOG_W("discovery_hash yazilamadi");
+        return;
+    }
+    if (discFailed) LOG_W("Discovery: basarisiz blok 0x%08lX", (unsigned long)discFailed);
+    discState = DISC_IDLE;
+}
+
+static void discoveryStart(uint32_t stale, bool migrate)
+{
+    discStale   = stale;
+    discMigrate = migrate;
+    discFailed  = 0;
+    discMigFail = false;
+    discNext    = 0;
+    discState   = (stale || migrate) ? DISC_SEND : DISC_IDLE;
+    if (discState == DISC_IDLE) LOG_I("Discovery guncel");
+    else                        LOG_I("Discovery: eski blok 0x%08lX", (unsigned long)stale);
+}
+
+/** <FLOOR_ID>/discovery_hash (retained) — yalnız bağlantı sonrası bekleme
+ *  sırasında; kendi yayınımızın yankısı DISC_IDLE’da gelir, yok sayılır. */
+static void cmdDiscoveryHash(const byte* payload, unsigned int len)
+{
+    if (discState != DISC_WAIT) return;
+    discoveryStart(mqttDiscStale((const char*)payload, len, DISC_MODE, discHash, DISC_BLOCKS),
+                   len == 0 || payload[0] != DISC_MODE);
+}
+
+/** Bağlantı kurulunca: özeti iste, karar cmdDiscoveryHash / zaman aşımında */
+static void discoveryOnConnect()
+{
+    char topic[40];
+    discoveryHashTopic(topic, sizeof(topic));
+    mqttClient.subscribe(topic);
+    discState = DISC_WAIT;
+    tDisc     = millis();
+}
+
+/** Öğe değişti (sahne tanımı): bloğun özetini tazele, bloğu yeniden yayınla */
+static void discoveryRefresh(uint8_t i)
+{
+    uint8_t b = i / MQTT_DISC_BLOCK, first = b * MQTT_DISC_BLOCK;
+    discoveryHashBlock(b);
+    if (discState == DISC_WAIT) return;         // karşılaştırma yeni özeti kullanır
+    if (discState == DISC_IDLE) {
+        discStale = discFailed = 0;
+        discMigrate = discMigFail = false;
+        discNext = first;
+    }
+    discStale |= 1UL << b;
+    if (discNext > first) discNext = first;
+    discState = DISC_SEND;
+}
 
-void publishPowerEnergyDiscovery()
+static void mqttServiceDiscovery()
 {
+    if (discState == DISC_WAIT) {
+        if (millis() - tDisc < DISC_HASH_WAIT_MS) return;
+        LOG_I("discovery_hash yok");
+        discoveryStart(0xFFFFFFFFUL >> (32 - DISC_BLOCKS), true);
+    }
+    if (discState != DISC_SEND) return;
+
     char topic[64];
-    char payload[512];
+    StaticJsonDocument<MQTT_DISCOVERY_DOC> doc;
+    uint8_t sent = 0;
+
+#if HA_DEVICE_DISCOVERY
+    if (discStale) {                            // tek yük, bu turun tamamı
+        if (!publishDevice()) discFailed = 0xFFFFFFFFUL >> (32 - DISC_BLOCKS);
+        discStale = 0;
+        return;
+    }
+    /* önceki kipin varlık başına konuları */
+    while (discMigrate && discNext < DISC_ITEMS && sent < DISC_PER_LOOP) {
+        if (discoveryItem(discNext++, topic, sizeof(topic), doc) == DISC_NONE) continue;
+        if (!mqttClient.publish(topic, (const uint8_t*)"", 0, true)) discMigFail = true;
+        sent++;
+    }
+    if (discMigrate && discNext < DISC_ITEMS) return;
+#else
+    if (discMigrate) {                          // önceki kipin cihaz config’i
+        discoveryDeviceTopic(topic, sizeof(topic));
+        if (!mqttClient.publish(topic, (const uint8_t*)"", 0, true)) discMigFail = true;
+        discMigrate = false;
+        sent++;
+    }
+    while (discNext < DISC_ITEMS && sent < DISC_PER_LOOP) {
+        uint8_t i = discNext++;
+        if (!(discStale & (1UL << (i / MQTT_DISC_BLOCK)))) continue;
+        uint8_t kind = discoveryItem(i, topic, sizeof(topic), doc);
+        bool    ok;
+        if (kind == DISC_CONFIG)     ok = publishJson(topic, doc, true);
+        else if (kind == DISC_EMPTY) ok = mqttClient.publish(topic, (const uint8_t*)"", 0, true);
+        else                         continue;
+        if (!ok) discFailed |= 1UL << (i / MQTT_DISC_BLOCK);
+        sent++;
+    }
+    if (discNext < DISC_ITEMS) return;
+#endif
+    discoveryFinish();
+}
+
+/*********************************************************************
+ *  📥 Komut dağıtıcı
+ *  ------------------------------------------------------------------
+ *  Konu  : <FLOOR_ID>/<komut>      (ör. up32/Y7/set, up32/outputs/set)
+ *  – Önek tam olarak FLOOR_ID + '/' olmalı,
+ *  – Tekil çıkış "Y<n>/set" | "X<n>/set"  (n = 0‥15, en çok 2 hane)
+ *    yük "ON" | "OFF" | "ON:<sn>" (süreli, output_timers.cpp)
+ *    hızlı yoldan ayrıştırılır,
+ *  – Diğer komutlar flash’taki cmdTable[]’dan tam eşleşmeyle bulunur.
+ *  Hiçbir yerde heap / String yok; geçersiz konu ve yük sessizce atılır.
+ *  Saf ayrıştırıcılar mqtt_cmd.cpp’de (host testi: test/test_dispatch).
+ *********************************************************************/
+#define CMD_PAYLOAD_MAX 48      // yükün kopyalanacağı yerel tampon
+
+/** Yükü \0 ile biten yerel tampona kopyala; sığmazsa false */
+static bool copyPayload(char* dst, size_t n, const byte* payload, unsigned int len)
+{
+    if (len >= n) return false;
+    memcpy(dst, payload, len);
+    dst[len] = '\0';
+    return true;
+}
+
+/** Tek çıkış: "ON" / "OFF" / "ON:<sn>" (süre dolunca OFF) */
+static void handleOutputSet(uint8_t idx, const char* arg)
+{
+    uint32_t ms;
+    int8_t   r = mqttCmdOnOff(arg, OUT_TIMER_MAX_S, &ms);
+    if (r == MQTT_CMD_BAD) { LOG_W("Gecersiz yuk: %s", arg); return; }
+    bool on = (r == MQTT_CMD_ON);
+
+    if (!outputSet(idx, on)) {                  // aşırı ısınma kilidi / güç bütçesi
+        char alias[4]; outputAlias(idx, alias, sizeof(alias));
+        char msg[48];  snprintf_P(msg, sizeof(msg), pbIsShed(idx) ? PSTR("%s: guc butcesi dolu")
+                                                                  : PSTR("%s: kilit devam ediyor"), alias);
+        haNotify("Komut Reddedildi", msg);
+        return;
+    }
+    if (ms && !outputTimerStart(idx, ms)) {     // süresiz açık kalmasın
+        outputSet(idx, false);
+        char alias[4]; outputAlias(idx, alias, sizeof(alias));
+        char msg[48];  snprintf_P(msg, sizeof(msg), PSTR("%s: zamanlayici kurulamadi"), alias);
+        haNotify("Komut Reddedildi", msg);
+    }
+}
+
+/** <FLOOR_ID>/outputs/set   yük: "<mask>[:<change>]"
+ *  – mask  : bit i = 1 → ON   (bit0 = Y0 … bit16 = X0 …)
+ *  – change: yalnız 1 olan bitlere dokun (verilmezse hepsi)
+ *  – Sayılar onluk ya da 0x… onaltılık ("010" = 10). */
+static void cmdOutputsSet(const char* arg)
+{
+    uint32_t mask, change;
+    if (!mqttCmdMask(arg, &mask, &change)) { LOG_W("outputs/set: hatali yuk: %s", arg); return; }
+
+    uint32_t rejected = outputApplyMask(mask, change);
+    if (rejected) {
+        char msg[48];
+        snprintf_P(msg, sizeof(msg), PSTR("outputs: kilitli 0x%08lX"), (unsigned long)rejected);
+        haNotify("Komut Reddedildi", msg);
+    }
+}
+
+/** <FLOOR_ID>/scene/set   yük: sahne adı ya da slot no ("aksam", "3") */
+static void cmdSceneSet(const char* arg)
+{
+    int8_t slot = sceneFind(arg);
+    if (slot < 0) { LOG_W("Sahne yok: %s", arg); return; }
+
+    uint32_t rejected = 0;
+    sceneRecall(slot, &rejected);
+    if (rejected) {
+        char msg[48];
+        snprintf_P(msg, sizeof(msg), PSTR("%s: kilitli 0x%08lX"), arg, (unsigned long)rejected);
+        haNotify("Sahne Kismen Uygulandi", msg);
+    }
+}
+
+/** <FLOOR_ID>/scene/define   yük: "<slot>:<ad>:<mask>[:<change>]"
+ *  – "<slot>:" (ad boş) → slotu sil
+ *  – change verilmezse sahne tüm çıkışları belirler
+ *  – maske / change outputs/set’teki gibi (mqttCmdMask: "-1", " 5" yok) */
+static void cmdSceneDefine(const char* arg)
+{
+    char     nm[SCENE_NAME_LEN];
+    uint8_t  slot;
+    uint32_t mask, change;
+    switch (mqttCmdScene(arg, SCENE_MAX, nm, sizeof(nm), &slot, &mask, &change)) {
+    case MQTT_SCENE_DEFINE:   break;
+    case MQTT_SCENE_DELETE:
+        sceneDelete(slot);
+        discoveryRefresh(DISC_SCENE0 + slot);   // boş retained → HA'dan kaldır
+        return;
+    case MQTT_SCENE_BAD_SLOT: LOG_W("scene/define: slot");      return;
+    case MQTT_SCENE_NO_MASK:  LOG_W("scene/define: maske yok"); return;
+    case MQTT_SCENE_BAD_NAME: LOG_W("scene/define: ad");        return;
+    default:                  LOG_W("scene/define: maske");     return;
+    }
+
+    sceneDefine(slot, nm, mask, change);
+    discoveryRefresh(DISC_SCENE0 + slot);
+    LOG_I("Sahne %u = %s", slot, nm);
+}
+
+/** <FLOOR_ID>/rules/set   yük: bytecode hex ("02040320 ..."), boş → sil
+ *  Yük CMD_PAYLOAD_MAX’tan uzun olabildiği için ham hâliyle işlenir. */
+static void cmdRulesSet(const byte* payload, unsigned int len)
+{
+    if (!rulesLoadHex(payload, len)) {
+        LOG_W("rules/set: gecersiz program");
+        haNotify("Kural Reddedildi", "bytecode dogrulanamadi");
+    }
+}
+
+/** <FLOOR_ID>/time/set   yük: Unix epoch (s) → uptime ↔ duvar saati */
+static void cmdTimeSet(const char* arg)
+{
+    char* end;
+    uint32_t epoch = strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || epoch < 1600000000UL) { LOG_W("time/set: gecersiz"); return; }
+    tbSetEpoch(epoch);
+}
+
+/** <FLOOR_ID>/budget/set   yük: toplam güç bütçesi, W ("3500") → EEPROM */
+static void cmdBudgetSet(const char* arg)
+{
+    char* end;
+    unsigned long w = strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || w > 0xFFFF || !pbSetBudget(w)) {
+        LOG_W("budget/set: gecersiz"); return;
+    }
+    LOG_I("Guc butcesi %u W", (uint16_t)w);
+}
+
+/** <FLOOR_ID>/priority/set   yük: "Y<n>:<p>"  p = 0 (atılmaz) ‥ 9 → EEPROM */
+static void cmdPrioritySet(const char* arg)
+{
+    char* end;
+    if (arg[0] != 'Y') { LOG_W("priority/set: Y<n>:<p>"); return; }
+    unsigned long ch = strtoul(arg + 1, &end, 10);
+    if (end == arg + 1 || *end != ':' || end[1] < '0' || end[1] > '9' || end[2] != '\0' ||
+        !pbSetPriority(ch, end[1] - '0')) {
+        LOG_W("priority/set: Y<n>:<p>"); return;
+    }
+    LOG_I("Y%u oncelik %c", (uint8_t)ch, end[1]);
+}
+
+/*********************************************************************
+ *  🩺 Profil   <FLOOR_ID>/profile/set   "on" | "off" | "reset" | "dump"
+ *  dump → <FLOOR_ID>/diag/profile
+ *    {"run":1,"n":12345,"shift":11,
+ *     "b":[[bölge,sayı],…],      bölge << shift = flash byte adresi
+ *     "task":{"mqtt":…,…},       "pc":[son PC’ler, byte adresi]}
+ *  Bölge sayısı MQTT_MAX_PACKET_SIZE’ı aşabildiği için beginPublish ile
+ *  akıtılır: önce boy sayılır, sonra aynı üreteç yazar (profil bu sırada
+ *  durdurulur → iki geçiş aynı veriyi görür). Çözümleme: tools/pc2sym.py
+ *********************************************************************/
+struct JsonSink {
+    bool   send;
+    size_t len;
+    void put(const char* s)
+    {
+        size_t n = strlen(s);
+        if (send) mqttClient.write((const uint8_t*)s, n);
+        len += n;
+    }
+};
+
+static void profileEmit(JsonSink& o, bool wasRunning)
+{
+    char b[24];
+    snprintf_P(b, sizeof(b), PSTR("{\"run\":%u,\"n\":%lu,"),
+               wasRunning ? 1 : 0, (unsigned long)profTotal());
+    o.put(b);
+    snprintf_P(b, sizeof(b), PSTR("\"shift\":%u,\"b\":["), PROF_SHIFT + 1);
+    o.put(b);
+    bool first = true;
+    for (uint8_t i = 0; i < PROF_BUCKETS; i++) {
+        uint16_t c = profBucket(i);
+        if (!c) continue;
+        snprintf_P(b, sizeof(b), PSTR("%s[%u,%u]"), first ? "" : ",", i, c);
+        o.put(b);
+        first = false;
+    }
+    o.put("],\"task\":{");
+    for (uint8_t t = 0; t <= TASK_SETUP; t++) {
+        char name[8];
+        diagTaskName(t, name, sizeof(name));
+        snprintf_P(b, sizeof(b), PSTR("%s\"%s\":%u"), t ? "," : "", name, profTaskHits(t));
+        o.put(b);
+    }
+    o.put("},\"pc\":[");
+    for (uint8_t i = 0; i < PROF_RECENT; i++) {
+        snprintf_P(b, sizeof(b), PSTR("%s%lu"), i ? "," : "", (unsigned long)profRecentPc(i));
+        o.put(b);
+    }
+    o.put("]}");
+}
+
+static void publishProfile()
+{
+    bool wasRunning = profRunning();
+    profStop();
+
+    char topic[32];
+    snprintf_P(topic, sizeof(topic), PSTR("%s/diag/profile"), FLOOR_ID);
+    JsonSink o = { false, 0 };
+    profileEmit(o, wasRunning);
+    if (mqttClient.beginPublish(topic, o.len, false)) {
+        o.send = true;
+        profileEmit(o, wasRunning);
+        mqttClient.endPublish();
+    }
+
+    if (wasRunning) profStart();
+}
+
+static void cmdProfileSet(const char* arg)
+{
+    if      (strcmp_P(arg, PSTR("on"))    == 0) profStart();
+    else if (strcmp_P(arg, PSTR("off"))   == 0) profStop();
+    else if (strcmp_P(arg, PSTR("reset")) == 0) profReset();
+    else if (strcmp_P(arg, PSTR("dump"))  == 0) publishProfile();
+}
+
+/*********************************************************************
+ *  💥 Watchdog ölüm kaydı   <FLOOR_ID>/diag/crash  (retained)
+ *  {"pc":"0x01a2b4","task":"mqtt","sp":"0x21c0","stack":63,"up":812,"n":1}
+ *  pc   : takılınan komut (byte adresi) → tools/pc2sym.py
+ *  stack: RAMEND − SP (byte), n: yayınlanamadan üst üste kaç WDT reseti
+ *********************************************************************/
+static void publishCrash()
+{
+    CrashInfo ci;
+    if (!diagCrashPending(ci)) return;
+
+    char task[8];
+    diagTaskName(ci.task, task, sizeof(task));
+
+    char topic[32], payload[128];
+    MQTT_FITS(topic, payload);
+    snprintf_P(topic, sizeof(topic), PSTR("%s/diag/crash"), FLOOR_ID);
+    snprintf_P(payload, sizeof(payload),
+               PSTR("{\"pc\":\"0x%06lx\",\"task\":\"%s\",\"sp\":\"0x%04x\",\"stack\":%u,"
+                    "\"up\":%lu,\"n\":%u}"),
+               (unsigned long)ci.pc, task, ci.sp, (unsigned)(RAMEND - ci.sp),
+               (unsigned long)ci.uptime, ci.count);
+    if (mqttClient.publish(topic, payload, true)) diagCrashClear();
+}
 
+/*********************************************************************
+ *  📊 Kanal istatistikleri   <FLOOR_ID>/stats   (STATS_PERIOD_S, retained)
+ *  {"s":300,"Y0":{"n":1250,"min":0,"max":2210,"mean":812,"p95":2190,
+ *                 "duty":42,"act":93,"wh":1234.5},…}
+ *  duty: pinState ON süresi %, act: ON iken akım çekilen süre %,
+ *  wh: kümülatif enerji. 12 kanal ≈1 KB → profil gibi iki geçiş (JsonSink);
+ *  s önceden alınır, diğer alanlar yalnız loop()’ta değişir → boylar tutar.
+ *  TELEMETRY_FIXED 0 iken Y<n>/power (ortalama) ve /energy de buradan.
+ *********************************************************************/
+static void statsEmit(JsonSink& o, uint32_t secs)
+{
+    char b[64];
+    snprintf_P(b, sizeof(b), PSTR("{\"s\":%lu"), (unsigned long)secs);
+    o.put(b);
     for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++) {
+        StatsSummary s;
+        if (!statsGet(ch, s)) continue;
+        char wh[12];
+        mqttFormatValue(Y_energyWh[ch], 1, wh, sizeof(wh));
+        snprintf_P(b, sizeof(b), PSTR(",\"Y%u\":{\"n\":%u,\"min\":%u,\"max\":%u,\"mean\":%u,"),
+                   ch, s.n, s.minW, s.maxW, s.meanW);
+        o.put(b);
+        snprintf_P(b, sizeof(b), PSTR("\"p95\":%u,\"duty\":%u,\"act\":%u,\"wh\":%s}"),
+                   s.p95W, s.duty, s.active, wh);
+        o.put(b);
+    }
+    o.put("}");
+}
+
+void mqttPublishStats()
+{
+    if (!mqttClient.connected()) return;
 
-        /* ------------- POWER ------------- */
-        StaticJsonDocument<512> doc;                 // ← Yerel doc → her tur temiz
-        JsonObject dev = doc.createNestedObject("device");
-        dev["identifiers"][0] = FLOOR_ID;
-        dev["name"]           = "Merisoft Kart";
-        dev["model"]          = "Mega+ENC28J60";
+    char topic[32];
+    mqttStatsTopic(FLOOR_ID, topic, sizeof(topic));
+    uint32_t secs = statsSeconds();
 
-        doc["device_class"]        = "power";
-        doc["state_class"]         = "measurement";
-        doc["unit_of_measurement"] = "W";
-        doc["name"]                = String("Y") + ch + " Power";
-        doc["state_topic"]         = String(FLOOR_ID) + "/Y" + ch + "/power";
-        doc["unique_id"]           = String(FLOOR_ID) + "_pow_Y" + ch;
+    JsonSink m = { false, 0 };
+    statsEmit(m, secs);
+    if (!mqttClient.beginPublish(topic, m.len, true)) return;
+    JsonSink w = { true, 0 };
+    statsEmit(w, secs);
+    mqttClient.endPublish();
 
-        snprintf(topic,sizeof(topic),
-                 "homeassistant/sensor/%s/Y%u_power/config", FLOOR_ID, ch);
-        serializeJson(doc, payload, sizeof(payload));
-        mqttClient.publish(topic, payload, true);
+#if !TELEMETRY_FIXED
+    char buf[16];
+    for (uint8_t ch = 0; ch < MQTT_SENSOR_CHANNELS; ch++) {
+        StatsSummary s;
+        if (!statsGet(ch, s)) continue;
+        snprintf_P(buf, sizeof(buf), PSTR("%u"), s.meanW);
+        mqttTelemetryTopic(FLOOR_ID, ch, false, topic, sizeof(topic));
+        mqttClient.publish(topic, buf);
+        mqttFormatValue(Y_energyWh[ch], 2, buf, sizeof(buf));
+        mqttTelemetryTopic(FLOOR_ID, ch, true, topic, sizeof(topic));
+        mqttClient.publish(topic, buf);
+    }
+#endif
+}
 
-        /* ------------- ENERGY ------------ */
-        doc.clear();                                   // Tertemiz
-        dev = doc.createNestedObject("device");
-        dev["identifiers"][0] = FLOOR_ID;
+/*********************************************************************
+ *  🧮 RAM   <FLOOR_ID>/diag/ram   (60 s, main.cpp)
+ *  {"free":2210,"min_free":1630,"stack_max":402,"heap":519}
+ *  min_free / stack_max açılıştan beri (diag.cpp yığın boyası)
+ *********************************************************************/
+void mqttPublishDiag()
+{
+    if (!mqttClient.connected()) return;
 
-        doc["device_class"]        = "energy";
-        doc["state_class"]         = "total_increasing";
-        doc["unit_of_measurement"] = "Wh";
-        doc["name"]                = String("Y") + ch + " Energy";
-        doc["state_topic"]         = String(FLOOR_ID) + "/Y" + ch + "/energy";
-        doc["unique_id"]           = String(FLOOR_ID) + "_ener_Y" + ch;
+    char topic[32], payload[72];
+    MQTT_FITS(topic, payload);
+    snprintf_P(topic, sizeof(topic), PSTR("%s/diag/ram"), FLOOR_ID);
+    snprintf_P(payload, sizeof(payload),
+               PSTR("{\"free\":%u,\"min_free\":%u,\"stack_max\":%u,\"heap\":%u}"),
+               diagFreeRam(), diagMinFreeRam(), diagStackMax(), diagHeapUsed());
+    mqttClient.publish(topic, payload);
+}
 
-        snprintf(topic,sizeof(topic),
-                 "homeassistant/sensor/%s/Y%u_energy/config", FLOOR_ID, ch);
-        serializeJson(doc, payload, sizeof(payload));
-        mqttClient.publish(topic, payload, true);
+#if WAVE_CAPTURE
+/*********************************************************************
+ *  📈 Dalga biçimi   <FLOOR_ID>/wave/set   (wave_capture.cpp)
+ *  yük: "<kanallar>[:zc | :lvl<LSB>]" | "stop"
+ *    kanallar: "Y5" | "Y0,Y4,Y8" | "all"   (ilk kanal tetik kanalı)
+ *    "Y5"           → WAVE_SAMPLES örnek, CS_SAMPLE_HZ, hemen
+ *    "Y5:zc"        → yükselen sıfır geçişinde, öncesi WAVE_SAMPLES/4
+ *                     (tetiğe kadar ISR normal sırada: kanal başına ~333 Hz)
+ *    "Y0,Y4:lvl200" → Y0’da |i| ≥ 200 LSB (≈9.8 A); tetikten sonra iki kanal, yarı hız
+ *  Sonuç <FLOOR_ID>/diag/wave’e ikili parçalar (mqttServiceWave):
+ *    her parça  [sıra][toplam][id L][id H] …
+ *    sıra 0     ver=2, flags, mask, hz, n, start, pre (16 bit LE),
+ *               firstCh, trigCh, scan (16 bit LE: tetik öncesi ISR sırası),
+ *               maskedeki her kanalın ofseti (16 bit LE)
+ *    sıra 1‥    10 bit paketli halka tamponundan WAVE_CHUNK byte
+ *  Çözümleme / çizim: tools/wave_plot.py
+ *********************************************************************/
+static void cmdWaveSet(const char* arg)
+{
+    if (strcmp_P(arg, PSTR("stop")) == 0) { waveAbort(); LOG_I("wave: durduruldu"); return; }
+
+    uint16_t    mask = 0;
+    int8_t      trig = -1;
+    const char* p    = arg;
+    char*       end;
+    if (strncmp_P(p, PSTR("all"), 3) == 0) {
+        for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++) {
+            if (!hasCurrentSensor(ch)) continue;
+            mask |= 1U << ch;
+            if (trig < 0) trig = ch;
+        }
+        p += 3;
+    } else {
+        for (;;) {
+            unsigned long ch = (*p == 'Y') ? strtoul(p + 1, &end, 10) : NUM_Y_CHANNELS;
+            if (*p != 'Y' || end == p + 1 || ch >= NUM_Y_CHANNELS) { LOG_W("wave/set: Y<n>"); return; }
+            mask |= 1U << ch;
+            if (trig < 0) trig = ch;
+            p = end;
+            if (*p != ',') break;
+            p++;
+        }
+    }
+
+    WaveTrig mode  = WAVE_TRIG_NONE;
+    uint16_t level = 0;
+    if (*p == ':') {
+        p++;
+        if (strcmp_P(p, PSTR("zc")) == 0) {
+            mode = WAVE_TRIG_ZC;
+            p += 2;
+        } else if (strncmp_P(p, PSTR("lvl"), 3) == 0) {
+            unsigned long lv = strtoul(p + 3, &end, 10);
+            if (end == p + 3 || lv == 0 || lv > 511) { LOG_W("wave/set: lvl"); return; }
+            mode  = WAVE_TRIG_LEVEL;
+            level = lv;
+            p     = end;
+        }
     }
+    if (*p != '\0') { LOG_W("wave/set: fazla karakter"); return; }
+
+    if (!waveArm(mask, trig, mode, level)) { LOG_W("wave/set: sensorsuz kanal / mesgul"); return; }
+    LOG_I("wave: 0x%04X tetik %u", mask, mode);
 }
+#endif
+
+struct MqttCmd {
+    PGM_P topic;                     // FLOOR_ID/ sonrası, tam eşleşme
+    void (*fn)(const char* arg);     // arg: \0 ile biten yük
+    void (*raw)(const byte* payload, unsigned int len);  // ≠ nullptr → kopyasız
+};
 
+static const char tOutputsSet[] PROGMEM = "outputs/set";
+static const char tSceneSet[]   PROGMEM = "scene/set";
+static const char tSceneDef[]   PROGMEM = "scene/define";
+static const char tRulesSet[]   PROGMEM = "rules/set";
+static const char tTimeSet[]    PROGMEM = "time/set";
+static const char tProfileSet[] PROGMEM = "profile/set";
+static const char tBudgetSet[]  PROGMEM = "budget/set";
+static const char tPrioSet[]    PROGMEM = "priority/set";
+static const char tDiscHash[]   PROGMEM = "discovery_hash";
+#if WAVE_CAPTURE
+static const char tWaveSet[]    PROGMEM = "wave/set";
+#endif
 
+static const MqttCmd cmdTable[] PROGMEM = {
+    { tOutputsSet, cmdOutputsSet,  nullptr     },
+    { tSceneSet,   cmdSceneSet,    nullptr     },
+    { tSceneDef,   cmdSceneDefine, nullptr     },
+    { tRulesSet,   nullptr,        cmdRulesSet },
+    { tTimeSet,    cmdTimeSet,     nullptr     },
+    { tProfileSet, cmdProfileSet,  nullptr     },
+    { tBudgetSet,  cmdBudgetSet,   nullptr     },
+    { tPrioSet,    cmdPrioritySet, nullptr     },
+    { tDiscHash,   nullptr,        cmdDiscoveryHash },
+#if WAVE_CAPTURE
+    { tWaveSet,    cmdWaveSet,     nullptr     },
+#endif
+};
+static const uint8_t CMD_COUNT = sizeof(cmdTable) / sizeof(cmdTable[0]);
 
 static void callback(char* topic, byte* payload, unsigned int len)
 {
-    /* -------- 1) alias'ı ayıkla (X10/Y7) -------- */
-    char* p = strchr(topic,'/');      if (!p) return;
-    char* alias  = ++p;               // "X10/set"
-    char* slash2 = strchr(alias,'/'); if (!slash2) return;
-    *slash2 = '\0';                   // alias = "X10"
-
-    char type = alias[0];             // 'X' ya da 'Y'
-    uint8_t num = atoi(alias+1);      // 0-15
-    uint8_t idx = (type=='Y') ? num : 16+num;   // pinState dizin
-
-    /* -------- 2) ON / OFF belirle -------- */
-    bool on = (len>1 && payload[1]=='N');       // "ON" → true, "OFF" → false
-
-    /* -------- 3) Aşırı ısınma kilidi -------- */
-    if (type=='Y') {                            // yalnız Y-grubu modüller
-        uint8_t modNo = num / 4;                // 4 çıkış = 1 modül
-        if (moduleLocked[modNo] && on) {        // kilitliyken ON isteği
-            char msg[48]; snprintf(msg, 48, "%s: kilit devam ediyor", alias);
-            haNotify("Komut Reddedildi", msg);
-            return;                             // komutu YOK SAY
-        }
+    /* -------- 1) <FLOOR_ID>/ önekini ayıkla -------- */
+    const char* cmd = mqttCmdStrip(FLOOR_ID, topic);
+    if (!cmd) return;
+
+    /* -------- 2) Komut tablosu -------- */
+    const MqttCmd* hit = nullptr;
+    MqttCmd c;
+    for (uint8_t i = 0; i < CMD_COUNT; ++i) {
+        memcpy_P(&c, &cmdTable[i], sizeof(c));
+        if (strcmp_P(cmd, c.topic) == 0) { hit = &c; break; }
     }
+    if (hit && hit->raw) { hit->raw(payload, len); return; }
 
-    /* -------- 4) Donanım pinini sür -------- */
-    uint8_t hwPin = (type=='Y') ? yMap[num] : xMap[num];
-    digitalWrite(hwPin, on);
+    char arg[CMD_PAYLOAD_MAX];
+    if (!copyPayload(arg, sizeof(arg), payload, len)) { LOG_W("Yuk cok uzun"); return; }
 
-    /* -------- 5) Durum dizilerini güncelle -------- */
-    pinState[idx] = on;
-    dirty[idx]    = true;                       // MQTT publish kuyruğu
+    if (hit) { hit->fn(arg); return; }
+
+    /* -------- 3) Y<n>/set, X<n>/set -------- */
+    int8_t idx = mqttCmdOutputIdx(cmd);
+    if (idx >= 0) handleOutputSet(idx, arg);
 }
 
 void mqttInit()
 {
   Ethernet.begin(MAC);                 // DHCP
-  mqttClient.setServer(broker,1883);
+  mqttClient.setServer(broker, MQTT_PORT);
   mqttClient.setCallback(callback);
 }
 
+/*  Broker yokken kart kilitlenmesin: her çağrıda EN FAZLA bir bağlanma
+ *  denemesi, denemeler arası MQTT_RETRY_MS. Döngü (kurallar, fan FSM’i,
+ *  akım ölçümü) bu sırada çalışmaya devam eder. */
+#define MQTT_RETRY_MS 5000
+static uint32_t tLastConnect = 0;
+static bool     everTried    = false;
+
 void reconnect()
 {
-    // Availability konusunu tek satırda oluşturuyoruz
-    String lwtTopic = String(FLOOR_ID) + "/status";
-
-    while (!mqttClient.connected()) {
-        if (mqttClient.connect(
-                FLOOR_ID,                  // Client ID
-                MQTT_USER, MQTT_PASS,      // Kullanıcı / Parola
-                lwtTopic.c_str(), 0, true, // LWT topic
-                "offline"))                // LWT mesajı
-        {
-            mqttClient.publish(lwtTopic.c_str(), "online", true);
-            mqttPublishDiscovery();
-            mqttClient.subscribe( (String(FLOOR_ID) + "/+/set").c_str() );
-        } else {
-            //delay(500);
-        }
+    if (everTried && millis() - tLastConnect < MQTT_RETRY_MS) return;
+    everTried    = true;
+    tLastConnect = millis();
+
+    // Availability (LWT) konusu
+    char lwtTopic[32];
+    mqttStatusTopic(FLOOR_ID, lwtTopic, sizeof(lwtTopic));
+
+    if (mqttClient.connect(
+            FLOOR_ID,                  // Client ID
+            MQTT_USER, MQTT_PASS,      // Kullanıcı / Parola
+            lwtTopic, 0, true,         // LWT topic
+            "offline"))                // LWT mesajı
+    {
+        LOG_I("MQTT baglandi");
+        mqttClient.publish(lwtTopic, "online", true);
+        discoveryOnConnect();          // discovery yalnız özet tutmazsa
+        publishCrash();                // önceki WDT resetinin kaydı varsa
+
+        char filter[40];
+        mqttCommandFilter(FLOOR_ID, filter, sizeof(filter));
+        mqttClient.subscribe(filter);
+        snprintf_P(filter, sizeof(filter), PSTR("%s/scene/define"), FLOOR_ID);
+        mqttClient.subscribe(filter);
+#if CS_HARMONICS
+        lsMarkAllDirty();              // retained imza durumlarını tazele
+#endif
+    } else {
+        LOG_W("MQTT baglanamadi (rc=%d)", mqttClient.state());
     }
 }
 
+/*********************************************************************
+ *  ⏪ Çevrimdışı tampon geri oynatma
+ *  topic  : <FLOOR_ID>/replay   (retained değil)
+ *  payload: {"clk":"epoch"|"up","ev":[[ts,"p",ch,W],[ts,"e",ch,0.1Wh],
+ *                                     [ts,"a",mod,0.1°C],[ts,"r",mod,0.1°C]]}
+ *  – REPLAY_PERIOD_MS’de bir en çok TB_REPLAY_BATCH olay (paketi
+ *    tbReplay kurar, yalnız yayın başarılıysa siler),
+ *  – Bekleyen state publish’i varsa o tur atlanır (canlı trafik önce).
+ *********************************************************************/
+#define REPLAY_PERIOD_MS 250
+
+static bool statePending()
+{
+    for (uint8_t i = 0; i < 32; i++) if (dirty[i]) return true;
+    return false;
+}
+
+static bool replayPublish(const char* payload)
+{
+    char topic[32];
+    MQTT_FITS(topic, char[TB_REPLAY_PAYLOAD]);
+    snprintf_P(topic, sizeof(topic), PSTR("%s/replay"), FLOOR_ID);
+    if (mqttClient.publish(topic, payload)) return true;
+    LOG_W("replay publish basarisiz (%u olay bekliyor)", tbPending());
+    return false;
+}
+
+static void mqttServiceReplay()
+{
+    static uint32_t tReplay = 0;
+    if (millis() - tReplay < REPLAY_PERIOD_MS) return;
+    tReplay = millis();
+    if (statePending()) return;
+    tbReplay(replayPublish);
+}
+
+#if CS_HARMONICS
+/*********************************************************************
+ *  🧬 Yük imzası   (load_signature.cpp, retained)
+ *  <FLOOR_ID>/Y<n>/thd      "12"
+ *  <FLOOR_ID>/Y<n>/load     "off" | "resistive" | "inductive" | "electronic"
+ *  <FLOOR_ID>/Y<n>/anomaly  {"state":"ON","why":"drift","i1":1.23,"base":2.40,
+ *                            "thd":12,"r3":10,"r5":5}
+ *  Değişen kanallardan tur başına en çok biri; state kuyruğu önce.
+ *********************************************************************/
+static const char lsClassNames[][11] PROGMEM = { "off", "resistive", "inductive", "electronic" };
+static const char lsWhyNames[][6]    PROGMEM = { "none", "drift", "open" };
+
+static void mqttServiceSignatures()
+{
+    if (statePending()) return;
+    int8_t ch = lsTakeDirty();
+    if (ch < 0) return;
+
+    char topic[40], buf[112];
+    MQTT_FITS(topic, buf);
+    snprintf_P(buf, sizeof(buf), PSTR("%u"), lsThd(ch));
+    mqttSignatureTopic(FLOOR_ID, ch, MQTT_SIG_THD, topic, sizeof(topic));
+    mqttClient.publish(topic, buf, true);
+
+    strncpy_P(buf, lsClassNames[lsClass(ch) & 3], sizeof(buf));
+    mqttSignatureTopic(FLOOR_ID, ch, MQTT_SIG_LOAD, topic, sizeof(topic));
+    mqttClient.publish(topic, buf, true);
+
+    uint8_t  why  = lsAnomaly(ch);
+    uint16_t i1   = lsFundamentalCA(ch);
+    uint16_t base = lsBaselineCA(ch);
+    char why_s[6];
+    strncpy_P(why_s, lsWhyNames[why % 3], sizeof(why_s));
+    snprintf_P(buf, sizeof(buf),
+               PSTR("{\"state\":\"%s\",\"why\":\"%s\",\"i1\":%u.%02u,\"base\":%u.%02u,"
+                    "\"thd\":%u,\"r3\":%u,\"r5\":%u}"),
+               why ? "ON" : "OFF", why_s, i1 / 100, i1 % 100, base / 100, base % 100,
+               lsThd(ch), lsRatio(ch, 3), lsRatio(ch, 5));
+    mqttSignatureTopic(FLOOR_ID, ch, MQTT_SIG_ANOMALY, topic, sizeof(topic));
+    mqttClient.publish(topic, buf, true);
+}
+#endif
+
+/*********************************************************************
+ *  ⚡ Güç bütçesi   (power_budget.cpp)
+ *  <FLOOR_ID>/power/event  {"ev":"shed","out":"Y4","w":2100,"total":3400,
+ *                           "budget":3500,"prio":2}
+ *                          ev: "shed" | "restore" | "over" (atılacak yük yok)
+ *  <FLOOR_ID>/power/state  {"total":3400,"budget":3500,"shed":16}  (retained,
+ *                          10 s’de bir + her olayda; shed: bit n = Y<n>)
+ *  Olaylar kopukken power_budget.cpp’nin halkasında bekler; tur başına biri.
+ *********************************************************************/
+static const char pbEvNames[][8] PROGMEM = { "?", "shed", "restore", "over" };
+
+static void publishPowerState()
+{
+    char topic[32], payload[56];
+    MQTT_FITS(topic, payload);
+    snprintf_P(topic, sizeof(topic), PSTR("%s/power/state"), FLOOR_ID);
+    snprintf_P(payload, sizeof(payload), PSTR("{\"total\":%u,\"budget\":%u,\"shed\":%u}"),
+               pbTotalW(), pbBudgetW(), pbShedMask());
+    mqttClient.publish(topic, payload, true);
+}
+
+static void mqttServicePower()
+{
+    if (statePending()) return;
+    PbEvent ev;
+    if (!pbPeekEvent(ev)) return;
+
+    char name[8];
+    strncpy_P(name, pbEvNames[ev.kind < 4 ? ev.kind : 0], sizeof(name));
+
+    char topic[32], payload[112];
+    MQTT_FITS(topic, payload);
+    snprintf_P(topic, sizeof(topic), PSTR("%s/power/event"), FLOOR_ID);
+    if (ev.kind == PB_EV_OVER)
+        snprintf_P(payload, sizeof(payload), PSTR("{\"ev\":\"%s\",\"total\":%u,\"budget\":%u}"),
+                   name, ev.totalW, pbBudgetW());
+    else
+        snprintf_P(payload, sizeof(payload),
+                   PSTR("{\"ev\":\"%s\",\"out\":\"Y%u\",\"w\":%u,\"total\":%u,"
+                        "\"budget\":%u,\"prio\":%u}"),
+                   name, ev.ch, ev.chW, ev.totalW, pbBudgetW(), pbPriority(ev.ch));
+    if (!mqttClient.publish(topic, payload)) return;   // olay halkada kalır, sonra yeniden
+    pbPopEvent();
+    publishPowerState();
+
+    if (ev.kind == PB_EV_SHED) {
+        char msg[48];
+        snprintf_P(msg, sizeof(msg), PSTR("Y%u (%u W) kapatildi, butce %u W"),
+                   ev.ch, ev.chW, pbBudgetW());
+        haNotify("Yük Atıldı", msg);
+    } else if (ev.kind == PB_EV_OVER) {
+        haNotify("Güç Bütçesi Aşıldı", "Atılabilecek çıkış kalmadı");
+    }
+}
+
+#if WAVE_CAPTURE
+/*  Biten yakalamayı <FLOOR_ID>/diag/wave’e akıt: WAVE_CHUNK_MS’de bir
+ *  parça, bekleyen state varsa o tur atlanır (replay ile aynı kural).
+ *  Yayın başarısızsa parça sonraki turda tekrar denenir. */
+#define WAVE_TOTAL (1 + (WAVE_BYTES + WAVE_CHUNK - 1) / WAVE_CHUNK)
+static_assert(WAVE_TOTAL <= 255, "WAVE_CHUNK cok kucuk");
+
+static uint8_t  waveSeq = 0;                // sıradaki parça, 0 = başlık
+static uint32_t tWave   = 0;
+
+static uint8_t putLE16(uint8_t* p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    return 2;
+}
+
+static void mqttServiceWave()
+{
+    if (wavePoll() != WAVE_DONE) { waveSeq = 0; return; }
+    if (statePending() || millis() - tWave < WAVE_CHUNK_MS) return;
+
+    WaveInfo w;
+    waveInfo(w);
+
+    char    topic[32];
+    uint8_t pkt[4 + WAVE_CHUNK];
+    MQTT_FITS(topic, pkt);
+    static_assert(4 + 16 + 2 * NUM_Y_CHANNELS <= sizeof(pkt), "wave basligi parcaya sigmiyor");
+    snprintf_P(topic, sizeof(topic), PSTR("%s/diag/wave"), FLOOR_ID);
+
+    uint8_t n = 0;
+    pkt[n++] = waveSeq;
+    pkt[n++] = WAVE_TOTAL;
+    n += putLE16(pkt + n, w.id);
+    if (waveSeq == 0) {
+        pkt[n++] = 2;                                   // biçim sürümü
+        pkt[n++] = w.flags;
+        n += putLE16(pkt + n, w.mask);
+        n += putLE16(pkt + n, CS_SAMPLE_HZ);
+        n += putLE16(pkt + n, WAVE_SAMPLES);
+        n += putLE16(pkt + n, w.start);
+        n += putLE16(pkt + n, w.pre);
+        pkt[n++] = w.firstCh;
+        pkt[n++] = w.trigCh;
+        n += putLE16(pkt + n, w.scan);
+        for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++)
+            if (w.mask & (1U << ch)) n += putLE16(pkt + n, getOffsetADC(ch));
+    } else {
+        uint16_t off = (uint16_t)(waveSeq - 1) * WAVE_CHUNK;
+        uint8_t  len = min(WAVE_CHUNK, WAVE_BYTES - off);
+        memcpy(pkt + n, waveData() + off, len);
+        n += len;
+    }
+
+    tWave = millis();
+    if (!mqttClient.publish(topic, pkt, n, false)) return;
+    if (++waveSeq < WAVE_TOTAL) return;
+    waveSeq = 0;
+    waveRelease();
+    LOG_I("wave %u: %u parca gonderildi", w.id, WAVE_TOTAL);
+}
+#endif
+
 void mqttLoop()
 {
   if (!mqttClient.connected()) reconnect();
   mqttClient.loop();
+  if (mqttClient.connected()) {
+      mqttServiceDiscovery();
+      mqttServiceReplay();
+      mqttServicePower();
+#if WAVE_CAPTURE
+      mqttServiceWave();
+#endif
+#if CS_HARMONICS
+      mqttServiceSignatures();
+#endif
+  }
 }
 
 void mqttProcessStateQueue()
@@ -136,58 +1135,18 @@ void mqttProcessStateQueue()
         if (dirty[i] && mqttClient.connected()) {
             dirty[i] = false;
 
-            /* --- DÜZELTİLEN KISIM --- */
-            char alias[4];
-            if (i < 16)  sprintf(alias, "Y%u", i);      // Y0 … Y15
-            else         sprintf(alias, "X%u", i - 16); // X0 … X15
-            /* -------------------------------- */
-
             char topic[32];
-            sprintf(topic, "%s/%s/state", FLOOR_ID, alias);
+            mqttStateTopic(FLOOR_ID, i, topic, sizeof(topic));  // up32/Y3/state
             mqttClient.publish(topic, pinState[i] ? "ON" : "OFF", true);
             break;                     // Döngü başına 1 paket
         }
     }
 }
 
-void mqttPublishDiscovery()
+/** Açılışta, bağlanmadan önce: tüm blokların özeti (WDT henüz kapalı) */
+void mqttDiscoveryInit()
 {
-  StaticJsonDocument<768> doc;
-  JsonObject dev = doc.createNestedObject("device");
-  dev["identifiers"][0] = FLOOR_ID;
-  dev["name"]        = "Merisoft Kontrol Kartı";
-  dev["model"]       = "Mega+ENC28J60";
-  dev["manufacturer"]= "Merisoft";
-  dev["sw_version"]  = "0.1";
-
-  char topic[64];
-  char payload[768];
-
-  for (uint8_t i = 0; i < 32; i++) {
-      doc["name"]          = (i < 16) ? String("Y") + i   : String("X") + (i-16);
-      doc["command_topic"] = String(FLOOR_ID) + "/" + ((i<16)?"Y":"X") + String(i%16, DEC) + "/set";
-      doc["state_topic"]   = String(FLOOR_ID) + "/" + ((i<16)?"Y":"X") + String(i%16, DEC) + "/state";
-      doc["unique_id"]     = String(FLOOR_ID) + "_" + ((i<16)?"Y":"X") + String(i%16, DEC);
-      doc["payload_on"]    = "ON";
-      doc["payload_off"]   = "OFF";
-
-      snprintf(topic, sizeof(topic),
-               "homeassistant/switch/%s_%c%02u/config",
-               FLOOR_ID, (i<16?'Y':'X'), i%16);
-
-      size_t len = serializeJson(doc, payload, sizeof(payload));
-      mqttClient.publish(topic, (uint8_t*)payload, len, true);
-
-      doc.clear();                       // sıradaki döngü için temizle
-      dev = doc.createNestedObject("device");   // “device” bloğunu tekrar ekle
-      dev["identifiers"][0] = FLOOR_ID;
-      dev["name"]        = "Merisoft Kontrol Kartı";
-      dev["model"]       = "Mega+ENC28J60";
-      dev["manufacturer"]= "Merisoft";
-      dev["sw_version"]  = "0.1";
-  }
-
-  publishPowerEnergyDiscovery();
+  for (uint8_t b = 0; b < DISC_BLOCKS; b++) discoveryHashBlock(b);
 }
 
 /*********************************************************************
@@ -203,48 +1162,55 @@ void mqttPublishDiscovery()
  *********************************************************************/
 void mqttPublishAlert(uint8_t mod, float deg, bool closed)
 {
-    StaticJsonDocument<128> doc;
+    if (!mqttClient.connected()) {          // kopuk → EEPROM, bağlanınca replay
+        tbStoreAlert(mod, deg, closed);
+        return;
+    }
+
+    StaticJsonDocument<JSON_OBJECT_SIZE(3)> doc;
     doc["module"] = mod;
     doc["temp"]   = deg;
     doc["state"]  = closed ? "off" : "restored";
 
-    char topic[48];
-    sprintf(topic, "%s/alert", FLOOR_ID);   // ör. up32/alert
+    char topic[32];
+    snprintf_P(topic, sizeof(topic), PSTR("%s/alert"), FLOOR_ID);   // ör. up32/alert
 
-    char payload[128];
-    serializeJson(doc, payload);
-
-    mqttClient.publish(topic, payload, true); // retained mesaj
+    publishJson(topic, doc, true);            // retained mesaj
 }
 
 void haNotify(const char* title, const char* message)
 {
-    StaticJsonDocument<128> doc;
-    doc["title"]   = title;
+    StaticJsonDocument<JSON_OBJECT_SIZE(2)> doc;
+    doc["title"]   = title;          // const char* → kopyalanmaz
     doc["message"] = message;
-    char payload[128]; serializeJson(doc, payload);
 
-    mqttClient.publish(
-      "homeassistant/service/persistent_notification/create",
-      payload,         // non-retained
-      false
-    );
+    publishJson("homeassistant/service/persistent_notification/create",
+                doc, false);         // non-retained
 }
 
 void mqttPublishPowerEnergy()
 {
+    if (!mqttClient.connected()) {          // kopuk → RAM halkasına
+        tbRecordTelemetry();
+        return;
+    }
+    tbSyncBaseline();
+    publishPowerState();
+
+#if TELEMETRY_FIXED
     char topic[40];
     char buf[16];
 
-    for (uint8_t ch = 0; ch < 16; ch++) {
+    for (uint8_t ch = 0; ch < MQTT_SENSOR_CHANNELS; ch++) {
         /* --- Power (W) --- */
-        dtostrf(Y_powerW[ch] , 0, 1, buf);
-        sprintf(topic, "%s/Y%u/power",  FLOOR_ID, ch);
+        mqttFormatValue(Y_powerW[ch], 1, buf, sizeof(buf));
+        mqttTelemetryTopic(FLOOR_ID, ch, false, topic, sizeof(topic));
         mqttClient.publish(topic, buf);
 
         /* --- Energy (Wh) --- */
-        dtostrf(Y_energyWh[ch], 0, 2, buf);
-        sprintf(topic, "%s/Y%u/energy", FLOOR_ID, ch);
+        mqttFormatValue(Y_energyWh[ch], 2, buf, sizeof(buf));
+        mqttTelemetryTopic(FLOOR_ID, ch, true, topic, sizeof(topic));
         mqttClient.publish(topic, buf);
     }
+#endif
 }
\ No newline at end of file
@@ -3,8 +3,10 @@
 void mqttInit();
 void mqttLoop();
 bool mqttConnected();
-void mqttPublishDiscovery();
+void mqttDiscoveryInit();      // discovery özeti (açılışta bir kez)
 void mqttProcessStateQueue();   // dirty[] dizisini publish eder
 void mqttPublishAlert(uint8_t mod, float deg, bool closed);
 void haNotify(const char* title, const char* message);
-void mqttPublishPowerEnergy();   // anlık W + kümülatif Wh
\ No newline at end of file
+void mqttPublishPowerEnergy();   // anlık W + kümülatif Wh
+void mqttPublishDiag();          // <FLOOR_ID>/diag/ram
+void mqttPublishStats();         // <FLOOR_ID>/stats  (kanal özeti)
\ No newline at end of file
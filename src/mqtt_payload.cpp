@@ -0,0 +1,340 @@
+/**
+ * mqtt_payload.cpp — MQTT konu / yük üreticileri
+ * ------------------------------------------------------------
+ *  › mqtt_haberlesme.cpp’deki String birleştirmeli discovery kodu buraya
+ *    taşındı; artık snprintf + sabit tamponlar, heap yok. Üreticiler
+ *    çağıranın JsonDocument’ını doldurur, yük tamponu tutmaz.
+ *  › Kartta ve tools/fleet_sim’de birebir aynı yükler üretilir →
+ *    simülatörün ölçtüğü byte / mesaj sayısı gerçek kartınkiyle aynıdır.
+ *  › Discovery sırası:  0‥31 switch (Y0‥Y15, X0‥X15),
+ *                      32‥47 Y<n> güç,  48‥63 Y<n> enerji.
+ *    Yük imzası varlıkları (CS_HARMONICS) ayrı: mqttSignatureItem(),
+ *    kanal istatistikleri: mqttStatsItem().
+ *  › MQTT-SN konu numaraları (mqttSnTopicId / mqttSnTopicName) da burada:
+ *    kart, fleet_sim --sn ve gateway aynı tabloyu görür.
+ *  › Discovery özeti (mqttDiscHashText / mqttDiscStale): kart yalnız
+ *    broker’daki retained özetle tutmayan blokları yeniden yayınlar.
+ * ------------------------------------------------------------*/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <stdio.h>
+#include <string.h>
+#endif
+#include <ArduinoJson.h>
+#include "mqtt_payload.h"
+
+static inline char aliasType(uint8_t idx) { return (idx < 16) ? 'Y' : 'X'; }
+
+static void addDevice(JsonDocument& doc, const char* floorId, bool full)
+{
+    JsonObject dev = doc.createNestedObject("device");
+    dev["identifiers"][0] = floorId;
+    if (!full) return;
+    dev["name"]        = "Merisoft Kontrol Kartı";
+    dev["model"]       = "Mega+ENC28J60";
+    dev["manufacturer"]= "Merisoft";
+    dev["sw_version"]  = "0.1";
+}
+
+static void switchConfig(const char* floorId, uint8_t i,
+                         char* topic, size_t topicLen, JsonDocument& doc)
+{
+    char name[4], cmdT[40], stateT[40], uid[32];
+    snprintf(name,   sizeof(name),   "%c%u", aliasType(i), i % 16);
+    snprintf(cmdT,   sizeof(cmdT),   "%s/%s/set",   floorId, name);
+    snprintf(stateT, sizeof(stateT), "%s/%s/state", floorId, name);
+    snprintf(uid,    sizeof(uid),    "%s_%s",       floorId, name);
+
+    addDevice(doc, floorId, true);
+    doc["name"]          = name;
+    doc["command_topic"] = cmdT;
+    doc["state_topic"]   = stateT;
+    doc["unique_id"]     = uid;
+    doc["payload_on"]    = "ON";
+    doc["payload_off"]   = "OFF";
+
+    snprintf(topic, topicLen, "homeassistant/switch/%s_%c%02u/config",
+             floorId, aliasType(i), i % 16);
+}
+
+static void sensorConfig(const char* floorId, uint8_t ch, bool energy,
+                         char* topic, size_t topicLen, JsonDocument& doc)
+{
+    char name[16], stateT[40], uid[32];
+    snprintf(name, sizeof(name), "Y%u %s", ch, energy ? "Energy" : "Power");
+    mqttTelemetryTopic(floorId, ch, energy, stateT, sizeof(stateT));
+    snprintf(uid,  sizeof(uid),  "%s_%s_Y%u", floorId, energy ? "ener" : "pow", ch);
+
+    addDevice(doc, floorId, false);
+    doc["device_class"]        = energy ? "energy" : "power";
+    doc["state_class"]         = energy ? "total_increasing" : "measurement";
+    doc["unit_of_measurement"] = energy ? "Wh" : "W";
+    doc["name"]                = name;
+    doc["state_topic"]         = stateT;
+    doc["unique_id"]           = uid;
+
+    snprintf(topic, topicLen, "homeassistant/sensor/%s/Y%u_%s/config",
+             floorId, ch, energy ? "energy" : "power");
+}
+
+bool mqttDiscoveryItem(const char* floorId, uint8_t i,
+                       char* topic, size_t topicLen, JsonDocument& doc)
+{
+    doc.clear();
+    if (i < MQTT_SWITCH_ITEMS)
+        switchConfig(floorId, i, topic, topicLen, doc);
+    else if (i < MQTT_SWITCH_ITEMS + MQTT_SENSOR_CHANNELS)
+        sensorConfig(floorId, i - MQTT_SWITCH_ITEMS, false, topic, topicLen, doc);
+    else if (i < MQTT_DISCOVERY_ITEMS)
+        sensorConfig(floorId, i - MQTT_SWITCH_ITEMS - MQTT_SENSOR_CHANNELS, true, topic, topicLen, doc);
+    else
+        return false;
+    return !doc.overflowed();
+}
+
+void mqttStateTopic(const char* floorId, uint8_t idx, char* buf, size_t n)
+{
+    snprintf(buf, n, "%s/%c%u/state", floorId, aliasType(idx), idx % 16);
+}
+
+void mqttCommandFilter(const char* floorId, char* buf, size_t n)
+{
+    snprintf(buf, n, "%s/+/set", floorId);
+}
+
+void mqttStatusTopic(const char* floorId, char* buf, size_t n)
+{
+    snprintf(buf, n, "%s/status", floorId);
+}
+
+void mqttTelemetryTopic(const char* floorId, uint8_t ch, bool energy, char* buf, size_t n)
+{
+    snprintf(buf, n, "%s/Y%u/%s", floorId, ch, energy ? "energy" : "power");
+}
+
+size_t mqttFormatValue(float v, uint8_t prec, char* buf, size_t n)
+{
+#ifdef ARDUINO
+    (void)n;
+    dtostrf(v, 0, prec, buf);               // AVR printf’inde %f yok
+    return strlen(buf);
+#else
+    return snprintf(buf, n, "%.*f", prec, (double)v);
+#endif
+}
+
+static const char* const sigName[MQTT_SIG_KINDS] = { "thd", "load", "anomaly" };
+
+void mqttSignatureTopic(const char* floorId, uint8_t ch, uint8_t kind, char* buf, size_t n)
+{
+    snprintf(buf, n, "%s/Y%u/%s", floorId, ch, sigName[kind % MQTT_SIG_KINDS]);
+}
+
+bool mqttSignatureItem(const char* floorId, uint8_t ch, uint8_t kind,
+                       char* topic, size_t topicLen, JsonDocument& doc)
+{
+    if (kind >= MQTT_SIG_KINDS) return false;
+    doc.clear();
+
+    char name[16], stateT[40], uid[32];
+    snprintf(name, sizeof(name), "Y%u %s", ch, sigName[kind]);
+    mqttSignatureTopic(floorId, ch, kind, stateT, sizeof(stateT));
+    snprintf(uid,  sizeof(uid),  "%s_%s_Y%u", floorId, sigName[kind], ch);
+
+    addDevice(doc, floorId, false);
+    doc["name"]        = name;
+    doc["state_topic"] = stateT;
+    doc["unique_id"]   = uid;
+    if (kind == MQTT_SIG_THD) {
+        doc["unit_of_measurement"] = "%";
+        doc["state_class"]         = "measurement";
+    } else if (kind == MQTT_SIG_ANOMALY) {
+        doc["device_class"]          = "problem";
+        doc["value_template"]        = "{{ value_json.state }}";
+        doc["json_attributes_topic"] = stateT;
+    }
+
+    snprintf(topic, topicLen, "homeassistant/%s/%s/Y%u_%s/config",
+             kind == MQTT_SIG_ANOMALY ? "binary_sensor" : "sensor",
+             floorId, ch, sigName[kind]);
+    return !doc.overflowed();
+}
+
+void mqttStatsTopic(const char* floorId, char* buf, size_t n)
+{
+    snprintf(buf, n, "%s/stats", floorId);
+}
+
+bool mqttStatsItem(const char* floorId, uint8_t ch,
+                   char* topic, size_t topicLen, JsonDocument& doc)
+{
+    doc.clear();
+
+    char name[12], stateT[24], uid[24], valT[32], attrT[32];
+    snprintf(name,  sizeof(name),  "Y%u p95", ch);
+    mqttStatsTopic(floorId, stateT, sizeof(stateT));
+    snprintf(uid,   sizeof(uid),   "%s_p95_Y%u", floorId, ch);
+    snprintf(valT,  sizeof(valT),  "{{ value_json.Y%u.p95 }}", ch);
+    snprintf(attrT, sizeof(attrT), "{{ value_json.Y%u | tojson }}", ch);
+
+    addDevice(doc, floorId, false);
+    doc["name"]                     = name;
+    doc["state_topic"]              = stateT;
+    doc["unique_id"]                = uid;
+    doc["device_class"]             = "power";
+    doc["state_class"]              = "measurement";
+    doc["unit_of_measurement"]      = "W";
+    doc["value_template"]           = valT;
+    doc["json_attributes_topic"]    = stateT;
+    doc["json_attributes_template"] = attrT;
+
+    snprintf(topic, topicLen, "homeassistant/sensor/%s/Y%u_p95/config", floorId, ch);
+    return !doc.overflowed();
+}
+
+//--------------------------------------------------------------
+//  Discovery içerik özeti
+//--------------------------------------------------------------
+uint32_t mqttHashAdd(uint32_t h, const void* data, size_t n)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    while (n--) h = (h ^ *p++) * 16777619UL;
+    return h;
+}
+
+size_t mqttDiscHashText(char mode, const uint32_t* block, uint8_t n, char* buf, size_t len)
+{
+    size_t o = snprintf(buf, len, "%c", mode);
+    for (uint8_t k = 0; k < n && o < len; ++k)
+        o += snprintf(buf + o, len - o, " %08lx", (unsigned long)block[k]);
+    return (o < len) ? o : len - 1;
+}
+
+static int8_t hexNibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+uint32_t mqttDiscStale(const char* payload, size_t len, char mode,
+                       const uint32_t* block, uint8_t n)
+{
+    uint32_t all = (n >= 32) ? 0xFFFFFFFFUL : ((1UL << n) - 1);
+    if (len == 0 || payload[0] != mode) return all;  // yok / kip değişti
+
+    uint32_t stale = 0;
+    size_t   p = 1;
+    for (uint8_t k = 0; k < n; ++k) {
+        uint32_t v = 0;
+        bool ok = p + 9 <= len && payload[p] == ' ';
+        for (uint8_t d = 1; ok && d <= 8; ++d) {
+            int8_t x = hexNibble(payload[p + d]);
+            if (x < 0) ok = false;
+            v = (v << 4) | (uint8_t)x;
+        }
+        if (!ok) return stale | (all & ~((1UL << k) - 1));   // kalan bloklar eski
+        if (v != block[k]) stale |= 1UL << k;
+        p += 9;
+    }
+    return stale;
+}
+
+//--------------------------------------------------------------
+//  MQTT-SN önceden tanımlı konular
+//--------------------------------------------------------------
+#ifndef ARDUINO
+#define PROGMEM
+#define strcmp_P  strcmp
+#define strncpy_P strncpy
+#endif
+
+#define SN_FIXED_LEN 15                     // en uzun sonek + \0
+static const char snFixed[][SN_FIXED_LEN] PROGMEM = {
+    "status", "alert", "replay", "stats", "power/state", "power/event",
+    "diag/ram", "diag/crash", "diag/profile",
+    "outputs/set", "scene/set", "scene/define", "rules/set", "time/set",
+    "profile/set", "budget/set", "priority/set", "discovery_hash",
+    "wave/set", "diag/wave",
+};
+#define SN_FIXED_COUNT (sizeof(snFixed) / sizeof(snFixed[0]))
+
+#define SN_ID_ALERT       0x0002
+#define SN_ID_POWER_EVENT 0x0006
+#define SN_ID_DIAG_CRASH  0x0008
+#define SN_ID_STATE       0x0100
+#define SN_ID_SET         0x0200
+#define SN_ID_POWER       0x0300
+#define SN_ID_ENERGY      0x0320
+#define SN_ID_SIGNATURE   0x0400
+
+/** "Y7/…" | "X10/…" → idx (X: 16+), sonrası *rest; aksi -1 */
+static int8_t snAlias(const char* s, const char** rest)
+{
+    if (s[0] != 'Y' && s[0] != 'X') return -1;
+    const char* p = s + 1;
+    if (*p < '0' || *p > '9') return -1;
+    uint8_t num = *p++ - '0';
+    if (*p >= '0' && *p <= '9') {
+        if (num == 0) return -1;
+        num = num * 10 + (*p++ - '0');
+    }
+    if (num > 15 || *p != '/') return -1;
+    *rest = p + 1;
+    return (s[0] == 'Y') ? num : 16 + num;
+}
+
+uint16_t mqttSnTopicId(const char* floorId, const char* topic)
+{
+    size_t n = strlen(floorId);
+    if (strncmp(topic, floorId, n) != 0 || topic[n] != '/') return MQTT_SN_TOPIC_NONE;
+    const char* s = topic + n + 1;
+
+    for (uint8_t i = 0; i < SN_FIXED_COUNT; ++i)
+        if (strcmp_P(s, snFixed[i]) == 0) return 1 + i;
+
+    const char* rest;
+    int8_t idx = snAlias(s, &rest);
+    if (idx < 0) return MQTT_SN_TOPIC_NONE;
+    if (strcmp(rest, "state") == 0) return SN_ID_STATE + idx;
+    if (strcmp(rest, "set")   == 0) return SN_ID_SET   + idx;
+    if (idx >= MQTT_SENSOR_CHANNELS) return MQTT_SN_TOPIC_NONE;
+    if (strcmp(rest, "power")  == 0) return SN_ID_POWER  + idx;
+    if (strcmp(rest, "energy") == 0) return SN_ID_ENERGY + idx;
+    for (uint8_t k = 0; k < MQTT_SIG_KINDS; ++k)
+        if (strcmp(rest, sigName[k]) == 0) return SN_ID_SIGNATURE + 32 * k + idx;
+    return MQTT_SN_TOPIC_NONE;
+}
+
+bool mqttSnTopicName(const char* floorId, uint16_t id, char* buf, size_t n)
+{
+    if (id >= 1 && id <= SN_FIXED_COUNT) {
+        char s[SN_FIXED_LEN] = { 0 };
+        strncpy_P(s, snFixed[id - 1], sizeof(s) - 1);
+        snprintf(buf, n, "%s/%s", floorId, s);
+        return true;
+    }
+    uint8_t lo = id & 0x1F;
+    if ((id & 0xFFE0) == SN_ID_STATE || (id & 0xFFE0) == SN_ID_SET) {
+        snprintf(buf, n, "%s/%c%u/%s", floorId, aliasType(lo), lo % 16,
+                 (id & 0xFFE0) == SN_ID_SET ? "set" : "state");
+        return true;
+    }
+    if ((id & 0xFFF0) == SN_ID_POWER || (id & 0xFFF0) == SN_ID_ENERGY) {
+        mqttTelemetryTopic(floorId, id & 0x0F, (id & 0xFFF0) == SN_ID_ENERGY, buf, n);
+        return true;
+    }
+    if (id >= SN_ID_SIGNATURE && id < SN_ID_SIGNATURE + 32 * MQTT_SIG_KINDS && lo < MQTT_SENSOR_CHANNELS) {
+        mqttSignatureTopic(floorId, lo, (id - SN_ID_SIGNATURE) / 32, buf, n);
+        return true;
+    }
+    return false;
+}
+
+bool mqttSnReliable(uint16_t id)
+{
+    return id == SN_ID_ALERT || id == SN_ID_POWER_EVENT || id == SN_ID_DIAG_CRASH;
+}
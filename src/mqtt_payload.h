@@ -0,0 +1,76 @@
+/**
+ *  mqtt_payload.h
+ *  --------------
+ *  – Home Assistant discovery, state ve telemetri konu/yük üreticileri,
+ *  – Arduino’ya bağımlı değil: FLOOR_ID parametre → aynı kod hem kartta
+ *    (mqtt_haberlesme.cpp) hem Linux’ta (tools/fleet_sim) derlenir.
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+
+#define MQTT_SWITCH_ITEMS     32                      // Y0‥Y15, X0‥X15
+#define MQTT_SENSOR_CHANNELS  16                      // Y0‥Y15 güç + enerji
+#define MQTT_DISCOVERY_ITEMS  (MQTT_SWITCH_ITEMS + 2 * MQTT_SENSOR_CHANNELS)
+#ifdef ARDUINO
+#define MQTT_DISCOVERY_DOC    256                     // JsonDocument kapasitesi (AVR: 8 B/slot)
+#else
+#define MQTT_DISCOVERY_DOC    512                     // 64 bit: 16 B/slot
+#endif
+
+/** i. discovery config’i (0‥MQTT_DISCOVERY_ITEMS-1) doc’a; false → yok / sığmadı.
+    Yük tampona yazılmaz: kart beginPublish + serializeJson ile akıtır. */
+bool   mqttDiscoveryItem(const char* floorId, uint8_t i,
+                         char* topic, size_t topicLen, JsonDocument& doc);
+
+void   mqttStateTopic    (const char* floorId, uint8_t idx, char* buf, size_t n); // <id>/Y3/state
+void   mqttCommandFilter (const char* floorId, char* buf, size_t n);              // <id>/+/set
+void   mqttStatusTopic   (const char* floorId, char* buf, size_t n);              // <id>/status
+void   mqttTelemetryTopic(const char* floorId, uint8_t ch, bool energy,
+                          char* buf, size_t n);                                   // <id>/Y3/power
+size_t mqttFormatValue   (float v, uint8_t prec, char* buf, size_t n);            // "123.4"
+
+/* Yük imzası (CS_HARMONICS, load_signature.cpp) — sensörlü kanal başına 3 varlık */
+#define MQTT_SIG_THD      0                           // sensor, %
+#define MQTT_SIG_LOAD     1                           // sensor, metin
+#define MQTT_SIG_ANOMALY  2                           // binary_sensor (problem) + JSON öznitelik
+#define MQTT_SIG_KINDS    3
+
+void   mqttSignatureTopic(const char* floorId, uint8_t ch, uint8_t kind,
+                          char* buf, size_t n);                                   // <id>/Y3/thd
+bool   mqttSignatureItem (const char* floorId, uint8_t ch, uint8_t kind,
+                          char* topic, size_t topicLen, JsonDocument& doc);
+
+/* Kanal istatistikleri (channel_stats.cpp) — sensörlü kanal başına p95 sensörü,
+   özetin kanal nesnesi öznitelik olarak */
+void   mqttStatsTopic    (const char* floorId, char* buf, size_t n);              // <id>/stats
+bool   mqttStatsItem     (const char* floorId, uint8_t ch,
+                          char* topic, size_t topicLen, JsonDocument& doc);
+
+/* Discovery içerik özeti (mqtt_haberlesme.cpp, tools/fleet_sim).
+   Öğeler MQTT_DISC_BLOCK’luk bloklara bölünür; blok özeti = FNV-1a 32
+   (konu, \0, yük) dizisi. Retained <id>/discovery_hash yükü:
+     "<kip> <blok0> <blok1> …"   kip: 'e' varlık başına, 'd' cihaz config’i
+   Kart bağlanınca bunu okur, yalnız özeti tutmayan blokları yayınlar. */
+#define MQTT_DISC_BLOCK     8
+#define MQTT_HASH_SEED      2166136261UL
+
+uint32_t mqttHashAdd     (uint32_t h, const void* data, size_t n);               // FNV-1a
+size_t   mqttDiscHashText(char mode, const uint32_t* block, uint8_t n,
+                          char* buf, size_t len);                                 // "e 1a2b3c4d …"
+uint32_t mqttDiscStale   (const char* payload, size_t len, char mode,
+                          const uint32_t* block, uint8_t n);                      // bit k → blok k eski
+
+/* MQTT-SN (MQTT_SN=1, mqtt_sn.cpp) önceden tanımlı konu numaraları.
+   Gateway (tools/mqttsn_gw.py) aynı tabloyu kullanır; değişirse ikisi birlikte.
+     0x0001‥0x0014  sabit <id>/… konuları (status, alert, … diag/wave)
+     0x0100 + idx   <id>/{Y|X}<n>/state      0x0200 + idx   <id>/{Y|X}<n>/set
+     0x0300 + ch    <id>/Y<n>/power          0x0320 + ch    <id>/Y<n>/energy
+     0x0400 + 32·kind + ch                   <id>/Y<n>/{thd|load|anomaly}
+   Tabloda olmayanlar (homeassistant/…) bağlantı başına REGISTER ile alınır. */
+#define MQTT_SN_TOPIC_NONE 0x0000
+
+uint16_t mqttSnTopicId  (const char* floorId, const char* topic);                 // 0 → tabloda yok
+bool     mqttSnTopicName(const char* floorId, uint16_t id, char* buf, size_t n);  // false → yok
+bool     mqttSnReliable (uint16_t id);                                            // QoS1 + yeniden deneme
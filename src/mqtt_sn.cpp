@@ -0,0 +1,496 @@
+/**
+ * mqtt_sn.cpp — UDP üzerinden MQTT-SN istemcisi (MQTT_SN=1)
+ * ------------------------------------------------------------
+ *  › Sorun: PubSubClient + UIPEthernet TCP’de her publish ayrı bir
+ *    segment; uIP bağlantı başına tek onaysız segment tuttuğu için bir
+ *    sonraki publish broker’ın ACK’ini bekler. 10 s’de bir 32 telemetri
+ *    mesajı = 32 tur süresi + 32 ACK çerçevesi.
+ *  › Burada her publish tek datagram: 2 + 5 byte başlık + 2 byte konu
+ *    numarası (konu metni yok), ACK yok. Konu numaraları mqtt_payload.cpp
+ *    tablosundan; gateway (tools/mqttsn_gw.py) broker’a tam adla aktarır.
+ *  › Güvenilirlik yalnız gereken yerde:
+ *      – gelen komutlar QoS1: PUBACK + son MsgId’le tekrar eleme,
+ *      – alert / power/event / diag/crash QoS1: yük SN_RELIABLE_SLOTS
+ *        yuvadan birine kopyalanır, PUBACK gelene kadar loop() her
+ *        SN_RETRY_MS’de DUP ile yeniden yollar (bloklamadan),
+ *      – CONNECT (+ will) toplam en çok SN_CONNECT_MS bloklar; süre
+ *        dolarsa vazgeçilir, reconnect() MQTT_RETRY_MS sonra yeniden dener,
+ *      – REGISTER kısa süre bloklayarak REGACK bekler (en çok
+ *        SN_ACK_TRIES × SN_ACK_MS),
+ *      – SUBSCRIBE bloklamaz: süzgeç SN_SUB_SLOTS yuvadan birine kopyalanır,
+ *        SUBACK’i loop() işler, SN_ACK_MS’de bir yeniden yollar;
+ *        yanıtsız REGISTER / SUBSCRIBE bağlantıyı kopuk sayar.
+ *    → ana döngü yavaş ya da sessiz gateway’de de WDT süresinin çok
+ *      altında kalır; bekleme WDT’yi beslemez.
+ *  › Yanıt beklerken gelen başka datagramlar atılır (PUBACK / SUBACK
+ *    hariç): gateway komutları zaten yeniden dener.
+ *  › Gateway’in REGISTER’ı reddedilir (konu adı tutacak tampon yok):
+ *    karta gelen her konu önceden tanımlı olmalı.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "config.h"
+
+#if MQTT_SN
+
+#include "mqtt_sn.h"
+#include "mqtt_payload.h"
+#include "log.h"
+
+/* MQTT-SN 1.2 mesaj tipleri */
+#define SN_CONNECT        0x04
+#define SN_CONNACK        0x05
+#define SN_WILLTOPICREQ   0x06
+#define SN_WILLTOPIC      0x07
+#define SN_WILLMSGREQ     0x08
+#define SN_WILLMSG        0x09
+#define SN_REGISTER       0x0A
+#define SN_REGACK         0x0B
+#define SN_PUBLISH        0x0C
+#define SN_PUBACK         0x0D
+#define SN_SUBSCRIBE      0x12
+#define SN_SUBACK         0x13
+#define SN_PINGREQ        0x16
+#define SN_PINGRESP       0x17
+#define SN_DISCONNECT     0x18
+
+#define SN_FLAG_DUP       0x80
+#define SN_FLAG_QOS1      0x20
+#define SN_FLAG_RETAIN    0x10
+#define SN_FLAG_WILL      0x08
+#define SN_FLAG_CLEAN     0x04
+#define SN_TOPIC_NORMAL   0x00          // REGISTER’la alınmış numara
+#define SN_TOPIC_PREDEF   0x01          // mqttSnTopicId tablosu
+
+#define SN_RC_ACCEPTED      0x00
+#define SN_RC_INVALID_TOPIC 0x02
+#define SN_RC_NOT_SUPPORTED 0x03
+
+#define SN_PROTOCOL_ID    0x01
+#define SN_KEEPALIVE_S    30            // PINGREQ aralığı; 1.5× sessizlik → kopuk
+#define SN_ACK_MS         300           // CONNACK / REGACK / SUBACK bekleme
+#define SN_ACK_TRIES      2
+#define SN_CONNECT_MS     900           // connect() toplam bekleme (will dahil)
+#define SN_RETRY_MS       1000          // QoS1 yeniden gönderme
+#define SN_RETRIES        3
+#define SN_RX_PER_LOOP    4             // loop() başına en çok datagram
+
+static_assert(SN_PACKET_MAX >= 64, "SN_PACKET_MAX cok kucuk");
+
+//--------------------------------------------------------------
+//  YARDIMCILAR
+//--------------------------------------------------------------
+/** FNV-1a — REGISTER önbelleği anahtarı */
+static uint32_t topicHash(const char* s)
+{
+    uint32_t h = 2166136261UL;
+    while (*s) { h ^= (uint8_t)*s++; h *= 16777619UL; }
+    return h;
+}
+
+/** [boy][tip][hdr…][str] tek datagram; tampon yok, parça parça UDP’ye */
+static bool sendParts(EthernetUDP& udp, IPAddress ip, uint16_t port, uint8_t type,
+                      const uint8_t* hdr, uint8_t hdrLen, const char* str = nullptr)
+{
+    size_t sLen = str ? strlen(str) : 0;
+    size_t len  = 2 + hdrLen + sLen;
+    if (len > 255) return false;
+
+    if (!udp.beginPacket(ip, port)) return false;
+    uint8_t head[2] = { (uint8_t)len, type };
+    bool ok = udp.write(head, 2) == 2;
+    if (hdrLen) ok = ok && udp.write(hdr, hdrLen) == hdrLen;
+    if (sLen)   ok = ok && udp.write((const uint8_t*)str, sLen) == sLen;
+    return udp.endPacket() && ok;
+}
+
+//--------------------------------------------------------------
+//  BAĞLANTI
+//--------------------------------------------------------------
+MqttSnClient& MqttSnClient::setServer(IPAddress ip, uint16_t port)
+{
+    gw     = ip;
+    gwPort = port;
+    udp.begin(MQTT_SN_PORT);
+    return *this;
+}
+
+uint16_t MqttSnClient::msgId()
+{
+    if (++nextMsgId == 0) nextMsgId = 1;
+    return nextMsgId;
+}
+
+/** type tipinde yanıt gelene kadar en çok ms bekle (REGACK: MsgId = id olmalı).
+    Arada gelen PUBACK / SUBACK işlenir, diğerleri atılır. */
+bool MqttSnClient::await(uint8_t type, uint16_t id, uint8_t* out, uint8_t outLen, uint16_t ms)
+{
+    uint8_t idOfs = (type == SN_REGACK) ? 4 : 0;
+    uint32_t t0 = millis();
+    while (millis() - t0 < ms) {
+        if (udp.parsePacket() <= 0) continue;
+        uint8_t b[8];
+        int n = udp.read(b, sizeof(b));
+        if (n < 2 || b[0] == 0x01) continue;        // 3 byte’lık boy: yanıt değil
+        tLastRx = millis();
+
+        if (b[1] == SN_PUBACK && n >= 7) onPubAck((b[4] << 8) | b[5], b[6]);
+        if (b[1] == SN_SUBACK && n >= 8) onSubAck((b[5] << 8) | b[6], b[7]);
+        if (b[1] != type) continue;
+        if (idOfs && (n < idOfs + 2 || ((b[idOfs] << 8) | b[idOfs + 1]) != id)) continue;
+        if (out) memcpy(out, b, min((uint8_t)n, outLen));
+        return true;
+    }
+    return false;
+}
+
+/** connect(): SN_CONNECT_MS’den kalan, en çok SN_ACK_MS (0 → süre doldu) */
+static uint16_t connectLeft(uint32_t t0)
+{
+    uint32_t used = millis() - t0;
+    return (used >= SN_CONNECT_MS) ? 0 : min((uint32_t)SN_ACK_MS, SN_CONNECT_MS - used);
+}
+
+bool MqttSnClient::connect(const char* id, const char* user, const char* pass,
+                           const char* willTopic, uint8_t willQos, bool willRetain,
+                           const char* willMsg)
+{
+    (void)user; (void)pass; (void)willQos;
+    st = SN_DISCONNECTED;
+    capture   = nullptr;
+    streaming = false;
+    memset(reg, 0, sizeof(reg));                    // numaralar bağlantıya özel
+    memset(subs, 0, sizeof(subs));
+    lastRxMsgId = 0;                                // gateway MsgId’leri 1’den başlatır
+
+    bool will = willTopic && willMsg;
+    uint8_t hdr[4] = { (uint8_t)(SN_FLAG_CLEAN | (will ? SN_FLAG_WILL : 0)), SN_PROTOCOL_ID,
+                       0, SN_KEEPALIVE_S };
+    uint8_t wflags = willRetain ? SN_FLAG_RETAIN : 0;
+
+    uint32_t t0 = millis();
+    for (uint8_t t = 0; t < SN_ACK_TRIES && connectLeft(t0); ++t) {
+        if (!sendParts(udp, gw, gwPort, SN_CONNECT, hdr, sizeof(hdr), id)) continue;
+        if (will) {
+            if (!await(SN_WILLTOPICREQ, 0, nullptr, 0, connectLeft(t0))) continue;
+            sendParts(udp, gw, gwPort, SN_WILLTOPIC, &wflags, 1, willTopic);
+            if (!await(SN_WILLMSGREQ, 0, nullptr, 0, connectLeft(t0))) continue;
+            sendParts(udp, gw, gwPort, SN_WILLMSG, nullptr, 0, willMsg);
+        }
+        uint8_t r[3];
+        if (!await(SN_CONNACK, 0, r, sizeof(r), connectLeft(t0))) continue;
+        if (r[2] != SN_RC_ACCEPTED) { st = r[2]; return false; }
+
+        st = SN_CONNECTED;
+        tLastRx = tLastPing = millis();
+        return true;
+    }
+    st = SN_CONNECTION_TIMEOUT;
+    return false;
+}
+
+//--------------------------------------------------------------
+//  ABONELİK (bloklamaz)
+//--------------------------------------------------------------
+void MqttSnClient::sendSubscribe(SubPending& s)
+{
+    uint8_t hdr[3] = { SN_FLAG_QOS1 | SN_TOPIC_NORMAL, (uint8_t)(s.msgId >> 8), (uint8_t)s.msgId };
+    sendParts(udp, gw, gwPort, SN_SUBSCRIBE, hdr, sizeof(hdr), s.filter);
+    s.tSent = millis();
+    s.tries++;
+}
+
+bool MqttSnClient::subscribe(const char* filter)
+{
+    if (st != SN_CONNECTED || strlen(filter) >= SN_SUB_MAX) return false;
+    for (uint8_t i = 0; i < SN_SUB_SLOTS; ++i) {
+        SubPending& s = subs[i];
+        if (s.msgId) continue;
+        strcpy(s.filter, filter);
+        s.msgId = msgId();
+        s.tries = 0;
+        sendSubscribe(s);
+        return true;
+    }
+    LOG_W("MQTT-SN: SUBSCRIBE yuvasi yok");
+    return false;
+}
+
+void MqttSnClient::onSubAck(uint16_t id, uint8_t rc)
+{
+    for (uint8_t i = 0; i < SN_SUB_SLOTS; ++i) {
+        if (subs[i].msgId != id) continue;
+        if (rc != SN_RC_ACCEPTED) LOG_W("MQTT-SN: SUBACK rc=%u (%s)", rc, subs[i].filter);
+        subs[i].msgId = 0;
+    }
+}
+
+//--------------------------------------------------------------
+//  KONU NUMARALARI
+//--------------------------------------------------------------
+uint16_t MqttSnClient::registerTopic(const char* topic)
+{
+    uint32_t h = topicHash(topic);
+    for (uint8_t i = 0; i < SN_REG_CACHE; ++i)
+        if (reg[i].id && reg[i].hash == h) return reg[i].id;
+
+    uint16_t mid = msgId();
+    uint8_t hdr[4] = { 0, 0, (uint8_t)(mid >> 8), (uint8_t)mid };
+    for (uint8_t t = 0; t < SN_ACK_TRIES; ++t) {
+        uint8_t r[7];
+        if (!sendParts(udp, gw, gwPort, SN_REGISTER, hdr, sizeof(hdr), topic)) continue;
+        if (!await(SN_REGACK, mid, r, sizeof(r), SN_ACK_MS)) continue;
+        if (r[6] != SN_RC_ACCEPTED) { LOG_W("MQTT-SN: REGISTER reddedildi (rc=%u)", r[6]); return 0; }
+
+        RegEntry& e = reg[regNext];                 // sırayla üzerine yaz
+        regNext = (regNext + 1) % SN_REG_CACHE;
+        e.hash = h;
+        e.id   = (r[2] << 8) | r[3];
+        return e.id;
+    }
+    LOG_W("MQTT-SN: REGACK yok");
+    st = SN_CONNECTION_LOST;
+    return 0;
+}
+
+uint16_t MqttSnClient::topicIdFor(const char* topic, uint8_t& idType)
+{
+    uint16_t id = mqttSnTopicId(FLOOR_ID, topic);
+    if (id != MQTT_SN_TOPIC_NONE) { idType = SN_TOPIC_PREDEF; return id; }
+    idType = SN_TOPIC_NORMAL;
+    return registerTopic(topic);
+}
+
+//--------------------------------------------------------------
+//  YAYIN
+//--------------------------------------------------------------
+/** PUBLISH başlığı: boy 1 byte (≤ 255) ya da 0x01 + 2 byte */
+static uint8_t publishHeader(uint8_t* h, uint16_t payloadLen, uint8_t flags,
+                             uint16_t topicId, uint16_t mid)
+{
+    uint8_t  n     = 0;
+    uint16_t total = 1 + 6 + payloadLen;
+    if (total > 255) {
+        total += 2;
+        h[n++] = 0x01;
+        h[n++] = total >> 8;
+    }
+    h[n++] = (uint8_t)total;
+    h[n++] = SN_PUBLISH;
+    h[n++] = flags;
+    h[n++] = topicId >> 8;  h[n++] = (uint8_t)topicId;
+    h[n++] = mid >> 8;      h[n++] = (uint8_t)mid;
+    return n;
+}
+
+void MqttSnClient::sendPending(Pending& p)
+{
+    uint8_t h[9];
+    uint8_t n = publishHeader(h, p.len, p.flags | (p.tries ? SN_FLAG_DUP : 0), p.topicId, p.msgId);
+    if (udp.beginPacket(gw, gwPort)) {
+        udp.write(h, n);
+        udp.write(p.data, p.len);
+        udp.endPacket();
+    }
+    p.tSent = millis();
+    p.tries++;
+}
+
+bool MqttSnClient::beginPublish(const char* topic, unsigned int len, bool retained)
+{
+    if (st != SN_CONNECTED) return false;
+    uint8_t  idType;
+    uint16_t tid = topicIdFor(topic, idType);
+    if (!tid) return false;
+    uint8_t flags = idType | (retained ? SN_FLAG_RETAIN : 0);
+
+    if (idType == SN_TOPIC_PREDEF && mqttSnReliable(tid) && len <= SN_RELIABLE_MAX) {
+        for (uint8_t i = 0; i < SN_RELIABLE_SLOTS; ++i) {
+            Pending& p = pend[i];
+            if (p.msgId) continue;
+            p.msgId   = msgId();
+            p.topicId = tid;
+            p.flags   = flags | SN_FLAG_QOS1;
+            p.tries   = 0;
+            p.len     = 0;
+            capture   = &p;
+            return true;
+        }
+        LOG_W("MQTT-SN: QoS1 yuvasi yok, QoS0 gidiyor");
+    }
+
+    uint8_t h[9];
+    uint8_t n = publishHeader(h, len, flags, tid, 0);
+    if (!udp.beginPacket(gw, gwPort)) return false;
+    udp.write(h, n);
+    streaming = true;
+    return true;
+}
+
+size_t MqttSnClient::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+size_t MqttSnClient::write(const uint8_t* buf, size_t n)
+{
+    if (capture) {
+        size_t room = SN_RELIABLE_MAX - capture->len;
+        if (n > room) n = room;
+        memcpy(capture->data + capture->len, buf, n);
+        capture->len += n;
+        return n;
+    }
+    return streaming ? udp.write(buf, n) : 0;
+}
+
+int MqttSnClient::endPublish()
+{
+    if (capture) {
+        sendPending(*capture);
+        capture = nullptr;
+        return 1;
+    }
+    if (!streaming) return 0;
+    streaming = false;
+    return udp.endPacket();
+}
+
+bool MqttSnClient::publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained)
+{
+    if (!beginPublish(topic, len, retained)) return false;
+    write(payload, len);
+    return endPublish();
+}
+
+bool MqttSnClient::publish(const char* topic, const char* payload, bool retained)
+{
+    return publish(topic, (const uint8_t*)payload, strlen(payload), retained);
+}
+
+void MqttSnClient::onPubAck(uint16_t id, uint8_t rc)
+{
+    for (uint8_t i = 0; i < SN_RELIABLE_SLOTS; ++i) {
+        if (pend[i].msgId != id) continue;
+        if (rc != SN_RC_ACCEPTED) LOG_W("MQTT-SN: PUBACK rc=%u (konu 0x%04x)", rc, pend[i].topicId);
+        pend[i].msgId = 0;
+    }
+}
+
+//--------------------------------------------------------------
+//  ALIM
+//--------------------------------------------------------------
+/** b[0] = tip, b[1] = bayrak, b[2..3] konu, b[4..5] MsgId, b[6..] yük */
+void MqttSnClient::onPublish(uint8_t* b, uint16_t len)
+{
+    if (len < 6) return;
+    uint8_t  flags = b[1];
+    uint16_t tid   = (b[2] << 8) | b[3];
+    uint16_t mid   = (b[4] << 8) | b[5];
+    bool     qos1  = (flags & 0x60) == SN_FLAG_QOS1;
+
+    char topic[40];
+    bool known = (flags & 0x03) == SN_TOPIC_PREDEF &&
+                 mqttSnTopicName(FLOOR_ID, tid, topic, sizeof(topic));
+    if (qos1) {
+        uint8_t ack[5] = { b[2], b[3], b[4], b[5],
+                           (uint8_t)(known ? SN_RC_ACCEPTED : SN_RC_INVALID_TOPIC) };
+        sendParts(udp, gw, gwPort, SN_PUBACK, ack, sizeof(ack));
+    }
+    if (!known) { LOG_W("MQTT-SN: bilinmeyen konu 0x%04x", tid); return; }
+    if (qos1) {
+        if (mid == lastRxMsgId) return;             // PUBACK’imiz kaybolmuş, tekrar
+        lastRxMsgId = mid;
+    }
+    if (callback) callback(topic, b + 6, len - 6);
+}
+
+void MqttSnClient::handle(uint8_t* p, uint16_t len)
+{
+    uint16_t hl = 1, total = p[0];
+    if (p[0] == 0x01) {
+        if (len < 4) return;
+        total = (p[1] << 8) | p[2];
+        hl    = 3;
+    }
+    if (total != len || len <= hl) return;
+    uint8_t* b  = p + hl;
+    uint16_t bl = len - hl;
+
+    switch (b[0]) {
+    case SN_PUBLISH:
+        onPublish(b, bl);
+        break;
+    case SN_PUBACK:
+        if (bl >= 6) onPubAck((b[3] << 8) | b[4], b[5]);
+        break;
+    case SN_SUBACK:
+        if (bl >= 7) onSubAck((b[4] << 8) | b[5], b[6]);
+        break;
+    case SN_REGISTER:
+        if (bl >= 5) {
+            uint8_t ack[5] = { b[1], b[2], b[3], b[4], SN_RC_NOT_SUPPORTED };
+            sendParts(udp, gw, gwPort, SN_REGACK, ack, sizeof(ack));
+        }
+        break;
+    case SN_PINGREQ:
+        sendParts(udp, gw, gwPort, SN_PINGRESP, nullptr, 0);
+        break;
+    case SN_DISCONNECT:
+        LOG_W("MQTT-SN: gateway baglantiyi kapatti");
+        st = SN_CONNECTION_LOST;
+        break;
+    default:                                        // PINGRESP, geç kalmış ACK’ler
+        break;
+    }
+}
+
+bool MqttSnClient::loop()
+{
+    if (st != SN_CONNECTED) return false;
+
+    for (uint8_t k = 0; k < SN_RX_PER_LOOP; ++k) {
+        int n = udp.parsePacket();
+        if (n <= 0) break;
+        tLastRx = millis();
+        if (n > SN_PACKET_MAX) { LOG_W("MQTT-SN: datagram cok buyuk (%d)", n); continue; }
+        n = udp.read(rx, n);
+        if (n > 0) handle(rx, n);
+        if (st != SN_CONNECTED) return false;
+    }
+
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < SN_RELIABLE_SLOTS; ++i) {
+        Pending& p = pend[i];
+        if (!p.msgId || now - p.tSent < SN_RETRY_MS) continue;
+        if (p.tries > SN_RETRIES) {
+            LOG_W("MQTT-SN: PUBACK yok, yayin dusuruldu (konu 0x%04x)", p.topicId);
+            p.msgId = 0;
+            continue;
+        }
+        sendPending(p);
+    }
+    for (uint8_t i = 0; i < SN_SUB_SLOTS; ++i) {
+        SubPending& s = subs[i];
+        if (!s.msgId || now - s.tSent < SN_ACK_MS) continue;
+        if (s.tries >= SN_ACK_TRIES) {
+            LOG_W("MQTT-SN: SUBACK yok (%s)", s.filter);
+            st = SN_CONNECTION_LOST;
+            return false;
+        }
+        sendSubscribe(s);
+    }
+
+    if (now - tLastRx > SN_KEEPALIVE_S * 1500UL) {
+        LOG_W("MQTT-SN: gateway sessiz");
+        st = SN_CONNECTION_TIMEOUT;
+        return false;
+    }
+    if (now - tLastPing >= SN_KEEPALIVE_S * 1000UL) {
+        sendParts(udp, gw, gwPort, SN_PINGREQ, nullptr, 0);
+        tLastPing = now;
+    }
+    return true;
+}
+
+#endif // MQTT_SN
@@ -0,0 +1,104 @@
+/**
+ *  mqtt_sn.h
+ *  ---------
+ *  – MQTT_SN=1 derlemesinde PubSubClient’ın yerine geçen UDP istemcisi
+ *    (MQTT-SN 1.2 alt kümesi); mqtt_haberlesme.cpp’nin kullandığı arayüz
+ *    birebir aynı → komut / discovery / telemetri kodu değişmez,
+ *  – <FLOOR_ID>/… konuları önceden tanımlı 2 byte’lık numaralarla gider
+ *    (mqtt_payload.h, mqttSnTopicId); homeassistant/… REGISTER ile,
+ *  – QoS1 + yeniden deneme yalnız gelen komutlarda (gateway yollar) ve
+ *    alert / power/event / diag/crash’te; telemetri QoS0, ACK’sız,
+ *  – Kullanıcı / parola gönderilmez: broker kimliğini gateway taşır.
+ */
+#pragma once
+#include <Arduino.h>
+#include <UIPEthernet.h>
+#include "config.h"
+
+#define SN_RELIABLE_SLOTS 2             // onay bekleyen QoS1 yayın
+#define SN_RELIABLE_MAX   112           // yük kopyası (power/event tamponu kadar)
+#define SN_REG_CACHE      8             // REGISTER’lı konu (hash → numara)
+#define SN_SUB_SLOTS      3             // SUBACK bekleyen abonelik (reconnect() üç yollar)
+#define SN_SUB_MAX        40            // süzgeç kopyası, \0 dahil
+
+/* state() — PubSubClient’ın MQTT_* değerleriyle aynı anlamda */
+#define SN_CONNECTION_TIMEOUT  -4
+#define SN_CONNECTION_LOST     -3
+#define SN_CONNECT_FAILED      -2
+#define SN_DISCONNECTED        -1
+#define SN_CONNECTED            0
+
+class MqttSnClient {
+public:
+    typedef void (*Callback)(char* topic, uint8_t* payload, unsigned int len);
+
+    explicit MqttSnClient(EthernetUDP& udp) : udp(udp) {}
+
+    MqttSnClient& setServer(IPAddress ip, uint16_t port);
+    MqttSnClient& setCallback(Callback cb) { callback = cb; return *this; }
+
+    /* user / pass yok sayılır; willQos her zaman 0 */
+    bool connect(const char* id, const char* user, const char* pass,
+                 const char* willTopic, uint8_t willQos, bool willRetain,
+                 const char* willMsg);
+    bool connected() const { return st == SN_CONNECTED; }
+    int  state() const     { return st; }
+    bool loop();                                    // datagramlar, ping, QoS1 tekrarı
+
+    bool publish(const char* topic, const char* payload, bool retained = false);
+    bool publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained = false);
+
+    /* Akıtılan yayın: yük doğrudan UDP paketine (QoS1 konuları yuvaya) */
+    bool   beginPublish(const char* topic, unsigned int len, bool retained);
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buf, size_t n);
+    int    endPublish();
+
+    bool subscribe(const char* filter);             // yollar; SUBACK’i loop() bekler
+
+private:
+    struct Pending {                                // onay bekleyen QoS1 yayın
+        uint16_t msgId;                             // 0 → boş
+        uint16_t topicId;
+        uint8_t  flags;
+        uint8_t  tries;
+        uint8_t  len;
+        uint32_t tSent;
+        uint8_t  data[SN_RELIABLE_MAX];
+    };
+    struct SubPending {                             // SUBACK bekleyen SUBSCRIBE
+        uint16_t msgId;                             // 0 → boş
+        uint8_t  tries;
+        uint32_t tSent;
+        char     filter[SN_SUB_MAX];
+    };
+    struct RegEntry { uint32_t hash; uint16_t id; };
+
+    EthernetUDP& udp;
+    IPAddress    gw;
+    uint16_t     gwPort   = MQTT_SN_PORT;
+    Callback     callback = nullptr;
+    int8_t       st       = SN_DISCONNECTED;
+    uint16_t     nextMsgId = 1;
+    uint16_t     lastRxMsgId = 0;               // gelen QoS1 tekrarını ele
+    uint32_t     tLastRx = 0, tLastPing = 0;
+
+    Pending      pend[SN_RELIABLE_SLOTS];
+    Pending*     capture = nullptr;             // beginPublish → yuvaya yazılıyor
+    bool         streaming = false;
+    SubPending   subs[SN_SUB_SLOTS];
+    RegEntry     reg[SN_REG_CACHE];
+    uint8_t      regNext = 0;
+    uint8_t      rx[SN_PACKET_MAX];
+
+    uint16_t msgId();
+    uint16_t topicIdFor(const char* topic, uint8_t& idType);
+    uint16_t registerTopic(const char* topic);
+    void     sendPending(Pending& p);
+    bool     await(uint8_t type, uint16_t id, uint8_t* out, uint8_t outLen, uint16_t ms);
+    void     onPubAck(uint16_t id, uint8_t rc);
+    void     sendSubscribe(SubPending& s);
+    void     onSubAck(uint16_t id, uint8_t rc);
+    void     onPublish(uint8_t* b, uint16_t len);
+    void     handle(uint8_t* p, uint16_t len);
+};
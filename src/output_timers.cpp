@@ -0,0 +1,102 @@
+/**
+ * output_timers.cpp — çıkış zamanlayıcıları (hashed timing wheel)
+ * ------------------------------------------------------------
+ *  › Sorun: “N saniye açık” için HA ikinci bir OFF göndermek zorundaydı;
+ *    ağ koparsa yük sonsuza kadar açık kalıyordu.
+ *  › Çark: WHEEL_SLOTS yuva × OUT_TIMER_TICK_MS. Süre t adım ise çıkış
+ *      slot   = (cur + t) % WHEEL_SLOTS
+ *      rounds = (t - 1) / WHEEL_SLOTS
+ *    ile yuvanın çift bağlı listesine eklenir. Her adımda YALNIZ o anki
+ *    yuva gezilir: rounds > 0 ise azaltılır, 0 ise süre dolmuştur.
+ *    Ekleme / iptal O(1); adım başı iş en çok o yuvadaki çıkış sayısı
+ *    (≤ 32) — çıkış sayısından bağımsız sabit bellek.
+ *  › Süre dolunca outputSet(idx, false) çağrılır (callback() ile aynı
+ *    yol). Modül o sırada kilitliyse kilit öncesi maskeden de düşülür,
+ *    yoksa soğuyunca çıkış tekrar açılırdı.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "output_timers.h"
+#include "outputs.h"
+#include "temperature_control.h"
+#include "log.h"
+
+#define WHEEL_SLOTS  32                 // 2’nin kuvveti
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define NIL          0xFF
+
+static uint8_t  heads[WHEEL_SLOTS];     // yuva → ilk çıkış
+static uint8_t  nextOf[NUM_OUTPUTS];
+static uint8_t  prevOf[NUM_OUTPUTS];
+static uint8_t  slotOf[NUM_OUTPUTS];    // NIL → zamanlayıcı yok
+static uint16_t rounds[NUM_OUTPUTS];    // kalan tam tur
+static uint8_t  cur = 0;                // son işlenen yuva
+
+static void unlink(uint8_t idx)
+{
+    uint8_t s = slotOf[idx];
+    if (s == NIL) return;
+
+    if (prevOf[idx] != NIL) nextOf[prevOf[idx]] = nextOf[idx];
+    else                    heads[s]            = nextOf[idx];
+    if (nextOf[idx] != NIL) prevOf[nextOf[idx]] = prevOf[idx];
+
+    slotOf[idx] = NIL;
+}
+
+void outputTimersInit()
+{
+    for (uint8_t s = 0; s < WHEEL_SLOTS; ++s) heads[s] = NIL;
+    for (uint8_t i = 0; i < NUM_OUTPUTS; ++i) slotOf[i] = NIL;
+    cur = 0;
+}
+
+bool outputTimerStart(uint8_t idx, uint32_t ms)
+{
+    if (idx >= NUM_OUTPUTS || ms > OUT_TIMER_MAX_S * 1000UL) return false;
+
+    uint32_t t = (ms + OUT_TIMER_TICK_MS - 1) / OUT_TIMER_TICK_MS;
+    if (t == 0) t = 1;
+
+    unlink(idx);
+    uint8_t s   = (cur + t) & WHEEL_MASK;
+    rounds[idx] = (t - 1) / WHEEL_SLOTS;
+    slotOf[idx] = s;
+    prevOf[idx] = NIL;
+    nextOf[idx] = heads[s];
+    if (heads[s] != NIL) prevOf[heads[s]] = idx;
+    heads[s] = idx;
+    return true;
+}
+
+void outputTimerCancel(uint8_t idx)
+{
+    if (idx < NUM_OUTPUTS) unlink(idx);
+}
+
+uint32_t outputTimerRemainingMs(uint8_t idx)
+{
+    if (idx >= NUM_OUTPUTS || slotOf[idx] == NIL) return 0;
+    uint8_t d = (slotOf[idx] - cur) & WHEEL_MASK;
+    if (d == 0) d = WHEEL_SLOTS;
+    return ((uint32_t)rounds[idx] * WHEEL_SLOTS + d) * OUT_TIMER_TICK_MS;
+}
+
+void outputTimersTick()
+{
+    cur = (cur + 1) & WHEEL_MASK;
+
+    uint8_t idx = heads[cur];
+    while (idx != NIL) {
+        uint8_t nx = nextOf[idx];           // unlink’ten önce sakla
+        if (rounds[idx]) {
+            rounds[idx]--;
+        } else {
+            unlink(idx);
+            if (outputIsLocked(idx)) tempControlForgetRestore(idx);
+            outputSet(idx, false);
+            LOG_D("Zamanlayici doldu: %u", idx);
+        }
+        idx = nx;
+    }
+}
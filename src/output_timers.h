@@ -0,0 +1,20 @@
+/**
+ *  output_timers.h
+ *  ---------------
+ *  – Çıkış başına “N saniye açık kal” süresi (pompa, banyo fanı, kapı kilidi),
+ *  – 32 çıkışın hepsi tek bir zaman çarkında (timing wheel),
+ *  – Süre dolunca outputSet(idx, false) → dirty[] + kilit kuralları aynı yol.
+ *
+ *  MQTT:  <FLOOR_ID>/Y4/set  "ON:300"   (saniye, ondalık: "ON:1.5")
+ */
+#pragma once
+#include <Arduino.h>
+
+#define OUT_TIMER_TICK_MS   100         // çark adımı
+#define OUT_TIMER_MAX_S     86400UL     // en uzun süre (1 gün)
+
+void     outputTimersInit();
+void     outputTimersTick();                    // her OUT_TIMER_TICK_MS’de bir
+bool     outputTimerStart(uint8_t idx, uint32_t ms);
+void     outputTimerCancel(uint8_t idx);
+uint32_t outputTimerRemainingMs(uint8_t idx);   // 0 → zamanlayıcı yok
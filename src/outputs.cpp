@@ -0,0 +1,194 @@
+/**
+ * outputs.cpp — çıkış sürme yolu
+ * ------------------------------------------------------------
+ *  › MQTT callback, toplu maske komutu ve sıcaklık FSM’i aynı yoldan
+ *    geçer: pinState[] → dirty[] (publish kuyruğu) → donanım kuyruğu.
+ *  › Donanım kuyruğu (zcPendOn / zcPendOff) ZCD kesmesinde işlenir:
+ *      – OFF’lar bir sonraki sıfır geçişte hepsi birden,
+ *      – ON’lar ZC_STAGGER_HALFCYCLES kenarda bir, tek tek
+ *        → kilit çözülünce / sahnede 4–20 yük aynı anda kalkmaz,
+ *          sigorta atmaz, Y_current[]’te sahte tepe oluşmaz.
+ *    ZC_TIMEOUT_MS boyunca ZCD gelmezse (şebeke algısı yok) kuyruk
+ *    outputsService() içinde doğrudan yazılır.
+ *  › Kilit kuralı callback()’teki ile aynı: kilitli Y modülüne ya da
+ *    güç bütçesince atılmış çıkışa ON isteği reddedilir, OFF her zaman
+ *    serbest (atılmış çıkışın geri açılmasını da iptal eder).
+ *  › Açık komut (outputSet / outputApplyMask) o çıkıştaki zamanlayıcıyı
+ *    iptal eder; “ON:300” gibi süreli komut sonradan yeniden kurar.
+ *    outputForce() (sıcaklık FSM’i) zamanlayıcıya dokunmaz.
+ *  › outputApplyMask(): önce yeni durumu hesaplar, sonra tüm değişiklikleri
+ *    tek geçişte (kesmeler kapalıyken) kuyruğa koyar → yarım uygulanmış
+ *    maske görülmez; donanım sıfır geçişlerde yetişir.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "outputs.h"
+#include "pinmap.h"
+#include "tanimlamalar.h"
+#include "output_timers.h"
+#include "power_budget.h"
+#include "config.h"
+
+static inline uint8_t hwPin(uint8_t idx)
+{
+    return (idx < 16) ? yMap[idx] : xMap[idx - 16];
+}
+
+//--------------------------------------------------------------
+//  SIFIR GEÇİŞ KUYRUĞU
+//--------------------------------------------------------------
+static volatile uint32_t zcPendOn   = 0;    // sıradaki ZCD’lerde açılacak
+static volatile uint32_t zcPendOff  = 0;    // sıradaki ZCD’de kapanacak
+static volatile uint8_t  zcStagger  = 0;    // sonraki ON’a kalan kenar
+static volatile uint32_t zcLastMs   = 0;    // son ZCD kenarı (millis)
+
+static inline bool zcAlive()
+{
+    uint32_t last;
+    noInterrupts(); last = zcLastMs; interrupts();
+    return millis() - last < ZC_TIMEOUT_MS;
+}
+
+/** Donanım yazımını kuyruğa al (ZCD yoksa hemen yaz) */
+static void queueWrite(uint8_t idx, bool on)
+{
+    uint32_t bit = 1UL << idx;
+    if (!zcAlive()) {
+        noInterrupts();
+        zcPendOn &= ~bit;  zcPendOff &= ~bit;
+        interrupts();
+        digitalWrite(hwPin(idx), on ? HIGH : LOW);
+        return;
+    }
+    noInterrupts();
+    if (on) { zcPendOn |= bit;  zcPendOff &= ~bit; }
+    else    { zcPendOff |= bit; zcPendOn  &= ~bit; }
+    interrupts();
+}
+
+/** ZCD kesmesinden (zeroCrossISR) çağrılır */
+void outputsZeroCross()
+{
+    zcLastMs = millis();
+
+    uint32_t off = zcPendOff;
+    if (off) {
+        zcPendOff = 0;
+        for (uint8_t i = 0; i < NUM_OUTPUTS; ++i)
+            if (off & (1UL << i)) digitalWrite(hwPin(i), LOW);
+    }
+
+    if (zcStagger) { zcStagger--; return; }
+
+    uint32_t on = zcPendOn;
+    if (!on) return;
+    uint8_t i = 0;
+    while (!(on & 1)) { on >>= 1; ++i; }    // en düşük bekleyen ON
+    zcPendOn &= ~(1UL << i);
+    digitalWrite(hwPin(i), HIGH);
+    zcStagger = ZC_STAGGER_HALFCYCLES - 1;
+}
+
+void outputsService()
+{
+    if (zcAlive()) return;
+
+    noInterrupts();
+    uint32_t on = zcPendOn, off = zcPendOff;
+    zcPendOn = zcPendOff = 0;
+    interrupts();
+    if (!(on | off)) return;
+
+    for (uint8_t i = 0; i < NUM_OUTPUTS; ++i) {
+        uint32_t bit = 1UL << i;
+        if (off & bit) digitalWrite(hwPin(i), LOW);
+        if (on  & bit) digitalWrite(hwPin(i), HIGH);
+    }
+}
+
+uint32_t outputsPendingMask()
+{
+    noInterrupts();
+    uint32_t m = zcPendOn | zcPendOff;
+    interrupts();
+    return m;
+}
+
+bool outputIsLocked(uint8_t idx)
+{
+    return idx < 16 && moduleLocked[idx / 4];       // 4 çıkış = 1 modül
+}
+
+void outputForce(uint8_t idx, bool on)
+{
+    if (idx >= NUM_OUTPUTS) return;
+    queueWrite(idx, on);
+    pinState[idx] = on;
+    dirty[idx]    = true;                           // MQTT publish kuyruğu
+}
+
+bool outputSet(uint8_t idx, bool on)
+{
+    if (idx >= NUM_OUTPUTS) return false;
+    if (on && (outputIsLocked(idx) || pbIsShed(idx))) return false;  // kilit / bütçe → yok say
+    if (!on) pbForget(idx);
+    outputTimerCancel(idx);
+    outputForce(idx, on);
+    return true;
+}
+
+uint32_t outputStateMask()
+{
+    uint32_t m = 0;
+    for (uint8_t i = 0; i < NUM_OUTPUTS; ++i)
+        if (pinState[i]) m |= (1UL << i);
+    return m;
+}
+
+uint32_t outputApplyMask(uint32_t mask, uint32_t change)
+{
+    /* 1) Kilitli modüllere / atılmış çıkışlara ON isteklerini ayıkla */
+    uint32_t rejected = 0;
+    for (uint8_t i = 0; i < 16; ++i) {
+        uint32_t bit = 1UL << i;
+        if ((change & mask & bit) && (outputIsLocked(i) || pbIsShed(i))) rejected |= bit;
+    }
+    change &= ~rejected;
+
+    for (uint8_t i = 0; i < NUM_OUTPUTS; ++i) {
+        if (!(change & (1UL << i))) continue;
+        outputTimerCancel(i);
+        if (!(mask & (1UL << i))) pbForget(i);
+    }
+
+    /* 2) Yalnız gerçekten değişecek pinler */
+    uint32_t cur  = outputStateMask();
+    uint32_t diff = (cur ^ mask) & change;
+    if (!diff) return rejected;
+
+    /* 3) Tek geçişte kuyruğa al (ZCD yoksa doğrudan yaz) */
+    if (!zcAlive()) {
+        noInterrupts();
+        zcPendOn &= ~diff;  zcPendOff &= ~diff;
+        interrupts();
+        for (uint8_t i = 0; i < NUM_OUTPUTS; ++i)
+            if (diff & (1UL << i)) digitalWrite(hwPin(i), (mask >> i) & 1 ? HIGH : LOW);
+    } else {
+        noInterrupts();
+        zcPendOn  = (zcPendOn  & ~diff) | (diff &  mask);
+        zcPendOff = (zcPendOff & ~diff) | (diff & ~mask);
+        interrupts();
+    }
+
+    for (uint8_t i = 0; i < NUM_OUTPUTS; ++i) {
+        if (!(diff & (1UL << i))) continue;
+        pinState[i] = (mask >> i) & 1;
+        dirty[i]    = true;
+    }
+    return rejected;
+}
+
+void outputAlias(uint8_t idx, char* buf, size_t n)
+{
+    snprintf_P(buf, n, PSTR("%c%u"), (idx < 16) ? 'Y' : 'X', idx % 16);
+}
@@ -0,0 +1,26 @@
+/**
+ *  outputs.h
+ *  ---------
+ *  – 32 triyak çıkışının (Y0‥Y15 → 0‥15, X0‥X15 → 16‥31) tek giriş noktası,
+ *  – Aşırı ısınma kilidine (moduleLocked[]) uyan tekil / toplu komutlar,
+ *  – pinState[] + dirty[] güncellemesi (MQTT state kuyruğu),
+ *  – Donanım yazımı sıfır geçişte; çoklu ON’lar yarım periyotlara yayılır.
+ *
+ *  Maske düzeni: bit i ↔ pinState[i]   (bit0 = Y0, bit16 = X0)
+ */
+#pragma once
+#include <Arduino.h>
+
+#define NUM_OUTPUTS 32
+
+bool     outputSet(uint8_t idx, bool on);     // false → kilit / güç bütçesi nedeniyle reddedildi
+void     outputForce(uint8_t idx, bool on);   // kilide bakmaz (sıcaklık FSM’i)
+uint32_t outputApplyMask(uint32_t mask, uint32_t change); // dönüş: reddedilen bitler (kilit / bütçe)
+uint32_t outputStateMask();                   // pinState[] → 32 bit
+bool     outputIsLocked(uint8_t idx);         // ilgili Y modülü kilitli mi?
+void     outputAlias(uint8_t idx, char* buf, size_t n); // 5 → "Y5", 20 → "X4"
+
+/* Sıfır geçişte anahtarlama kuyruğu */
+void     outputsZeroCross();                  // ZCD ISR’ından
+void     outputsService();                    // her loop() turu: ZCD yoksa kuyruğu boşalt
+uint32_t outputsPendingMask();                // donanıma henüz yazılmamış çıkışlar
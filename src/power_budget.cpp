@@ -0,0 +1,255 @@
+/**
+ * power_budget.cpp — kart geneli güç bütçesi + öncelikli yük atma
+ * ------------------------------------------------------------
+ *  › Sorun: Y_powerW[] kanal başına güç veriyordu ama toplamı izleyen
+ *    yoktu; birkaç ısıtıcı aynı anda açılınca katın tek sigortası atıyordu.
+ *  › Toplam artımlı: sampleCurrentSensors() bir kanalın Irms’ini
+ *    yeniledikçe pbOnIrms() yalnız o kanalın farkını ekler
+ *    (total += yeni − eski) → tur başına O(1), float toplama yok.
+ *    Kanal başına Irms penceresi 80 örnek (≈240 ms, 12 periyot);
+ *    gerçek tepki süresi bu pencere + PB_SHED_CYCLES’tır.
+ *  › Atma: toplam > bütçe, PB_SHED_CYCLES × 20 ms kesintisiz sürerse
+ *    (kalkış akımları atılmasın) açık, sensörlü, önceliği ≠ 0 çıkışlar
+ *    küçük öncelikten başlayarak (eşitse en çok çeken önce) aşımı
+ *    kapatana kadar tek geçişte atılır. Atılan kanalın gücü toplamdan
+ *    hemen düşülür ve atılı kaldıkça ölçümü 0 sayılır → ölçüm
+ *    gecikmesi yüzünden ikinci bir kanal boşuna atılmaz.
+ *    Kapatma outputForce() ile: sıfır geçişte, zamanlayıcıya dokunmaz.
+ *  › Geri açma: en yüksek öncelikli atılmış çıkış için
+ *      toplam + atılırken çektiği + PB_RESTORE_HYST_W ≤ bütçe
+ *    PB_RESTORE_MS boyunca sürerse o çıkış açılır; sonraki için sayaç
+ *    baştan başlar (bir seferde tek yük). Termik kilitli modül beklenir.
+ *  › Atılmış çıkışa ON komutu (MQTT, sahne, kural) kilitteki gibi
+ *    reddedilir; OFF komutu kaydı siler → artık geri açılmaz.
+ *  › Olaylar PB_EVENTS’lik halkada; mqttServicePower() en eskisine
+ *    pbPeekEvent() ile bakar, yalnız yayın başarılıysa pbPopEvent().
+ *  › EEPROM (EE_POWER_ADDR): [0] PB_MAGIC, [1..] PbStore.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "config.h"
+#include "eeprom_map.h"
+#include "power_budget.h"
+#include "current_sense.h"
+#include "outputs.h"
+#include "tanimlamalar.h"
+#include "log.h"
+
+#define PB_MAGIC        0xB6
+#define PB_CYCLE_MS     20          // 50 Hz
+#define PB_MAINS_V      230.0f      // energyTick() ile aynı varsayım
+#define PB_BUDGET_MIN_W 100
+#define PB_BUDGET_MAX_W 20000
+
+struct PbStore {
+    uint16_t budgetW;
+    uint8_t  prio[PB_CHANNELS];
+};
+
+static_assert(1 + sizeof(PbStore) <= EE_POWER_SIZE, "guc butcesi EEPROM bolgesine sigmiyor");
+
+static PbStore  cfg;
+static uint16_t chW[PB_CHANNELS];       // son Irms × V (atılmışlar 0)
+static uint16_t shedW[PB_CHANNELS];     // atılırken çektiği (geri açma tahmini)
+static uint16_t total    = 0;
+static uint16_t shedMask = 0;
+
+static bool     over = false,  overReported = false;
+static uint32_t overSince = 0;
+static bool     room = false;
+static uint32_t roomSince = 0;
+
+static PbEvent  evq[PB_EVENTS];
+static uint8_t  evHead = 0, evCount = 0, evDropped = 0;
+
+//--------------------------------------------------------------
+//  OLAY HALKASI
+//--------------------------------------------------------------
+static void pushEvent(uint8_t kind, uint8_t ch, uint16_t w)
+{
+    if (evCount == PB_EVENTS) {                     // dolu → en eskiyi düşür
+        evHead = (evHead + 1) % PB_EVENTS;
+        evCount--;
+        if (evDropped < 255) evDropped++;
+    }
+    PbEvent& e = evq[(evHead + evCount) % PB_EVENTS];
+    e.kind   = kind;
+    e.ch     = ch;
+    e.chW    = w;
+    e.totalW = total;
+    evCount++;
+}
+
+bool pbPeekEvent(PbEvent& ev)
+{
+    if (!evCount) return false;
+    ev = evq[evHead];
+    return true;
+}
+
+void pbPopEvent()
+{
+    if (!evCount) return;
+    evHead = (evHead + 1) % PB_EVENTS;
+    evCount--;
+}
+
+uint8_t pbDropped() { return evDropped; }
+
+//--------------------------------------------------------------
+//  KURULUM / AYAR
+//--------------------------------------------------------------
+static void saveConfig()
+{
+    EEPROM.put(EE_POWER_ADDR + 1, cfg);             // put → yalnız değişen byte'lar
+    EEPROM.update(EE_POWER_ADDR, PB_MAGIC);
+}
+
+void pbInit()
+{
+    bool ok = EEPROM.read(EE_POWER_ADDR) == PB_MAGIC;
+    if (ok) {
+        EEPROM.get(EE_POWER_ADDR + 1, cfg);
+        ok = cfg.budgetW >= PB_BUDGET_MIN_W && cfg.budgetW <= PB_BUDGET_MAX_W;
+        for (uint8_t ch = 0; ok && ch < PB_CHANNELS; ++ch)
+            ok = cfg.prio[ch] <= PB_PRIO_MAX;
+    }
+    if (!ok) {
+        cfg.budgetW = PB_BUDGET_W;
+        for (uint8_t ch = 0; ch < PB_CHANNELS; ++ch)
+            cfg.prio[ch] = hasCurrentSensor(ch) ? PB_DEFAULT_PRIO : PB_PRIO_KEEP;
+    }
+
+    total = shedMask = 0;
+    for (uint8_t ch = 0; ch < PB_CHANNELS; ++ch) chW[ch] = shedW[ch] = 0;
+    LOG_I("Guc butcesi %u W", cfg.budgetW);
+}
+
+uint16_t pbBudgetW() { return cfg.budgetW; }
+
+bool pbSetBudget(uint16_t w)
+{
+    if (w < PB_BUDGET_MIN_W || w > PB_BUDGET_MAX_W) return false;
+    cfg.budgetW = w;
+    saveConfig();
+    room = false;                                   // geri açma sayacı baştan
+    return true;
+}
+
+uint8_t pbPriority(uint8_t ch) { return (ch < PB_CHANNELS) ? cfg.prio[ch] : PB_PRIO_KEEP; }
+
+bool pbSetPriority(uint8_t ch, uint8_t prio)
+{
+    if (ch >= PB_CHANNELS || prio > PB_PRIO_MAX) return false;
+    cfg.prio[ch] = prio;
+    saveConfig();
+    return true;
+}
+
+//--------------------------------------------------------------
+//  ÖLÇÜM (artımlı toplam)
+//--------------------------------------------------------------
+void pbOnIrms(uint8_t ch, float amps)
+{
+    if (ch >= PB_CHANNELS) return;
+    uint16_t w = (shedMask & (1U << ch)) ? 0 : (uint16_t)(amps * PB_MAINS_V + 0.5f);
+    total  += w - chW[ch];                          // uint16 sarması farkı doğru verir
+    chW[ch] = w;
+}
+
+uint16_t pbTotalW()              { return total; }
+uint16_t pbChannelW(uint8_t ch)  { return (ch < PB_CHANNELS) ? chW[ch] : 0; }
+uint16_t pbShedMask()            { return shedMask; }
+bool     pbIsShed(uint8_t idx)   { return idx < PB_CHANNELS && (shedMask & (1U << idx)); }
+
+void pbForget(uint8_t idx)
+{
+    if (idx < PB_CHANNELS) shedMask &= ~(1U << idx);
+}
+
+//--------------------------------------------------------------
+//  ATMA / GERİ AÇMA
+//--------------------------------------------------------------
+/** Açık, sensörlü, atılabilir; en küçük öncelik, eşitse en çok çeken */
+static int8_t shedCandidate()
+{
+    int8_t best = -1;
+    for (uint8_t ch = 0; ch < PB_CHANNELS; ++ch) {
+        if (cfg.prio[ch] == PB_PRIO_KEEP || !pinState[ch] || !chW[ch]) continue;
+        if (shedMask & (1U << ch)) continue;
+        if (best < 0 || cfg.prio[ch] < cfg.prio[best] ||
+            (cfg.prio[ch] == cfg.prio[best] && chW[ch] > chW[best]))
+            best = ch;
+    }
+    return best;
+}
+
+/** Atılmışlardan en büyük öncelik, eşitse en az çeken; kilitli modül beklesin */
+static int8_t restoreCandidate()
+{
+    int8_t best = -1;
+    for (uint8_t ch = 0; ch < PB_CHANNELS; ++ch) {
+        if (!(shedMask & (1U << ch)) || outputIsLocked(ch)) continue;
+        if (best < 0 || cfg.prio[ch] > cfg.prio[best] ||
+            (cfg.prio[ch] == cfg.prio[best] && shedW[ch] < shedW[best]))
+            best = ch;
+    }
+    return best;
+}
+
+static void shed()
+{
+    uint16_t need  = total - cfg.budgetW;
+    uint16_t freed = 0;
+    while (freed < need) {
+        int8_t ch = shedCandidate();
+        if (ch < 0) break;
+
+        uint16_t w = chW[ch];
+        shedW[ch] = w;
+        freed    += w;
+        total    -= w;
+        chW[ch]   = 0;
+        shedMask |= 1U << ch;
+        outputForce(ch, false);                     // sıfır geçişte kapanır
+
+        LOG_W("Yuk atildi: Y%u %u W (toplam %u / %u W)", ch, w, total, cfg.budgetW);
+        pushEvent(PB_EV_SHED, ch, w);
+    }
+    if (freed < need && !overReported) {
+        LOG_E("Guc butcesi asildi, atilacak yuk yok (%u / %u W)", total, cfg.budgetW);
+        pushEvent(PB_EV_OVER, 0xFF, 0);
+        overReported = true;
+    }
+}
+
+void pbService()
+{
+    uint32_t now = millis();
+
+    if (total > cfg.budgetW) {
+        room = false;
+        if (!over) { over = true; overSince = now; return; }
+        if (now - overSince < (uint32_t)PB_SHED_CYCLES * PB_CYCLE_MS) return;
+        over = false;                               // hâlâ aşıksa yeni bekleme
+        shed();
+        return;
+    }
+    over = overReported = false;
+    if (!shedMask) return;
+
+    int8_t ch = restoreCandidate();
+    if (ch < 0 || (uint32_t)total + shedW[ch] + PB_RESTORE_HYST_W > cfg.budgetW) {
+        room = false;
+        return;
+    }
+    if (!room) { room = true; roomSince = now; return; }
+    if (now - roomSince < PB_RESTORE_MS) return;
+
+    room = false;
+    shedMask &= ~(1U << ch);
+    outputForce(ch, true);
+    LOG_I("Yuk geri acildi: Y%u (toplam %u / %u W)", ch, total, cfg.budgetW);
+    pushEvent(PB_EV_RESTORE, ch, shedW[ch]);
+}
@@ -0,0 +1,52 @@
+/**
+ *  power_budget.h
+ *  --------------
+ *  – Kartın tek sigortasından çekilen toplam gücü Irms güncellemeleriyle
+ *    artımlı izler (16 float’ı her turda toplamaz),
+ *  – Bütçe aşımı PB_SHED_CYCLES şebeke periyodu sürerse en düşük
+ *    öncelikli Y çıkışlarını atar; boşluk + histerezis PB_RESTORE_MS
+ *    korunursa tek tek geri açar,
+ *  – Bütçe ve çıkış öncelikleri EEPROM’da (EE_POWER_ADDR),
+ *  – Her atma / geri açma olayı kuyruğa → <FLOOR_ID>/power/event.
+ *
+ *  Öncelik: 0 = asla atılmaz (buzdolabı, pompa), 1‥9 küçük olan önce.
+ *  Sensörsüz çıkışlar (Y3/Y7/Y11/Y15, X*) ölçülemediği için atılmaz.
+ */
+#pragma once
+#include <Arduino.h>
+
+#define PB_CHANNELS    16            // Y0‥Y15
+#define PB_PRIO_KEEP   0
+#define PB_PRIO_MAX    9
+#define PB_EVENTS      8             // yayınlanmayı bekleyen olay halkası
+
+enum PbEventKind : uint8_t {
+    PB_EV_SHED    = 1,               // çıkış atıldı
+    PB_EV_RESTORE = 2,               // çıkış geri açıldı
+    PB_EV_OVER    = 3,               // bütçe aşık, atılacak çıkış kalmadı
+};
+
+struct PbEvent {
+    uint8_t  kind;                   // PbEventKind
+    uint8_t  ch;                     // Y kanalı (PB_EV_OVER: 0xFF)
+    uint16_t chW;                    // kanalın atılırken çektiği güç
+    uint16_t totalW;                 // olay anında toplam (atılan hariç)
+};
+
+void     pbInit();                                // EEPROM → bütçe + öncelikler
+void     pbOnIrms(uint8_t ch, float amps);        // sampleCurrentSensors (kesmeler kapalı)
+void     pbService();                             // 10 ms turu, Irms’ten hemen sonra
+bool     pbIsShed(uint8_t idx);                   // atılmış → ON komutu reddedilir
+void     pbForget(uint8_t idx);                   // OFF komutu → geri açılmasın
+
+uint16_t pbTotalW();
+uint16_t pbChannelW(uint8_t ch);
+uint16_t pbBudgetW();
+bool     pbSetBudget(uint16_t w);                 // aralık dışı → false
+uint8_t  pbPriority(uint8_t ch);
+bool     pbSetPriority(uint8_t ch, uint8_t prio);
+uint16_t pbShedMask();                            // bit ch = 1 → atılmış
+
+bool     pbPeekEvent(PbEvent& ev);                // en eski olay, silmez
+void     pbPopEvent();                            // yayınlandı → sil
+uint8_t  pbDropped();                             // halka dolunca düşen olay
@@ -0,0 +1,234 @@
+/**
+ * rules.cpp — yerel kural motoru
+ * ------------------------------------------------------------
+ *  › “Y4 8 A’yi geçerse X3’ü kapat”, “Y0 açılınca X0’ı da aç” gibi
+ *    kilitlemeler artık HA’ya gitmeden, broker yokken de çalışır.
+ *  › Program postfix (RPN) bytecode; atlama yok → doğrulama tek geçiş:
+ *      – her opcode ve operand geçerli mi (idx < 32, ch < 16, mod < 4),
+ *      – yığın hiç taşmıyor / boşalmıyor mu,
+ *      – her eylem (ON/OFF/COPY) sonrası yığın boş mu (kural sınırı),
+ *      – program OP_END ile bitiyor mu.
+ *    Doğrulanmayan program EEPROM’a yazılmaz, açılışta bozuksa çalışmaz.
+ *  › Bütçe: tur başına RULES_BUDGET komut; bütçe bitince yalnız kural
+ *    sınırında (yığın boş) durulur, sonraki turda kalınan yerden devam.
+ *  › EEPROM düzeni (EE_RULES_ADDR):
+ *      [0] RULES_MAGIC  [1] uzunluk  [2] crc8  [3..] bytecode
+ *    Program doğrudan EEPROM’dan okunarak yürütülür (RAM kopyası yok).
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "eeprom_map.h"
+#include "rules.h"
+#include "outputs.h"
+#include "current_sense.h"
+#include "temperature_control.h"
+#include "tanimlamalar.h"
+#include "log.h"
+
+#define RULES_MAGIC  0x52       // 'R'
+#define RULES_HDR    3
+
+static_assert(RULES_HDR + RULES_MAX_CODE <= EE_RULES_SIZE, "kural bolgesi EEPROM'a sigmiyor");
+
+static uint8_t codeLen = 0;     // 0 → devre dışı
+static uint8_t pc      = 0;     // sonraki turda devam edilecek adres
+static int16_t stack[RULES_STACK];
+static uint8_t sp      = 0;
+
+//--------------------------------------------------------------
+//  YARDIMCILAR
+//--------------------------------------------------------------
+static uint8_t opOperands(uint8_t op)
+{
+    switch (op) {
+    case OP_CONST: return 2;
+    case OP_PIN: case OP_AMP: case OP_WATT: case OP_TEMP:
+    case OP_ON:  case OP_OFF: case OP_COPY: return 1;
+    default:     return 0;
+    }
+}
+
+static int8_t opStackDelta(uint8_t op)
+{
+    switch (op) {
+    case OP_PIN: case OP_AMP: case OP_WATT: case OP_TEMP: case OP_CONST: return +1;
+    case OP_GT:  case OP_LT:  case OP_EQ:   case OP_AND:  case OP_OR:    return -1;
+    case OP_ON:  case OP_OFF: case OP_COPY:                              return -1;
+    default:     return 0;      // NOT, END
+    }
+}
+
+static uint8_t opMinDepth(uint8_t op)
+{
+    switch (op) {
+    case OP_GT: case OP_LT: case OP_EQ: case OP_AND: case OP_OR: return 2;
+    case OP_NOT: case OP_ON: case OP_OFF: case OP_COPY:          return 1;
+    default:    return 0;
+    }
+}
+
+static bool operandValid(uint8_t op, uint8_t v)
+{
+    switch (op) {
+    case OP_PIN: case OP_ON: case OP_OFF: case OP_COPY: return v < NUM_OUTPUTS;
+    case OP_AMP: case OP_WATT:                          return v < NUM_Y_CHANNELS;
+    case OP_TEMP:                                       return v < 4;
+    default:                                            return true;
+    }
+}
+
+static uint8_t crc8(uint8_t crc, uint8_t b)
+{
+    crc ^= b;
+    for (uint8_t i = 0; i < 8; ++i)
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+    return crc;
+}
+
+/** Bytecode’u doğrula; readByte(i) i. byte'ı verir */
+template <typename Reader>
+static bool verify(Reader readByte, uint8_t len)
+{
+    if (len == 0 || len > RULES_MAX_CODE) return false;
+
+    uint8_t depth = 0;
+    for (uint8_t i = 0; i < len; ) {
+        uint8_t op = readByte(i);
+        if (op >= OP_COUNT) return false;
+        if (op == OP_END)   return (i == len - 1) && depth == 0;
+
+        uint8_t nOps = opOperands(op);
+        if (i + nOps >= len) return false;
+        if (nOps == 1 && !operandValid(op, readByte(i + 1))) return false;
+
+        if (depth < opMinDepth(op)) return false;
+        depth += opStackDelta(op);
+        if (depth > RULES_STACK) return false;
+        if ((op == OP_ON || op == OP_OFF || op == OP_COPY) && depth != 0) return false;
+
+        i += 1 + nOps;
+    }
+    return false;               // OP_END yok
+}
+
+static inline uint8_t eeCode(uint8_t i) { return EEPROM.read(EE_RULES_ADDR + RULES_HDR + i); }
+
+static int16_t clamp16(float v)
+{
+    if (isnan(v))      return INT16_MIN;
+    if (v >  32767.0f) return  32767;
+    if (v < -32767.0f) return -32767;
+    return (int16_t)v;
+}
+
+static void action(uint8_t op, uint8_t idx, int16_t cond)
+{
+    bool want;
+    if      (op == OP_COPY) want = cond != 0;
+    else if (cond == 0)     return;
+    else                    want = (op == OP_ON);
+
+    if (pinState[idx] != want) outputSet(idx, want);   // kilit kuralı outputs.cpp’de
+}
+
+//--------------------------------------------------------------
+//  KAMUYA AÇIK
+//--------------------------------------------------------------
+void rulesInit()
+{
+    codeLen = 0;
+    pc = sp = 0;
+
+    if (EEPROM.read(EE_RULES_ADDR) != RULES_MAGIC) return;
+    uint8_t len = EEPROM.read(EE_RULES_ADDR + 1);
+    if (len == 0 || len > RULES_MAX_CODE) return;
+
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; ++i) crc = crc8(crc, eeCode(i));
+    if (crc != EEPROM.read(EE_RULES_ADDR + 2) || !verify(eeCode, len)) {
+        LOG_E("Kurallar bozuk, devre disi");
+        return;
+    }
+    codeLen = len;
+    LOG_I("Kurallar yuklendi (%u byte)", len);
+}
+
+static int8_t hexNibble(uint8_t c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool rulesLoadHex(const uint8_t* hex, unsigned int len)
+{
+    /* Boş yük → kuralları sil */
+    if (len == 0) {
+        EEPROM.update(EE_RULES_ADDR, 0xFF);
+        codeLen = 0;
+        LOG_I("Kurallar silindi");
+        return true;
+    }
+    if ((len & 1) || len / 2 > RULES_MAX_CODE) return false;
+
+    uint8_t n = len / 2;
+    for (unsigned int i = 0; i < len; ++i)
+        if (hexNibble(hex[i]) < 0) return false;
+
+    auto fromHex = [hex](uint8_t i) -> uint8_t {
+        return (hexNibble(hex[2 * i]) << 4) | hexNibble(hex[2 * i + 1]);
+    };
+    if (!verify(fromHex, n)) return false;
+
+    /* Yazarken çalışmasın */
+    codeLen = 0;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < n; ++i) {
+        uint8_t b = fromHex(i);
+        EEPROM.update(EE_RULES_ADDR + RULES_HDR + i, b);
+        crc = crc8(crc, b);
+    }
+    EEPROM.update(EE_RULES_ADDR + 1, n);
+    EEPROM.update(EE_RULES_ADDR + 2, crc);
+    EEPROM.update(EE_RULES_ADDR, RULES_MAGIC);
+
+    pc = sp = 0;
+    codeLen = n;
+    LOG_I("Kurallar yuklendi (%u byte)", n);
+    return true;
+}
+
+uint8_t rulesCodeLen() { return codeLen; }
+
+void rulesTick()
+{
+    if (!codeLen) return;
+
+    for (uint8_t budget = 0; ; ++budget) {
+        if (budget >= RULES_BUDGET && sp == 0) return;   // kural sınırında dur
+
+        uint8_t op = eeCode(pc);
+        uint8_t a  = (opOperands(op) >= 1) ? eeCode(pc + 1) : 0;
+        pc += 1 + opOperands(op);
+
+        switch (op) {
+        case OP_END:   pc = 0; sp = 0; return;           // tur başına en çok bir tam geçiş
+        case OP_PIN:   stack[sp++] = pinState[a] ? 1 : 0;                  break;
+        case OP_AMP:   stack[sp++] = clamp16(Y_current[a] * 100.0f);       break;
+        case OP_WATT:  stack[sp++] = clamp16(Y_powerW[a]);                 break;
+        case OP_TEMP:  stack[sp++] = clamp16(getModuleTemp(a) * 10.0f);    break;
+        case OP_CONST: stack[sp++] = (int16_t)(a | (eeCode(pc - 1) << 8)); break;
+        case OP_GT:    sp--; stack[sp - 1] = stack[sp - 1] >  stack[sp];   break;
+        case OP_LT:    sp--; stack[sp - 1] = stack[sp - 1] <  stack[sp];   break;
+        case OP_EQ:    sp--; stack[sp - 1] = stack[sp - 1] == stack[sp];   break;
+        case OP_AND:   sp--; stack[sp - 1] = stack[sp - 1] && stack[sp];   break;
+        case OP_OR:    sp--; stack[sp - 1] = stack[sp - 1] || stack[sp];   break;
+        case OP_NOT:   stack[sp - 1] = !stack[sp - 1];                     break;
+        case OP_ON:
+        case OP_OFF:
+        case OP_COPY:  sp--; action(op, a, stack[sp]);                      break;
+        }
+    }
+}
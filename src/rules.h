@@ -0,0 +1,40 @@
+/**
+ *  rules.h
+ *  -------
+ *  – Kartta çalışan küçük kural motoru (HA / broker olmadan kilitlemeler),
+ *  – Kurallar yığın tabanlı bytecode; EEPROM’da saklanır, MQTT ile yüklenir,
+ *  – Her 10 ms’lik turda sınırlı komut bütçesiyle değerlendirilir.
+ *
+ *  Derleyici: tools/rules_compile.py   ("Y4.amp > 8 -> off X3")
+ */
+#pragma once
+#include <Arduino.h>
+
+#define RULES_MAX_CODE   240     // byte (EE_RULES_SIZE - başlık)
+#define RULES_BUDGET     64      // tur başına en fazla komut
+#define RULES_STACK      8
+
+/* Opcode’lar  — operand byte sayısı parantezde */
+enum RuleOp : uint8_t {
+    OP_END   = 0x00,   // program sonu → sonraki turda baştan
+    OP_PIN   = 0x01,   // (1) idx    → pinState[idx]            (0/1)
+    OP_AMP   = 0x02,   // (1) ch     → Y_current[ch] × 100       (cA)
+    OP_WATT  = 0x03,   // (1) ch     → Y_powerW[ch]              (W)
+    OP_TEMP  = 0x04,   // (1) mod    → modül sıcaklığı × 10     (0.1 °C)
+    OP_CONST = 0x05,   // (2) int16 LE
+    OP_GT    = 0x06,   // a b → a > b
+    OP_LT    = 0x07,   // a b → a < b
+    OP_EQ    = 0x08,   // a b → a == b
+    OP_AND   = 0x09,
+    OP_OR    = 0x0A,
+    OP_NOT   = 0x0B,
+    OP_ON    = 0x0C,   // (1) idx   koşul ≠ 0 → çıkışı aç
+    OP_OFF   = 0x0D,   // (1) idx   koşul ≠ 0 → çıkışı kapat
+    OP_COPY  = 0x0E,   // (1) idx   çıkış = koşul
+    OP_COUNT
+};
+
+void    rulesInit();                                 // EEPROM’dan doğrula
+void    rulesTick();                                 // 10 ms’de bir
+bool    rulesLoadHex(const uint8_t* hex, unsigned int len); // doğrula + EEPROM
+uint8_t rulesCodeLen();                              // 0 → kural yok
@@ -0,0 +1,80 @@
+/**
+ * scenes.cpp — EEPROM’da saklanan sahneler
+ * ------------------------------------------------------------
+ *  › HA otomasyonları 10–20 çıkışı birlikte anahtarlıyordu: her biri
+ *    ayrı MQTT mesajı + ayrı state publish. Sahne ile tek mesaj yeter.
+ *  › EEPROM kaydı (EE_SCENES_ADDR + slot × SCENE_REC_SIZE):
+ *      [0]     SCENE_MAGIC  → dolu,  başka değer → boş
+ *      [1..]   Scene        (ad + mask + change)
+ *  › RAM’de kopya tutulmaz; sahne çağrılırken EEPROM’dan okunur
+ *    (≈21 byte, birkaç µs).
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "eeprom_map.h"
+#include "scenes.h"
+#include "outputs.h"
+
+#define SCENE_MAGIC     0x5C
+#define SCENE_REC_SIZE  (1 + sizeof(Scene))
+
+static_assert(SCENE_MAX * SCENE_REC_SIZE <= EE_SCENES_SIZE, "sahneler EEPROM bolgesine sigmiyor");
+
+static inline int recAddr(uint8_t slot) { return EE_SCENES_ADDR + slot * SCENE_REC_SIZE; }
+
+bool sceneGet(uint8_t slot, Scene& out)
+{
+    if (slot >= SCENE_MAX) return false;
+    if (EEPROM.read(recAddr(slot)) != SCENE_MAGIC) return false;
+    EEPROM.get(recAddr(slot) + 1, out);
+    out.name[SCENE_NAME_LEN - 1] = '\0';
+    return true;
+}
+
+bool sceneDefine(uint8_t slot, const char* name, uint32_t mask, uint32_t change)
+{
+    if (slot >= SCENE_MAX || name[0] == '\0') return false;
+
+    Scene s;
+    memset(&s, 0, sizeof(s));
+    strncpy(s.name, name, SCENE_NAME_LEN - 1);
+    s.mask   = mask & change;
+    s.change = change;
+
+    EEPROM.put(recAddr(slot) + 1, s);          // put → yalnız değişen byte'lar
+    EEPROM.update(recAddr(slot), SCENE_MAGIC);
+    return true;
+}
+
+bool sceneDelete(uint8_t slot)
+{
+    if (slot >= SCENE_MAX) return false;
+    EEPROM.update(recAddr(slot), 0xFF);
+    return true;
+}
+
+int8_t sceneFind(const char* key)
+{
+    /* Salt rakam → slot numarası */
+    if (key[0] >= '0' && key[0] <= '9' && key[1] == '\0') {
+        uint8_t slot = key[0] - '0';
+        Scene s;
+        return sceneGet(slot, s) ? slot : -1;
+    }
+
+    Scene s;
+    for (uint8_t i = 0; i < SCENE_MAX; ++i)
+        if (sceneGet(i, s) && strcmp(s.name, key) == 0) return i;
+    return -1;
+}
+
+bool sceneRecall(uint8_t slot, uint32_t* rejected)
+{
+    Scene s;
+    if (!sceneGet(slot, s)) return false;
+
+    uint32_t r = outputApplyMask(s.mask, s.change);
+    if (rejected) *rejected = r;
+    return true;
+}
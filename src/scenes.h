@@ -0,0 +1,23 @@
+/**
+ *  scenes.h
+ *  --------
+ *  – Karta kayıtlı, adlandırılmış çıkış maskeleri (“Akşam”, “Hepsi kapalı”),
+ *  – EEPROM’da kalıcı, tek mesajla tek geçişte uygulanır (outputApplyMask).
+ */
+#pragma once
+#include <Arduino.h>
+
+#define SCENE_MAX       8
+#define SCENE_NAME_LEN  12      // \0 dahil
+
+struct Scene {
+    char     name[SCENE_NAME_LEN];
+    uint32_t mask;              // bit i = 1 → ON
+    uint32_t change;            // yalnız 1 olan çıkışlara dokun
+};
+
+bool   sceneGet(uint8_t slot, Scene& out);          // boş slot → false
+bool   sceneDefine(uint8_t slot, const char* name, uint32_t mask, uint32_t change);
+bool   sceneDelete(uint8_t slot);
+int8_t sceneFind(const char* nameOrSlot);           // ad ya da "3" → slot / -1
+bool   sceneRecall(uint8_t slot, uint32_t* rejected); // rejected: kilitli bitler
@@ -0,0 +1,392 @@
+/**
+ * serial_console.cpp — bloklamayan seri komut satırı
+ * ------------------------------------------------------------
+ *  › Eski hâli: updateTemperatureControl() içinde
+ *      Serial.readStringUntil('\n')  → yarım satırda 1 s bekliyor,
+ *      üstelik heap'te String açıyordu.
+ *  › Yeni hâli:
+ *    – Her loop() turunda en fazla CON_RX_BUDGET byte okunur,
+ *      satır sabit boyutlu lineBuf[]'ta birikir (heap yok).
+ *    – Komut adı / yardım metni / fonksiyon işaretçisi flash'ta (PROGMEM).
+ *    – Çok satırlı cevaplar “satır üreteci” ile basılır: TX tamponunda
+ *      CON_OUT_MAX kadar yer yoksa o tur hiçbir şey yazılmaz, sonraki
+ *      turda kalınan satırdan devam edilir → Serial.print hiç beklemez.
+ *      Yarım kalmış bir log kaydı varsa (logIdle() == false) beklenir.
+ *
+ *  Komutlar
+ *    T<mod> <deg>   modül sıcaklığını elle ver (örn. T1 55)
+ *    T<mod> OFF     override'ı kaldır
+ *    cur            kanal bazında Irms / W / Wh
+ *    temp           modül sıcaklıkları, kilitler, fan seviyesi
+ *    stat [reset]   döngü ve görev süreleri (µs), boş RAM
+ *    cal            akım sensörü ofsetleri
+ *    prof [on|off|reset]  örneklemeli profil (flash bölgesi / görev)
+ *    sig            yük imzası: I1 / THD / sınıf / anomali (CS_HARMONICS)
+ *    pwr            güç bütçesi: toplam / bütçe, kanal öncelikleri, atılanlar
+ *    help           bu liste
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include "config.h"
+#include "serial_console.h"
+#include "temperature_control.h"
+#include "current_sense.h"
+#include "tanimlamalar.h"
+#include "log.h"
+#include "load_signature.h"
+#include "diag.h"
+#include "power_budget.h"
+
+//--------------------------------------------------------------
+//  KONFİG
+//--------------------------------------------------------------
+#define CON_LINE_MAX   32     // en uzun komut satırı (\0 dahil)
+#define CON_RX_BUDGET  16     // tur başına en fazla okunacak byte
+#define CON_OUT_MAX    48     // tek çıktı satırı (\r\n dahil) — TX tamponu 64
+
+//--------------------------------------------------------------
+//  DURUM
+//--------------------------------------------------------------
+static char    lineBuf[CON_LINE_MAX];
+static uint8_t lineLen      = 0;
+static bool    lineOverflow = false;    // satır taştı → tamamı yok sayılır
+
+/* Satır üreteci: row. satırı out'a yazar, false → çıktı bitti.
+   out[0] == '\0' bırakılırsa o satır atlanır (ör. sensörsüz kanal). */
+typedef bool (*ConRowFn)(uint8_t row, char* out, size_t n);
+
+static ConRowFn outFn    = nullptr;
+static uint8_t  outRow   = 0;
+static PGM_P    replyMsg = nullptr;     // tek satırlık cevap (flash)
+
+static void startOutput(ConRowFn fn) { outFn = fn; outRow = 0; }
+
+//--------------------------------------------------------------
+//  SATIR ÜRETEÇLERİ
+//--------------------------------------------------------------
+static bool rowReply(uint8_t row, char* out, size_t n)
+{
+    if (row > 0 || !replyMsg) return false;
+    strncpy_P(out, replyMsg, n - 3);
+    out[n - 3] = '\0';
+    strcat(out, "\r\n");
+    return true;
+}
+
+static void reply(PGM_P msg) { replyMsg = msg; startOutput(rowReply); }
+
+static bool rowCurrent(uint8_t row, char* out, size_t n)
+{
+    if (row >= NUM_Y_CHANNELS) return false;
+    if (!hasCurrentSensor(row)) { out[0] = '\0'; return true; }
+
+    char a[8], w[8], wh[10];
+    dtostrf(getIrms(row),   0, 2, a);
+    dtostrf(getPower(row),  0, 1, w);
+    dtostrf(getEnergy(row), 0, 1, wh);
+    snprintf_P(out, n, PSTR("Y%u I=%sA P=%sW E=%sWh\r\n"), row, a, w, wh);
+    return true;
+}
+
+static bool rowTemp(uint8_t row, char* out, size_t n)
+{
+    if (row < 4) {
+        char t[8], r[8];
+        dtostrf(getModuleTemp(row), 0, 1, t);
+        dtostrf(getRealTemp(row),   0, 1, r);
+        snprintf_P(out, n, PSTR("M%u T=%s ntc=%s%s lock=%u\r\n"),
+                   row, t, r, isTempOverridden(row) ? "*" : "",
+                   moduleLocked[row] ? 1 : 0);
+        return true;
+    }
+    if (row == 4) {
+        snprintf_P(out, n, PSTR("fan=%u\r\n"), getFanLevel());
+        return true;
+    }
+    return false;
+}
+
+static bool rowStat(uint8_t row, char* out, size_t n)
+{
+    if (row == 0) {
+        snprintf_P(out, n, PSTR("loop n=%lu\r\n"), (unsigned long)loopCount);
+        return true;
+    }
+    if (row == 1) {
+        snprintf_P(out, n, PSTR("  last=%lu max=%lu us\r\n"),
+                   (unsigned long)loopLastUs, (unsigned long)loopMaxUs);
+        return true;
+    }
+    if (row < 2 + TASK_COUNT) {
+        uint8_t t = row - 2;
+        char name[8];
+        diagTaskName(t, name, sizeof(name));
+        snprintf_P(out, n, PSTR("  %s max=%lu us\r\n"),
+                   name, (unsigned long)taskMaxUs[t]);
+        return true;
+    }
+    if (row == 2 + TASK_COUNT) {
+        snprintf_P(out, n, PSTR("ram free=%u min=%u stk=%u heap=%u\r\n"),
+                   diagFreeRam(), diagMinFreeRam(), diagStackMax(), diagHeapUsed());
+        return true;
+    }
+    return false;
+}
+
+/* Güç bütçesi: özet + sensörlü kanallar (p = öncelik, 0 atılmaz) */
+static bool rowPower(uint8_t row, char* out, size_t n)
+{
+    if (row == 0) {
+        snprintf_P(out, n, PSTR("toplam=%u W butce=%u W kayip=%u\r\n"),
+                   pbTotalW(), pbBudgetW(), pbDropped());
+        return true;
+    }
+    uint8_t ch = row - 1;
+    if (ch >= PB_CHANNELS) return false;
+    if (!hasCurrentSensor(ch)) { out[0] = '\0'; return true; }
+    snprintf_P(out, n, PSTR("Y%u p=%u %u W%s\r\n"), ch, pbPriority(ch), pbChannelW(ch),
+               pbIsShed(ch) ? " ATILDI" : "");
+    return true;
+}
+
+/* Profil: özet, boş olmayan flash bölgeleri (byte adresi), görevler */
+static bool rowProf(uint8_t row, char* out, size_t n)
+{
+    uint32_t tot = profTotal();
+    if (row == 0) {
+        snprintf_P(out, n, PSTR("prof %s n=%lu\r\n"),
+                   profRunning() ? "on" : "off", (unsigned long)tot);
+        return true;
+    }
+    row--;
+    if (tot == 0) return false;
+    if (row < PROF_BUCKETS) {
+        uint16_t c = profBucket(row);
+        if (c == 0) { out[0] = '\0'; return true; }
+        snprintf_P(out, n, PSTR("  0x%05lx %u\r\n"),
+                   (unsigned long)row << (PROF_SHIFT + 1), c);
+        return true;
+    }
+    row -= PROF_BUCKETS;
+    if (row <= TASK_SETUP) {
+        char name[8];
+        diagTaskName(row, name, sizeof(name));
+        snprintf_P(out, n, PSTR("  %s %u\r\n"), name, profTaskHits(row));
+        return true;
+    }
+    return false;
+}
+
+static bool rowCal(uint8_t row, char* out, size_t n)
+{
+    if (row >= NUM_Y_CHANNELS) return false;
+    if (!hasCurrentSensor(row)) { out[0] = '\0'; return true; }
+
+    uint16_t ofs = getOffsetADC(row);
+    char v[8];
+    dtostrf(ofs * (5.0f / 1023.0f), 0, 3, v);
+    snprintf_P(out, n, PSTR("Y%u ofs=%u (%sV)\r\n"), row, ofs, v);
+    return true;
+}
+
+#if CS_HARMONICS
+static const char sigCls[][5] PROGMEM = { "off", "res", "ind", "elec" };
+static const char sigWhy[][7] PROGMEM = { "", " !sap", " !acik" };
+
+static bool rowSig(uint8_t row, char* out, size_t n)
+{
+    if (row == NUM_Y_CHANNELS) {
+        snprintf_P(out, n, PSTR("atilan blok=%u\r\n"), lsLostBlocks());
+        return true;
+    }
+    if (row > NUM_Y_CHANNELS) return false;
+    if (!hasCurrentSensor(row)) { out[0] = '\0'; return true; }
+
+    char cls[5], why[7];
+    strcpy_P(cls, sigCls[lsClass(row) & 3]);
+    strcpy_P(why, sigWhy[lsAnomaly(row) % 3]);
+    uint16_t i1 = lsFundamentalCA(row), b = lsBaselineCA(row);
+    snprintf_P(out, n, PSTR("Y%u %u.%02u/%u.%02uA thd%u %u/%u %s%s\r\n"),
+               row, i1 / 100, i1 % 100, b / 100, b % 100,
+               lsThd(row), lsRatio(row, 3), lsRatio(row, 5), cls, why);
+    return true;
+}
+#endif
+
+//--------------------------------------------------------------
+//  KOMUTLAR
+//--------------------------------------------------------------
+static const char msgOk[]   PROGMEM = "OK";
+static const char msgErr[]  PROGMEM = "? (help)";
+static const char msgLong[] PROGMEM = "? satir cok uzun";
+
+/** T<mod> <deg> | T<mod> OFF  — args "1 55" / "1 OFF" */
+static void cmdTemp(const char* args)
+{
+    if (args[0] < '0' || args[0] > '3') { reply(msgErr); return; }
+    uint8_t m = args[0] - '0';
+    const char* rest = args + 1;
+
+    if (strstr_P(rest, PSTR("OFF"))) setTempOverride(m, false, 0.0f);
+    else                             setTempOverride(m, true, atof(rest));
+    reply(msgOk);
+}
+
+static void cmdCur (const char*) { startOutput(rowCurrent); }
+static void cmdTmp (const char*) { startOutput(rowTemp); }
+static void cmdCal (const char*) { startOutput(rowCal); }
+static void cmdPwr (const char*) { startOutput(rowPower); }
+#if CS_HARMONICS
+static void cmdSig (const char*) { startOutput(rowSig); }
+#endif
+
+static void cmdProf(const char* args)
+{
+    if      (strncmp_P(args, PSTR("on"), 2)    == 0) { profStart(); reply(msgOk); }
+    else if (strncmp_P(args, PSTR("off"), 3)   == 0) { profStop();  reply(msgOk); }
+    else if (strncmp_P(args, PSTR("reset"), 5) == 0) { profReset(); reply(msgOk); }
+    else startOutput(rowProf);
+}
+
+static void cmdStat(const char* args)
+{
+    if (strncmp_P(args, PSTR("reset"), 5) == 0) {
+        loopMaxUs = 0;
+        for (uint8_t i = 0; i < TASK_COUNT; ++i) taskMaxUs[i] = 0;
+        reply(msgOk);
+        return;
+    }
+    startOutput(rowStat);
+}
+
+static bool rowHelp(uint8_t row, char* out, size_t n);
+static void cmdHelp(const char*) { startOutput(rowHelp); }
+
+struct ConCmd {
+    PGM_P name;
+    void (*fn)(const char* args);
+    PGM_P help;
+};
+
+static const char nT[]    PROGMEM = "T";
+static const char nCur[]  PROGMEM = "cur";
+static const char nTmp[]  PROGMEM = "temp";
+static const char nStat[] PROGMEM = "stat";
+static const char nCal[]  PROGMEM = "cal";
+static const char nProf[] PROGMEM = "prof";
+static const char nPwr[]  PROGMEM = "pwr";
+static const char nHelp[] PROGMEM = "help";
+#if CS_HARMONICS
+static const char nSig[]  PROGMEM = "sig";
+static const char hSig[]  PROGMEM = "I1/taban A, THD, r3/r5 %, sinif";
+#endif
+
+static const char hT[]    PROGMEM = "<mod> <deg>|OFF  sicaklik override";
+static const char hCur[]  PROGMEM = "kanal Irms / W / Wh";
+static const char hTmp[]  PROGMEM = "modul sicakliklari + fan";
+static const char hStat[] PROGMEM = "[reset] dongu sureleri";
+static const char hCal[]  PROGMEM = "akim sensoru ofsetleri";
+static const char hProf[] PROGMEM = "[on|off|reset] PC profili";
+static const char hPwr[]  PROGMEM = "toplam guc, butce, oncelik, atilan";
+static const char hHelp[] PROGMEM = "bu liste";
+
+static const ConCmd cmdTable[] PROGMEM = {
+    { nT,    cmdTemp, hT    },
+    { nCur,  cmdCur,  hCur  },
+    { nTmp,  cmdTmp,  hTmp  },
+    { nStat, cmdStat, hStat },
+    { nCal,  cmdCal,  hCal  },
+    { nProf, cmdProf, hProf },
+    { nPwr,  cmdPwr,  hPwr  },
+#if CS_HARMONICS
+    { nSig,  cmdSig,  hSig  },
+#endif
+    { nHelp, cmdHelp, hHelp },
+};
+static const uint8_t CMD_COUNT = sizeof(cmdTable) / sizeof(cmdTable[0]);
+
+static bool rowHelp(uint8_t row, char* out, size_t n)
+{
+    if (row >= CMD_COUNT) return false;
+    ConCmd c; memcpy_P(&c, &cmdTable[row], sizeof(c));
+
+    char name[6];
+    strncpy_P(name, c.name, sizeof(name));
+    name[sizeof(name) - 1] = '\0';
+
+    uint8_t len = snprintf_P(out, n, PSTR("%-5s "), name);
+    strncpy_P(out + len, c.help, n - len - 3);
+    out[n - 3] = '\0';
+    strcat(out, "\r\n");
+    return true;
+}
+
+/** Satırı tabloda ara: ad eşleşmeli ve ardından harf gelmemeli
+    (“T1 55” → T, “stat reset” → stat). */
+static void dispatch(char* ln)
+{
+    while (*ln == ' ') ++ln;
+    if (*ln == '\0') return;
+
+    for (uint8_t i = 0; i < CMD_COUNT; ++i) {
+        ConCmd c; memcpy_P(&c, &cmdTable[i], sizeof(c));
+        size_t len = strlen_P(c.name);
+        if (strncmp_P(ln, c.name, len) != 0) continue;
+
+        char next = ln[len];
+        if ((next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z')) continue;
+
+        const char* args = ln + len;
+        while (*args == ' ') ++args;
+        c.fn(args);
+        return;
+    }
+    reply(msgErr);
+}
+
+//--------------------------------------------------------------
+//  KAMUYA AÇIK
+//--------------------------------------------------------------
+void initSerialConsole()
+{
+    lineLen      = 0;
+    lineOverflow = false;
+    startOutput(rowHelp);       // açılışta komut listesi
+}
+
+void serviceSerialConsole()
+{
+    //----------------------------------
+    // 1) Bekleyen çıktıdan bir satır
+    //----------------------------------
+    if (outFn && logIdle() && Serial.availableForWrite() >= CON_OUT_MAX) {
+        char out[CON_OUT_MAX];
+        out[0] = '\0';
+        if (outFn(outRow, out, sizeof(out))) {
+            if (out[0]) Serial.write((const uint8_t*)out, strlen(out));
+            outRow++;
+        } else {
+            outFn = nullptr;
+        }
+    }
+
+    //----------------------------------
+    // 2) Gelen byte'lar (sınırlı bütçe)
+    //----------------------------------
+    for (uint8_t k = 0; k < CON_RX_BUDGET && Serial.available() > 0; ++k) {
+        char c = (char)Serial.read();
+
+        if (c == '\r' || c == '\n') {
+            if (lineOverflow)      reply(msgLong);
+            else if (lineLen > 0) { lineBuf[lineLen] = '\0'; dispatch(lineBuf); }
+            lineLen      = 0;
+            lineOverflow = false;
+        }
+        else if (lineLen < CON_LINE_MAX - 1) {
+            lineBuf[lineLen++] = c;
+        }
+        else {
+            lineOverflow = true;
+        }
+    }
+}
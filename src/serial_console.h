@@ -0,0 +1,14 @@
+/**
+ *  serial_console.h
+ *  ----------------
+ *  – Seri porttan byte byte komut satırı topla (asla bekleme),
+ *  – Komutu flash'taki tablodan bul ve çalıştır,
+ *  – Çok satırlı cevapları TX tamponunda yer oldukça satır satır bas.
+ *
+ *  Komutlar:  T<mod> <deg> | T<mod> OFF | cur | temp | stat | cal | help
+ */
+#pragma once
+#include <Arduino.h>
+
+void initSerialConsole();      // setup()’tan çağır (yardım satırını kuyruğa alır)
+void serviceSerialConsole();   // her loop() turunda çağır — bloklamaz
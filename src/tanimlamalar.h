@@ -5,3 +5,24 @@ extern volatile bool dirty[32];
 
 extern volatile bool moduleLocked[8];   // true → HA komutu yok say
 
+
+/* ---------- Döngü zamanlama istatistikleri (main.cpp) ---------- */
+enum LoopTask : uint8_t {
+    TASK_MQTT = 0,      // mqttLoop + state kuyruğu
+    TASK_FAN,           // updateTemperatureControl
+    TASK_CURRENT,       // sampleCurrentSensors
+    TASK_ENERGY,        // energyTick
+    TASK_PUBLISH,       // mqttPublishPowerEnergy
+    TASK_RULES,         // rulesTick
+    TASK_COUNT
+};
+
+#define TASK_OTHER  TASK_COUNT          // görev dışı (konsol, log, zamanlayıcılar…)
+#define TASK_SETUP  (TASK_COUNT + 1)    // setup() sürüyor
+
+extern volatile uint8_t activeTask;        // profil + WDT ölüm kaydı (diag.cpp)
+
+extern uint32_t loopCount;                 // toplam loop() turu
+extern uint32_t loopLastUs;                // son turun süresi (µs)
+extern uint32_t loopMaxUs;                 // en uzun tur (µs)
+extern uint32_t taskMaxUs[TASK_COUNT];     // görev bazlı en uzun süre (µs)
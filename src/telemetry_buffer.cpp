@@ -0,0 +1,290 @@
+/**
+ * telemetry_buffer.cpp — çevrimdışı telemetri tamponu
+ * ------------------------------------------------------------
+ *  › Sorun: MQTT kopukken mqttPublishPowerEnergy() / mqttPublishAlert()
+ *    sessizce başarısız oluyordu; kesinti süresince enerji geçmişi ve
+ *    aşırı ısınma uyarıları kayboluyordu.
+ *  › RAM halkası: TB_RING_RECS × 4 byte kayıt
+ *      [0] kind<<4 | ch      [1] dt (s, önceki kayda göre)   [2..3] int16
+ *    – Zaman damgası delta kodlu; 255 s’den uzun boşluk için
+ *      TB_ESCAPE kaydı (24 bit dt) araya girer.
+ *    – Güç yalnız TB_POWER_DELTA_W’dan fazla değişince, enerji
+ *      TB_ENERGY_PERIOD_S’de bir ARTIŞ olarak yazılır.
+ *    – Halka dolarsa en eski kayıt düşer, tailTs yeni kuyruğa kaydırılır.
+ *  › EEPROM (EE_ALERTS_ADDR): [0] sonraki yuva, sonra TB_EE_ALERTS × 8 byte
+ *      [0] TB_EE_MAGIC  [1] mod | closed<<7 | epoch<<6  [2..3] 0.1 °C  [4..7] ts
+ *    Güç kesilse de uyarılar kaybolmaz; gönderilince yuva boşaltılır.
+ *  › Geri oynatma (tbReplay, mqttServiceReplay’den): paket tbPeekAt()
+ *    ile silmeden kurulur, yayın başarılıysa o kadar tbPop() → bağlantı
+ *    yine koparsa olaylar tamponda kalır.
+ * ------------------------------------------------------------*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "eeprom_map.h"
+#include "telemetry_buffer.h"
+#include "current_sense.h"
+
+#define TB_RING_RECS        96      // 384 byte
+#define TB_POWER_DELTA_W    20      // bu kadar değişmezse güç kaydı yok
+#define TB_ENERGY_PERIOD_S  60
+#define TB_ESCAPE           0x0F    // kind: yalnız uzun dt taşır
+
+#define TB_EE_ALERTS        8
+#define TB_EE_MAGIC         0xA1
+#define TB_EE_REC           8
+
+static_assert(1 + TB_EE_ALERTS * TB_EE_REC <= EE_ALERTS_SIZE, "uyari bolgesi EEPROM'a sigmiyor");
+
+//--------------------------------------------------------------
+//  ZAMAN
+//--------------------------------------------------------------
+static uint32_t upSec    = 0;
+static uint16_t upAccMs  = 0;
+static uint32_t upLastMs = 0;
+static int32_t  epochOfs = 0;       // epoch = uptime + epochOfs
+static bool     epochOk  = false;
+
+void tbTick()
+{
+    uint32_t now = millis();
+    uint32_t d   = now - upLastMs;  // taşmaya dayanıklı
+    upLastMs = now;
+    d += upAccMs;
+    upSec  += d / 1000;
+    upAccMs = d % 1000;
+}
+
+uint32_t tbUptime()       { return upSec; }
+bool     tbEpochValid()   { return epochOk; }
+
+void tbSetEpoch(uint32_t epoch)
+{
+    epochOfs = (int32_t)(epoch - upSec);
+    epochOk  = true;
+}
+
+//--------------------------------------------------------------
+//  RAM HALKASI
+//--------------------------------------------------------------
+static uint8_t  ring[TB_RING_RECS][4];
+static uint8_t  rHead = 0, rTail = 0, rCount = 0;
+static uint32_t tailTs = 0;         // kuyruktaki kaydın uptime’ı
+static uint32_t lastTs = 0;         // en yeni kaydın uptime’ı
+static uint16_t dropCnt = 0;
+
+static int16_t  lastPowerW[NUM_Y_CHANNELS];
+static float    energyMark[NUM_Y_CHANNELS];
+static uint32_t tEnergyRec = 0;
+
+static inline uint32_t recDt(const uint8_t* r)
+{
+    if ((r[0] >> 4) == TB_ESCAPE)
+        return r[1] | ((uint32_t)r[2] << 8) | ((uint32_t)r[3] << 16);
+    return r[1];
+}
+
+static void advanceTail()
+{
+    rTail = (rTail + 1) % TB_RING_RECS;
+    rCount--;
+    if (rCount) tailTs += recDt(ring[rTail]);
+}
+
+static void dropTail()
+{
+    if ((ring[rTail][0] >> 4) != TB_ESCAPE) dropCnt++;
+    advanceTail();
+}
+
+static void pushRaw(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3)
+{
+    if (rCount == TB_RING_RECS) dropTail();
+    uint8_t* r = ring[rHead];
+    r[0] = b0; r[1] = b1; r[2] = b2; r[3] = b3;
+    rHead = (rHead + 1) % TB_RING_RECS;
+    rCount++;
+}
+
+static void append(uint8_t kind, uint8_t ch, int16_t val)
+{
+    uint32_t now = upSec;
+    if (rCount == 0) { tailTs = now; lastTs = now; }
+
+    uint32_t dt = now - lastTs;
+    if (dt > 0xFF) {                               // uzun boşluk → kaçış kaydı
+        if (dt > 0xFFFFFFUL) dt = 0xFFFFFFUL;
+        pushRaw(TB_ESCAPE << 4, dt, dt >> 8, dt >> 16);
+        dt = 0;
+    }
+    pushRaw((kind << 4) | (ch & 0x0F), dt, val & 0xFF, (uint16_t)val >> 8);
+    lastTs = now;
+}
+
+//--------------------------------------------------------------
+//  EEPROM UYARILARI
+//--------------------------------------------------------------
+static inline int eeSlot(uint8_t i) { return EE_ALERTS_ADDR + 1 + i * TB_EE_REC; }
+
+void tbStoreAlert(uint8_t mod, float deg, bool closed)
+{
+    uint8_t i = EEPROM.read(EE_ALERTS_ADDR);
+    if (i >= TB_EE_ALERTS) i = 0;
+
+    int16_t  t10 = isnan(deg) ? INT16_MIN : (int16_t)(deg * 10.0f);
+    uint32_t ts  = epochOk ? upSec + epochOfs : upSec;
+    uint8_t  rec[TB_EE_REC] = {
+        TB_EE_MAGIC,
+        (uint8_t)((mod & 0x0F) | (closed ? 0x80 : 0) | (epochOk ? 0x40 : 0)),
+        (uint8_t)t10, (uint8_t)((uint16_t)t10 >> 8),
+        (uint8_t)ts, (uint8_t)(ts >> 8), (uint8_t)(ts >> 16), (uint8_t)(ts >> 24)
+    };
+    for (uint8_t k = 0; k < TB_EE_REC; ++k) EEPROM.update(eeSlot(i) + k, rec[k]);
+    EEPROM.update(EE_ALERTS_ADDR, (i + 1) % TB_EE_ALERTS);   // en eskinin üstüne
+}
+
+/** En eski dolu yuva (yazma sırasına göre), yoksa -1 */
+static int8_t oldestAlertSlot()
+{
+    uint8_t start = EEPROM.read(EE_ALERTS_ADDR);
+    if (start >= TB_EE_ALERTS) start = 0;
+    for (uint8_t k = 0; k < TB_EE_ALERTS; ++k) {
+        uint8_t i = (start + k) % TB_EE_ALERTS;
+        if (EEPROM.read(eeSlot(i)) == TB_EE_MAGIC) return i;
+    }
+    return -1;
+}
+
+//--------------------------------------------------------------
+//  KAMUYA AÇIK
+//--------------------------------------------------------------
+void tbInit()
+{
+    upLastMs = millis();
+    rHead = rTail = rCount = 0;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ++ch) {
+        lastPowerW[ch] = 0;
+        energyMark[ch] = 0.0f;
+    }
+}
+
+void tbRecordTelemetry()
+{
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ++ch) {
+        if (!hasCurrentSensor(ch)) continue;
+        int16_t p = (int16_t)(Y_powerW[ch] + 0.5f);
+        if (abs(p - lastPowerW[ch]) >= TB_POWER_DELTA_W) {
+            append(TB_POWER, ch, p);
+            lastPowerW[ch] = p;
+        }
+    }
+
+    if (upSec - tEnergyRec < TB_ENERGY_PERIOD_S) return;
+    tEnergyRec = upSec;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ++ch) {
+        if (!hasCurrentSensor(ch)) continue;
+        float   d   = (Y_energyWh[ch] - energyMark[ch]) * 10.0f;
+        int16_t inc = (d > 32767.0f) ? 32767 : (int16_t)d;
+        if (inc <= 0) continue;
+        append(TB_ENERGY, ch, inc);
+        energyMark[ch] += inc / 10.0f;
+    }
+}
+
+/** Canlı yayın yapıldı → bir sonraki kesinti buradan itibaren ölçülsün */
+void tbSyncBaseline()
+{
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ++ch) {
+        lastPowerW[ch] = (int16_t)(Y_powerW[ch] + 0.5f);
+        energyMark[ch] = Y_energyWh[ch];
+    }
+    tEnergyRec = upSec;
+}
+
+bool tbPeekAt(uint8_t i, TbEvent& ev)
+{
+    /* 1) EEPROM’daki uyarılar önce (yazma sırasıyla) */
+    uint8_t start = EEPROM.read(EE_ALERTS_ADDR);
+    if (start >= TB_EE_ALERTS) start = 0;
+    for (uint8_t k = 0; k < TB_EE_ALERTS; ++k) {
+        int s = eeSlot((start + k) % TB_EE_ALERTS);
+        if (EEPROM.read(s) != TB_EE_MAGIC) continue;
+        if (i) { i--; continue; }
+
+        uint8_t r[TB_EE_REC];
+        for (uint8_t b = 0; b < TB_EE_REC; ++b) r[b] = EEPROM.read(s + b);
+        ev.kind  = (r[1] & 0x80) ? TB_ALERT : TB_RESTORED;
+        ev.epoch = r[1] & 0x40;
+        ev.ch    = r[1] & 0x0F;
+        ev.val   = (int16_t)(r[2] | (r[3] << 8));
+        ev.ts    = r[4] | ((uint32_t)r[5] << 8) | ((uint32_t)r[6] << 16) | ((uint32_t)r[7] << 24);
+        return true;
+    }
+
+    /* 2) RAM halkası — kaçış kayıtları yalnız zamanı taşır */
+    uint32_t ts = tailTs;
+    for (uint8_t k = 0; k < rCount; ++k) {
+        const uint8_t* r = ring[(rTail + k) % TB_RING_RECS];
+        if (k) ts += recDt(r);
+        if ((r[0] >> 4) == TB_ESCAPE) continue;
+        if (i) { i--; continue; }
+
+        ev.kind  = r[0] >> 4;
+        ev.ch    = r[0] & 0x0F;
+        ev.val   = (int16_t)(r[2] | (r[3] << 8));
+        ev.epoch = epochOk;
+        ev.ts    = epochOk ? ts + epochOfs : ts;
+        return true;
+    }
+    return false;
+}
+
+bool tbPeek(TbEvent& ev) { return tbPeekAt(0, ev); }
+
+void tbPop()
+{
+    int8_t s = oldestAlertSlot();
+    if (s >= 0) { EEPROM.update(eeSlot(s), 0xFF); return; }
+
+    while (rCount && (ring[rTail][0] >> 4) == TB_ESCAPE) advanceTail();
+    if (rCount) advanceTail();
+}
+
+uint16_t tbPending()
+{
+    uint16_t n = rCount;
+    for (uint8_t i = 0; i < TB_EE_ALERTS; ++i)
+        if (EEPROM.read(eeSlot(i)) == TB_EE_MAGIC) n++;
+    return n;
+}
+
+uint16_t tbDropped() { return dropCnt; }
+
+//--------------------------------------------------------------
+//  GERİ OYNATMA
+//--------------------------------------------------------------
+/* {"clk":"epoch"|"up","ev":[[ts,"p",ch,W],…]} — saat türü değişince paket biter */
+uint8_t tbReplay(bool (*publish)(const char* payload))
+{
+    TbEvent ev;
+    if (!tbPeek(ev)) return 0;
+
+    char   payload[TB_REPLAY_PAYLOAD];
+    size_t n = snprintf_P(payload, sizeof(payload), PSTR("{\"clk\":\"%s\",\"ev\":["),
+                          ev.epoch ? "epoch" : "up");
+    bool clkEpoch = ev.epoch;
+
+    uint8_t k = 0;                                  // pakete giren olay
+    for (; k < TB_REPLAY_BATCH && tbPeekAt(k, ev); ++k) {
+        if (ev.epoch != clkEpoch) break;
+        static const char kinds[] PROGMEM = "?pear";
+        char kc = (ev.kind < sizeof(kinds) - 1) ? pgm_read_byte(kinds + ev.kind) : '?';
+        n += snprintf_P(payload + n, sizeof(payload) - n, PSTR("%s[%lu,\"%c\",%u,%d]"),
+                        k ? "," : "", (unsigned long)ev.ts, kc, ev.ch, ev.val);
+    }
+    snprintf_P(payload + n, sizeof(payload) - n, PSTR("]}"));
+
+    if (!publish(payload)) return 0;                // olaylar tamponda, sonra yeniden
+    for (uint8_t i = 0; i < k; ++i) tbPop();
+    return k;
+}
@@ -0,0 +1,49 @@
+/**
+ *  telemetry_buffer.h
+ *  ------------------
+ *  – Broker yokken güç/enerji örneklerini RAM halkasında biriktir,
+ *  – Aşırı ısınma uyarılarını EEPROM’a yaz (yeniden başlatmaya dayanır),
+ *  – Bağlantı gelince mqtt_haberlesme.cpp bunları hız sınırlı geri oynatır,
+ *  – <FLOOR_ID>/time/set ile uptime → gerçek zaman eşlemesi.
+ */
+#pragma once
+#include <Arduino.h>
+
+enum TbKind : uint8_t {
+    TB_POWER    = 1,    // val = W (değişince)
+    TB_ENERGY   = 2,    // val = 0.1 Wh artış (son kayıttan beri)
+    TB_ALERT    = 3,    // ch = modül, val = 0.1 °C, kapatıldı
+    TB_RESTORED = 4,    // ch = modül, val = 0.1 °C, geri açıldı
+};
+
+struct TbEvent {
+    uint32_t ts;        // epoch (epoch == true) ya da uptime saniyesi
+    bool     epoch;
+    uint8_t  kind;      // TbKind
+    uint8_t  ch;
+    int16_t  val;
+};
+
+void     tbInit();
+void     tbTick();                         // her loop() turu (uptime sayacı)
+uint32_t tbUptime();                       // s, millis taşmasından etkilenmez
+void     tbSetEpoch(uint32_t epoch);       // time/set
+bool     tbEpochValid();
+
+void     tbRecordTelemetry();              // çevrimdışıyken 10 s’de bir
+void     tbSyncBaseline();                 // canlı yayın sonrası referansı güncelle
+void     tbStoreAlert(uint8_t mod, float deg, bool closed);
+
+bool     tbPeek(TbEvent& ev);              // en eski olay (önce EEPROM uyarıları)
+bool     tbPeekAt(uint8_t i, TbEvent& ev); // i. olay (0 = en eski), silmez
+void     tbPop();                          // tbPeek’in verdiğini sil
+uint16_t tbPending();                      // bekleyen olay sayısı (yaklaşık)
+uint16_t tbDropped();                      // halka dolunca düşen kayıt
+
+#define TB_REPLAY_BATCH   4                // paket başına en çok olay
+#define TB_REPLAY_EV_MAX  28               // ,[4294967295,"p",15,-32768]
+#define TB_REPLAY_PAYLOAD (20 + TB_REPLAY_BATCH * TB_REPLAY_EV_MAX + 3)
+
+/** En eski olaylardan geri oynatma paketi kurar, publish’e verir; true
+ *  dönerse o olaylar silinir, false → hiçbiri. Sonuç: silinen olay */
+uint8_t  tbReplay(bool (*publish)(const char* payload));
@@ -16,6 +16,8 @@
 #include "pinmap.h"
 #include "mqtt_haberlesme.h"
 #include "tanimlamalar.h"
+#include "log.h"
+#include "outputs.h"               // outputForce / outputsZeroCross
 
 // ---- Yardımcılar (dosyanın başına uygun bir yere) ----
 extern void cs_pauseADC();
@@ -105,20 +107,16 @@ static void switchModule(uint8_t mod, bool on)
 {
     uint8_t base = mod * 4;
     for (uint8_t i = 0; i < 4; ++i) {
-        uint8_t idx = base + i;
-        digitalWrite(yMap[idx], on ? HIGH : LOW);
-        pinState[idx] = on;
-        dirty[idx]    = true;
+        outputForce(base + i, on);          // kilide bakmadan sür
     }
 }
 inline void disableModule(uint8_t m) { switchModule(m, false); }
 inline void enableModule (uint8_t m) { switchModule(m, true ); }
 
-/** ZCD kesmesini yönet */
+/** ZCD kesmesi sürekli açık: fan faz kesimi + çıkış anahtarlama kuyruğu
+    (outputsZeroCross) aynı kesmeyi kullanır. */
 static void attachZCD()
 { attachInterrupt(digitalPinToInterrupt(ZERO_CROSS_PIN), zeroCrossISR, RISING); zcdEnabled = true; }
-static void detachZCD()
-{ detachInterrupt(digitalPinToInterrupt(ZERO_CROSS_PIN)); zcdEnabled = false; }
 
 //--------------------------------------------------------------
 //  KURULUM
@@ -129,34 +127,47 @@ void initTemperatureControl()
     digitalWrite(FAN_TRIAC_PIN, LOW);
 
     pinMode(ZERO_CROSS_PIN, INPUT);
-    attachZCD();          // kesme hazırla (başta hemen kapatılacak)
-    detachZCD();
+    attachZCD();          // fan PWM’i + sıfır geçişte çıkış anahtarlama
 
-    Serial.println(F("[T cmd]  T<mod> <deg>  |  T<mod> OFF"));
 }
 
+//--------------------------------------------------------------
+//  TERMİNAL OVERRIDE & DURUM OKUMA (serial_console.cpp)
+//--------------------------------------------------------------
+bool setTempOverride(uint8_t mod, bool en, float deg)
+{
+    if (mod > 3) return false;
+    overrideEn[mod]   = en;
+    overrideTemp[mod] = deg;
+    return true;
+}
+
+float getModuleTemp(uint8_t mod)
+{
+    if (mod > 3) return NAN;
+    return overrideEn[mod] ? overrideTemp[mod] : realTemp[mod];
+}
+
+/** Kilitliyken kapatılan çıkış (ör. süresi dolan zamanlayıcı) soğuyunca
+    yeniden açılmasın: kilit öncesi maskeden düş. */
+void tempControlForgetRestore(uint8_t idx)
+{
+    if (idx >= 16) return;
+    preMask[idx / 4] &= ~(1 << (idx % 4));
+}
+
+float getRealTemp(uint8_t mod)       { return (mod > 3) ? NAN : realTemp[mod]; }
+bool  isTempOverridden(uint8_t mod)  { return (mod <= 3) && overrideEn[mod]; }
+uint8_t getFanLevel()                { return fanLevel; }
+
 //--------------------------------------------------------------
 //  ANA GÜNCELLEME (≈ 2 s)
 //--------------------------------------------------------------
 void updateTemperatureControl()
 {
     //----------------------------------
-    // 1) Terminal komutlarını işle
+    // 1) Terminal komutları → serviceSerialConsole() / setTempOverride()
     //----------------------------------
-    if (Serial.available()) {
-        String ln = Serial.readStringUntil('\n'); ln.trim();
-        if (ln.length() >= 2 && ln[0] == 'T') {
-            int m = ln[1] - '0'; if (m >= 0 && m <= 3) {
-                if (ln.endsWith("OFF")) {
-                    overrideEn[m] = false;
-                } else {
-                    float v = ln.substring(2).toFloat();
-                    overrideEn[m]   = true;
-                    overrideTemp[m] = v;
-                }
-            }
-        }
-    }
 
     //----------------------------------
     // 2) Sıcaklık okuma
@@ -171,14 +182,13 @@ void updateTemperatureControl()
         T[i] = overrideEn[i] ? overrideTemp[i] : realTemp[i];
 
 #if TEMP_SERIAL_DEBUG
-    Serial.print(F("T[°C]: "));
-    for (uint8_t i = 0; i < 4; ++i) {
-        Serial.print(T[i], 1);
-        if (i < 3) Serial.print(',');
+    {
+        int dC[4];                                   // 0.1 °C (printf'te %f yok)
+        for (uint8_t i = 0; i < 4; ++i)
+            dC[i] = isnan(T[i]) ? -9999 : (int)(T[i] * 10.0f);
+        LOG_D("T[0.1C]: %d,%d,%d,%d  fanLevel=%u",
+              dC[0], dC[1], dC[2], dC[3], fanLevel);
     }
-    Serial.print(F("  fanLevel="));
-    Serial.println(fanLevel);     // 0,1,2 olarak yazar
-
 #endif
 
     //----------------------------------
@@ -196,7 +206,6 @@ switch (fanLevel)
 case 0:   // Kapalı
     if (Tmax >= FAN_LVL1_IN_C) {
         fanLevel = 1;                     // 0 ➜ 1
-        attachZCD();
         setFanSpeed(FAN_LVL1_SPEED_PCT);
     }
     break;
@@ -204,12 +213,10 @@ case 0:   // Kapalı
 case 1:   // PWM
     if (Tmax >= FAN_LVL2_IN_C) {
         fanLevel = 2;                     // 1 ➜ 2
-        detachZCD();
         digitalWrite(FAN_TRIAC_PIN, HIGH);
     }
     else if (Tmax <= FAN_LVL1_OUT_C) {
         fanLevel = 0;                     // 1 ➜ 0
-        detachZCD();
         digitalWrite(FAN_TRIAC_PIN, LOW);
     }
     break;
@@ -217,7 +224,6 @@ case 1:   // PWM
 case 2:   // Tam hız
     if (Tmax <= FAN_LVL2_OUT_C) {
         fanLevel = 1;                     // 2 ➜ 1
-        attachZCD();
         setFanSpeed(FAN_LVL1_SPEED_PCT);
     }
     break;
@@ -240,6 +246,7 @@ case 2:   // Tam hız
         moduleLocked[hot] = true;
         disableModule(hot);
 
+        LOG_W("Modul %u kilitlendi (%d C)", hot, (int)Tmax);
         mqttPublishAlert(hot, Tmax, true);
         haNotify("Aşırı Isınma", "Modül kapatıldı");
     }
@@ -255,10 +262,9 @@ case 2:   // Tam hız
             for (uint8_t i = 0; i < 4; ++i) {
                 uint8_t idx = m * 4 + i;
                 bool on = preMask[m] & (1 << i);
-                digitalWrite(yMap[idx], on ? HIGH : LOW);
-                pinState[idx] = on;
-                dirty[idx]    = true;
+                outputForce(idx, on);
             }
+            LOG_I("Modul %u kilit cozuldu (%d C)", m, (int)T[m]);
             mqttPublishAlert(m, T[m], false);
             haNotify("Isı Normal", "Modül açıldı");
         }
@@ -274,7 +280,12 @@ case 2:   // Tam hız
 //--------------------------------------------------------------
 //  ZCD → bayrak + tetik servisleri
 //--------------------------------------------------------------
-void zeroCrossISR() { zcTimestamp = micros(); zcFlag = true; }
+void zeroCrossISR()
+{
+    zcTimestamp = micros();
+    zcFlag      = true;
+    outputsZeroCross();        // bekleyen çıkış değişikliklerini uygula
+}
 
 void serviceTriac()
 {   
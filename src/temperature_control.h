@@ -12,3 +12,10 @@
 void initTemperatureControl();   // setup()’tan çağır
 void updateTemperatureControl(); // döngüde ~2 sn’de bir çağır
 void serviceTriac();
+
+bool    setTempOverride(uint8_t mod, bool en, float deg); // T<mod> <deg>/OFF
+float   getModuleTemp(uint8_t mod);     // override varsa onu döndürür (°C)
+float   getRealTemp(uint8_t mod);       // NTC'den okunan (°C)
+bool    isTempOverridden(uint8_t mod);
+uint8_t getFanLevel();                  // 0 kapalı, 1 PWM, 2 tam hız
+void    tempControlForgetRestore(uint8_t idx); // kilit açılınca bu Y’yi açma
@@ -0,0 +1,178 @@
+/**
+ * wave_capture.cpp — isteğe bağlı ham dalga biçimi yakalama
+ * ------------------------------------------------------------
+ *  › Sorun: ISR yalnız Σ(i²) tutuyor; gürültülü bir ACS712’yi ya da
+ *    tuhaf davranan bir yükü görmek için karta osiloskop bağlanıyordu.
+ *  › Yakalama Timer1 ISR’inin içinde: ISR maskedeki (waveMask) kanalın
+ *    ham değerini buraya da verir. Tetik beklenirken ISR normal sırasında
+ *    kalır (tetik kanalı 12 kanalda 4 kHz / 12 ≈ 333 Hz’le örneklenir);
+ *    tetik düşünce waveStep = maske → kalan WAVE_SAMPLES − pre örnek
+ *    tam hızla yalnız maskeden. Aynı örnek Σ(i²)’ye de girer → Irms /
+ *    güç bütçesi bozulmaz, maskede olmayan kanalların Irms’i yalnız bu
+ *    son kısımda (tek kanalda 240 / 4 kHz = 60 ms, tetiksiz 80 ms)
+ *    gecikir. Goertzel blokları (CS_HARMONICS) örnek hızı değiştiği için
+ *    o kısımda beslenmez, sonunda atılır.
+ *  › Maskedeki kanallar iki kısımda da artan sırayla döner; yalnız
+ *    aralıklar farklı: tetiğe kadar `scan` sırasındaki uzaklık, sonra
+ *    birer tik (tools/wave_plot.py zamanı buna göre kurar).
+ *  › Tampon 10 bit paketli halka: 4 örnek → 4 alt byte + 1 byte’ta
+ *    4 × 2 üst bit. ISR’de bölme yok: grup başı byte adresi artımlı.
+ *  › Tetikli kipte halka sürekli yazılır; tetik ancak en az `pre` örnek
+ *    birikmişse kabul edilir, sonra WAVE_SAMPLES − pre örnek daha alınır
+ *    → tampon tetiğin çevresindeki son WAVE_SAMPLES örnektir.
+ *  › Akıtma mqtt_haberlesme.cpp’de (mqttServiceWave); bu dosya ağ
+ *    bilmez.
+ * ------------------------------------------------------------*/
+#include "config.h"
+#if WAVE_CAPTURE
+
+#include <Arduino.h>
+#include "wave_capture.h"
+#include "current_sense.h"
+#include "load_signature.h"
+
+volatile uint16_t waveMask = 0;
+volatile uint16_t waveStep = 0;
+
+static uint8_t           buf[WAVE_BYTES];
+static volatile uint8_t  state = WAVE_IDLE;
+static volatile bool     force = false;     // zaman aşımı → sıradaki tetik kanalı örneği
+static uint16_t          wIdx, wGroup;      // sıradaki örnek, grubunun ilk byte’ı
+static uint16_t          nRec, postLeft;
+static uint16_t          preN, level, capMask, scanMask;
+static uint8_t           trigCh, trigMode, lastCh, flags;
+static bool              zcArmed;
+static uint16_t          capId = 0;
+static uint32_t          tArm;
+
+//--------------------------------------------------------------
+//  ISR TARAFI
+//--------------------------------------------------------------
+static void finish(uint8_t ch)
+{
+    lastCh   = ch;
+    state    = WAVE_DONE;
+    waveMask = 0;
+    waveStep = 0;                                   // ISR normal sıraya döner
+#if CS_HARMONICS
+    lsInvalidate();                                 // farklı hızla beslenen bloklar
+#endif
+}
+
+void waveSample(uint8_t ch, uint16_t raw, int16_t diff)
+{
+    uint8_t k  = wIdx & 3;
+    uint8_t sh = 2 * k;
+    buf[wGroup + k] = (uint8_t)raw;
+    /* Halka dönünce grubun diğer 3 örneği hâlâ geçerli → yalnız kendi 2 biti */
+    buf[wGroup + 4] = (buf[wGroup + 4] & ~(3 << sh)) | ((raw >> 8) << sh);
+    if (k == 3) wGroup += 5;
+    if (++wIdx == WAVE_SAMPLES) { wIdx = 0; wGroup = 0; }
+    if (nRec < WAVE_SAMPLES) nRec++;
+
+    if (state == WAVE_RUN) {
+        if (--postLeft == 0) finish(ch);
+        return;
+    }
+    if (state != WAVE_ARMED || ch != trigCh) return;
+
+    bool hit = false;
+    if (trigMode == WAVE_TRIG_LEVEL) {
+        hit = (diff < 0 ? -diff : diff) >= (int16_t)level;
+    } else if (diff < -WAVE_ZC_HYST) {
+        zcArmed = true;                             // negatif yarım dalga görüldü
+    } else if (zcArmed && diff >= 0) {
+        zcArmed = false;                            // geçiş tüketildi
+        hit = true;
+    }
+    if (nRec < preN) return;                        // tetik öncesi henüz dolmadı
+    if (hit)        flags |= WAVE_F_TRIG;
+    else if (force) flags |= WAVE_F_FORCED;
+    else            return;
+    postLeft = WAVE_SAMPLES - preN;
+    state    = WAVE_RUN;
+    waveStep = capMask;                             // sıradaki kesmeden itibaren yalnız maske
+}
+
+//--------------------------------------------------------------
+//  ANA DÖNGÜ TARAFI
+//--------------------------------------------------------------
+bool waveArm(uint16_t mask, uint8_t trig, WaveTrig mode, uint16_t lvl)
+{
+    uint16_t valid = 0;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++)
+        if (hasCurrentSensor(ch)) valid |= 1U << ch;
+    mask &= valid;
+    if (!mask || trig >= NUM_Y_CHANNELS || !(mask & (1U << trig))) return false;
+    if (state != WAVE_IDLE) return false;
+
+    noInterrupts();
+    wIdx = wGroup = nRec = 0;
+    trigCh   = trig;
+    trigMode = mode;
+    level    = lvl;
+    zcArmed  = false;
+    force    = false;
+    flags    = 0;
+    preN     = (mode == WAVE_TRIG_NONE) ? 0 : WAVE_SAMPLES / 4;
+    postLeft = WAVE_SAMPLES;
+    state    = (mode == WAVE_TRIG_NONE) ? WAVE_RUN : WAVE_ARMED;
+    capMask  = mask;
+    scanMask = valid;
+    capId++;
+    tArm     = millis();
+    waveMask = mask;                                // sıradaki kesmeden itibaren
+    if (mode == WAVE_TRIG_NONE) waveStep = mask;    // tetik yok → baştan tam hız
+    interrupts();
+    return true;
+}
+
+void waveAbort()
+{
+    noInterrupts();
+#if CS_HARMONICS
+    if (waveStep) lsInvalidate();                   // yalnız tam hız kısmı kesildiyse
+#endif
+    waveMask = 0;
+    waveStep = 0;
+    state    = WAVE_IDLE;
+    interrupts();
+}
+
+WaveState wavePoll()
+{
+    if (state == WAVE_ARMED && !force && millis() - tArm >= WAVE_TRIG_TIMEOUT_MS)
+        force = true;
+    return (WaveState)state;
+}
+
+bool waveInfo(WaveInfo& w)
+{
+    if (state != WAVE_DONE) return false;
+
+    /* Son örneğin kanalından WAVE_SAMPLES − 1 adım geri (maskede artan sıra) */
+    uint8_t order[NUM_Y_CHANNELS], k = 0, last = 0;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++) {
+        if (!(capMask & (1U << ch))) continue;
+        if (ch == lastCh) last = k;
+        order[k++] = ch;
+    }
+    w.id      = capId;
+    w.mask    = capMask;
+    w.start   = wIdx;                               // bitince sıradaki yazma = en eski
+    w.pre     = preN;
+    w.firstCh = order[(last + k - (WAVE_SAMPLES - 1) % k) % k];
+    w.trigCh  = trigCh;
+    w.flags   = flags;
+    w.scan    = scanMask;
+    return true;
+}
+
+const uint8_t* waveData() { return buf; }
+
+void waveRelease()
+{
+    if (state == WAVE_DONE) state = WAVE_IDLE;
+}
+
+#endif // WAVE_CAPTURE
@@ -0,0 +1,47 @@
+/**
+ *  wave_capture.h
+ *  --------------
+ *  – <FLOOR_ID>/wave/set ile istenen ham ADC yakalaması: Timer1 ISR’i
+ *    (current_sense.cpp) tetiğe kadar normal sırasında gezer, seçili
+ *    kanalların örneklerini buraya da verir; tetikten sonra yalnız seçili
+ *    kanalları sırayla okur → tek kanal CS_SAMPLE_HZ, k kanal CS_SAMPLE_HZ / k,
+ *  – Örnekler 10 bit paketli halka tampona (4 örnek / 5 byte, tahsis yok),
+ *  – İsteğe bağlı tetik (ilk kanalda): eşik |i| ≥ LSB ya da yükselen
+ *    sıfır geçişi; tetikten önceki WAVE_SAMPLES / 4 örnek de saklanır,
+ *  – Biten yakalama mqtt_haberlesme.cpp’de parça parça akıtılır
+ *    (<FLOOR_ID>/diag/wave), çözümleme / çizim tools/wave_plot.py.
+ */
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+#define WAVE_BYTES     (WAVE_SAMPLES / 4 * 5)
+#define WAVE_F_TRIG    0x01         // tetik koşulu gerçekleşti
+#define WAVE_F_FORCED  0x02         // WAVE_TRIG_TIMEOUT_MS doldu, zorla alındı
+
+static_assert(WAVE_SAMPLES % 4 == 0 && WAVE_CHUNK % 5 == 0, "10 bit paket: 4 ornek / 5 byte");
+
+enum WaveTrig  : uint8_t { WAVE_TRIG_NONE, WAVE_TRIG_LEVEL, WAVE_TRIG_ZC };
+enum WaveState : uint8_t { WAVE_IDLE, WAVE_ARMED, WAVE_RUN, WAVE_DONE };
+
+struct WaveInfo {
+    uint16_t id;                    // yakalama sayacı (parçaları eşlemek için)
+    uint16_t mask;                  // Y kanalları
+    uint16_t start;                 // halkada en eski örnek
+    uint16_t pre;                   // tetikten önceki örnek (tetik = pre-1. örnek)
+    uint8_t  firstCh;               // en eski örneğin kanalı (sıra: maskede artan, döngüsel)
+    uint8_t  trigCh;
+    uint8_t  flags;                 // WAVE_F_*
+    uint16_t scan;                  // tetik öncesi ISR sırası (sensörlü kanallar)
+};
+
+extern volatile uint16_t waveMask;  // ISR bu kanalların örneklerini waveSample’a verir
+extern volatile uint16_t waveStep;  // ≠ 0 → ISR yalnız bu kanalları okur (tetikten sonra)
+
+bool           waveArm(uint16_t mask, uint8_t trigCh, WaveTrig trig, uint16_t level);
+void           waveAbort();
+void           waveSample(uint8_t ch, uint16_t raw, int16_t diff);   // yalnız ISR
+WaveState      wavePoll();                  // ana döngü: tetik zaman aşımı + durum
+bool           waveInfo(WaveInfo& w);       // false → WAVE_DONE değil
+const uint8_t* waveData();                  // WAVE_BYTES; WAVE_DONE iken değişmez
+void           waveRelease();               // akıtma bitti → WAVE_IDLE
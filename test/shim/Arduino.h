@@ -0,0 +1,37 @@
+/**
+ *  test/shim/Arduino.h
+ *  -------------------
+ *  – native testler için en küçük Arduino yüzeyi; yalnız testlerin
+ *    içerdiği src/ kaynaklarının kullandıkları,
+ *  – Hepsi inline: her test tek program, ayrı .cpp yok,
+ *  – Sahte saat: test shimNow’u kendisi ilerletir; shimAutoTick ≠ 0 ise
+ *    her millis() çağrısı o kadar ms ilerletir (yanıt bekleyen döngüler
+ *    gerçek kartta olduğu gibi süre dolunca çıksın).
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include <avr/pgmspace.h>
+
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW  0
+
+inline uint32_t shimNow      = 0;
+inline uint32_t shimAutoTick = 0;
+
+inline unsigned long millis() { return shimNow += shimAutoTick; }
+inline unsigned long micros() { return shimNow * 1000UL; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+template <class A, class B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template <class A, class B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
@@ -0,0 +1,13 @@
+/* test/shim/EEPROM.h — 4 KB, silinmiş (0xFF) başlar; test mem[]’e doğrudan bakabilir */
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+struct EEPROMClass {
+    uint8_t mem[4096];
+    EEPROMClass() { memset(mem, 0xFF, sizeof(mem)); }
+    uint8_t read(int a)               { return mem[a]; }
+    void    write(int a, uint8_t v)   { mem[a] = v; }
+    void    update(int a, uint8_t v)  { mem[a] = v; }
+};
+inline EEPROMClass EEPROM;
@@ -0,0 +1,66 @@
+/**
+ *  test/shim/UIPEthernet.h
+ *  -----------------------
+ *  – EthernetUDP’nin RAM’de kuyruklu karşılığı: kartın yolladığı her
+ *    datagram sent’e eklenir ve (varsa) gateway kancasına verilir; kanca
+ *    yanıtları inbox’a koyar, parsePacket() sırayla alır (son gönderimden
+ *    latencyMs sonra: yavaş gateway),
+ *  – Yalnız src/mqtt_sn.cpp’nin kullandığı kadar.
+ */
+#pragma once
+#include <Arduino.h>
+#include <deque>
+#include <functional>
+#include <vector>
+
+typedef std::vector<uint8_t> Datagram;
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a0, uint8_t a1, uint8_t a2, uint8_t a3) : b{ a0, a1, a2, a3 } {}
+private:
+    uint8_t b[4] = { 0, 0, 0, 0 };
+};
+
+class EthernetUDP {
+public:
+    std::deque<Datagram>  inbox;                    // gateway → kart
+    std::vector<Datagram> sent;                     // kart → gateway
+    std::function<void(EthernetUDP&, const Datagram&)> gateway;
+    uint32_t latencyMs = 0;
+
+    uint8_t begin(uint16_t)                 { return 1; }
+    int     beginPacket(IPAddress, uint16_t) { tx.clear(); return 1; }
+    size_t  write(uint8_t c)                { tx.push_back(c); return 1; }
+    size_t  write(const uint8_t* p, size_t n) { tx.insert(tx.end(), p, p + n); return n; }
+    int endPacket()
+    {
+        sent.push_back(tx);
+        readyAt = shimNow + latencyMs;
+        if (gateway) gateway(*this, Datagram(tx));
+        return 1;
+    }
+
+    int parsePacket()
+    {
+        rx.clear();
+        rxPos = 0;
+        if (inbox.empty() || (int32_t)(shimNow - readyAt) < 0) return 0;
+        rx = inbox.front();
+        inbox.pop_front();
+        return (int)rx.size();
+    }
+    int read(uint8_t* p, size_t n)
+    {
+        size_t k = min(n, rx.size() - rxPos);
+        memcpy(p, rx.data() + rxPos, k);
+        rxPos += k;
+        return (int)k;
+    }
+
+private:
+    Datagram tx, rx;
+    size_t   rxPos = 0;
+    uint32_t readyAt = 0;
+};
@@ -0,0 +1,18 @@
+/* test/shim/avr/pgmspace.h — host’ta flash = RAM */
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P              const char*
+#define PSTR(s)            (s)
+#define strcmp_P           strcmp
+#define strncmp_P          strncmp
+#define strncpy_P          strncpy
+#define strlen_P           strlen
+#define memcpy_P           memcpy
+#define snprintf_P         snprintf
+#define vsnprintf_P        vsnprintf
+#define pgm_read_byte(p)   (*(const uint8_t*)(p))
+#define pgm_read_word(p)   (*(const uint16_t*)(p))
@@ -0,0 +1,302 @@
+/**
+ * test_dispatch.cpp — komut ayrıştırıcıları (src/mqtt_cmd.cpp)
+ * ------------------------------------------------------------
+ *  › pio test -e native -f test_dispatch
+ *  › Tablo testleri + bozuk girdi taraması: rastgele ve geçerli
+ *    örneklerden türetilmiş konu / yüklerin her biri ya reddedilmeli
+ *    ya da tek anlamlı olmalı (konu yeniden üretilince aynı metin,
+ *    süre bağımsız bir başvuru ayrıştırıcısıyla aynı değer).
+ *  › Gecikme: karışık komut akışında mesaj başına süre (host’ta, bilgi
+ *    amaçlı; sınır yalnız kaba bir gerileme yakalar).
+ * ------------------------------------------------------------*/
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include "mqtt_cmd.cpp"             // test_build_src = no → test edilen kaynak
+
+#define FLOOR    "up32"
+#define MAX_S    86400UL            // OUT_TIMER_MAX_S
+#define SLOTS    8                  // SCENE_MAX
+#define NAME_LEN 12                 // SCENE_NAME_LEN
+#define FUZZ_N   200000
+
+void setUp() {}
+void tearDown() {}
+
+static uint32_t rng = 2463534242UL;
+static uint32_t xorshift()
+{
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    return rng;
+}
+
+//--------------------------------------------------------------
+//  TABLO TESTLERİ
+//--------------------------------------------------------------
+static void test_strip()
+{
+    TEST_ASSERT_EQUAL_STRING("Y1/set", mqttCmdStrip(FLOOR, "up32/Y1/set"));
+    TEST_ASSERT_EQUAL_STRING("",       mqttCmdStrip(FLOOR, "up32/"));
+    TEST_ASSERT_NULL(mqttCmdStrip(FLOOR, "up32"));
+    TEST_ASSERT_NULL(mqttCmdStrip(FLOOR, "up321/Y1/set"));
+    TEST_ASSERT_NULL(mqttCmdStrip(FLOOR, "up3/Y1/set"));
+    TEST_ASSERT_NULL(mqttCmdStrip(FLOOR, "UP32/Y1/set"));
+    TEST_ASSERT_NULL(mqttCmdStrip(FLOOR, ""));
+}
+
+static void test_output_idx()
+{
+    char t[16];
+    for (uint8_t i = 0; i < 16; ++i) {
+        snprintf(t, sizeof(t), "Y%u/set", i);
+        TEST_ASSERT_EQUAL_INT(i, mqttCmdOutputIdx(t));
+        snprintf(t, sizeof(t), "X%u/set", i);
+        TEST_ASSERT_EQUAL_INT(16 + i, mqttCmdOutputIdx(t));
+    }
+    static const char* const bad[] = {
+        "", "Y", "Y/set", "Y16/set", "Y99/set", "Y07/set", "Y100/set", "Y-1/set",
+        "Y1", "Y1/", "Y1/se", "Y1/sett", "Y1/set/", "Z1/set", "y1/set", "Y 1/set",
+        "Y1/state", "outputs/set",
+    };
+    for (const char* s : bad) TEST_ASSERT_EQUAL_INT_MESSAGE(-1, mqttCmdOutputIdx(s), s);
+}
+
+static void test_on_off()
+{
+    uint32_t ms;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ON,  mqttCmdOnOff("ON", MAX_S, &ms));        TEST_ASSERT_EQUAL_UINT32(0, ms);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OFF, mqttCmdOnOff("OFF", MAX_S, &ms));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ON,  mqttCmdOnOff("ON:300", MAX_S, &ms));    TEST_ASSERT_EQUAL_UINT32(300000, ms);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ON,  mqttCmdOnOff("ON:1.5", MAX_S, &ms));    TEST_ASSERT_EQUAL_UINT32(1500, ms);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ON,  mqttCmdOnOff("ON:0.1", MAX_S, &ms));    TEST_ASSERT_EQUAL_UINT32(100, ms);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ON,  mqttCmdOnOff("ON:86400", MAX_S, &ms));  TEST_ASSERT_EQUAL_UINT32(86400000UL, ms);
+
+    static const char* const bad[] = {
+        "", "on", "On", "ONN", "OFF:5", "ON:", "ON:0", "ON:0.0", "ON: 5", "ON:-1", "ON:+5",
+        "ON:5.", "ON:1.55", "ON:5s", "ON:86401", "ON:86400.5", "ON:4294967296", "ON:99999999999999999999",
+        "ON:0x10",
+    };
+    for (const char* s : bad) TEST_ASSERT_EQUAL_INT_MESSAGE(MQTT_CMD_BAD, mqttCmdOnOff(s, MAX_S, &ms), s);
+}
+
+static void test_mask()
+{
+    uint32_t m, c;
+    TEST_ASSERT_TRUE(mqttCmdMask("15", &m, &c));          TEST_ASSERT_EQUAL_HEX32(15, m);  TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFFUL, c);
+    TEST_ASSERT_TRUE(mqttCmdMask("0x0F:0xFF", &m, &c));   TEST_ASSERT_EQUAL_HEX32(0x0F, m); TEST_ASSERT_EQUAL_HEX32(0xFF, c);
+    TEST_ASSERT_TRUE(mqttCmdMask("0xFFFFFFFF:0", &m, &c)); TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFFUL, m); TEST_ASSERT_EQUAL_HEX32(0, c);
+    TEST_ASSERT_TRUE(mqttCmdMask("010:0777", &m, &c));    TEST_ASSERT_EQUAL_UINT32(10, m); TEST_ASSERT_EQUAL_UINT32(777, c);
+    TEST_ASSERT_TRUE(mqttCmdMask("08", &m, &c));          TEST_ASSERT_EQUAL_UINT32(8, m);
+    TEST_ASSERT_TRUE(mqttCmdMask("0X1f", &m, &c));        TEST_ASSERT_EQUAL_HEX32(0x1F, m);
+
+    static const char* const bad[] = {
+        "", ":", "0x", "-1", " 1", "+1", "1:", "1:2:3", "1 ", "0x100000000", "4294967296",
+        "1:-1", "1:0x", "abc", "0x0x5", "0x-1", "0x 1", "0xg", "1f",
+    };
+    for (const char* s : bad) TEST_ASSERT_FALSE_MESSAGE(mqttCmdMask(s, &m, &c), s);
+}
+
+static void test_scene()
+{
+    char     nm[NAME_LEN];
+    uint8_t  slot;
+    uint32_t m, c;
+    TEST_ASSERT_EQUAL_INT(MQTT_SCENE_DEFINE, mqttCmdScene("3:aksam:0x0F", SLOTS, nm, sizeof(nm), &slot, &m, &c));
+    TEST_ASSERT_EQUAL_UINT8(3, slot); TEST_ASSERT_EQUAL_STRING("aksam", nm);
+    TEST_ASSERT_EQUAL_HEX32(0x0F, m); TEST_ASSERT_EQUAL_HEX32(0xFFFFFFFFUL, c);
+    TEST_ASSERT_EQUAL_INT(MQTT_SCENE_DEFINE, mqttCmdScene("0:gece:010:0xFF", SLOTS, nm, sizeof(nm), &slot, &m, &c));
+    TEST_ASSERT_EQUAL_UINT32(10, m);  TEST_ASSERT_EQUAL_HEX32(0xFF, c);
+    TEST_ASSERT_EQUAL_INT(MQTT_SCENE_DEFINE, mqttCmdScene("7:abcdefghijk:0", SLOTS, nm, sizeof(nm), &slot, &m, &c));
+    TEST_ASSERT_EQUAL_INT(MQTT_SCENE_DELETE, mqttCmdScene("5:", SLOTS, nm, sizeof(nm), &slot, &m, &c));
+    TEST_ASSERT_EQUAL_UINT8(5, slot);
+
+    static const struct { const char* s; int8_t r; } bad[] = {
+        { "", MQTT_SCENE_BAD_SLOT },        { "8:a:1", MQTT_SCENE_BAD_SLOT },   { "a:b:1", MQTT_SCENE_BAD_SLOT },
+        { "12:a:1", MQTT_SCENE_BAD_SLOT },  { "3", MQTT_SCENE_BAD_SLOT },       { "3:ad", MQTT_SCENE_NO_MASK },
+        { "3::1", MQTT_SCENE_BAD_NAME },    { "3:abcdefghijkl:1", MQTT_SCENE_BAD_NAME },
+        { "3:a:-1", MQTT_SCENE_BAD_MASK },  { "3:a: 5", MQTT_SCENE_BAD_MASK },  { "3:a:+3", MQTT_SCENE_BAD_MASK },
+        { "3:a:4294967296", MQTT_SCENE_BAD_MASK }, { "3:a:1:-1", MQTT_SCENE_BAD_MASK },
+        { "3:a:", MQTT_SCENE_BAD_MASK },    { "3:a:1x", MQTT_SCENE_BAD_MASK },  { "3:a:1:2:3", MQTT_SCENE_BAD_MASK },
+    };
+    for (auto& b : bad)
+        TEST_ASSERT_EQUAL_INT_MESSAGE(b.r, mqttCmdScene(b.s, SLOTS, nm, sizeof(nm), &slot, &m, &c), b.s);
+}
+
+//--------------------------------------------------------------
+//  BOZUK GİRDİ TARAMASI
+//--------------------------------------------------------------
+static const char* const seeds[] = {
+    "up32/Y7/set", "up32/X15/set", "up32/outputs/set", "ON", "OFF", "ON:300", "ON:1.5",
+    "0xFFFF:0x00FF", "4294967295", "ON:86400", "010:0x0F", "0x0x5", "3:aksam:0x0F:7",
+};
+static const char alphabet[] = "YXO0123456789:./-x upNFsetF";
+
+/** Başvuru: "<rakamlar>[.<rakam>]" → ms, sınır dışı / hatalıysa 0 */
+static uint32_t refDurationMs(const char* s)
+{
+    uint64_t sec = 0;
+    const char* p = s;
+    if (*p < '0' || *p > '9') return 0;
+    while (*p >= '0' && *p <= '9') {
+        sec = sec * 10 + (*p++ - '0');
+        if (sec > MAX_S) return 0;
+    }
+    uint64_t ms = sec * 1000;
+    if (*p == '.') {
+        if (p[1] < '0' || p[1] > '9') return 0;
+        ms += (p[1] - '0') * 100;
+        p += 2;
+    }
+    return (*p || ms > MAX_S * 1000) ? 0 : (uint32_t)ms;
+}
+
+/** Başvuru: onluk ya da "0x" + on altılık, 32 bit; *p sayının sonuna */
+static bool refU32(const char*& p, uint32_t* v)
+{
+    uint64_t x = 0;
+    int base = (p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) ? 16 : 10;
+    if (base == 16) p += 2;
+    const char* start = p;
+    for (;; ++p) {
+        int d = (*p >= '0' && *p <= '9') ? *p - '0'
+              : (base == 16 && *p >= 'a' && *p <= 'f') ? *p - 'a' + 10
+              : (base == 16 && *p >= 'A' && *p <= 'F') ? *p - 'A' + 10 : -1;
+        if (d < 0) break;
+        x = x * base + d;
+        if (x > 0xFFFFFFFFULL) return false;
+    }
+    *v = (uint32_t)x;
+    return p != start;
+}
+
+/** Başvuru: "<sayı>[:<sayı>]" */
+static bool refMask(const char* p, uint32_t* m, uint32_t* c)
+{
+    *c = 0xFFFFFFFFUL;
+    if (!refU32(p, m)) return false;
+    if (*p == ':' && !refU32(++p, c)) return false;
+    return *p == '\0';
+}
+
+/** Rastgele byte’lar ya da bir tohumun bozulmuş kopyası (\0 ile biter) */
+static void mutate(char* buf, size_t cap)
+{
+    size_t n;
+    if (xorshift() & 1) {
+        n = xorshift() % (cap - 1);
+        for (size_t i = 0; i < n; ++i) buf[i] = (char)(1 + xorshift() % 255);
+    } else {
+        const char* s = seeds[xorshift() % (sizeof(seeds) / sizeof(seeds[0]))];
+        n = strlen(s);
+        memcpy(buf, s, n);
+        for (uint8_t k = xorshift() % 4; k; --k) {
+            size_t at = n ? xorshift() % n : 0;
+            switch (xorshift() % 3) {
+            case 0: if (n) buf[at] = alphabet[xorshift() % (sizeof(alphabet) - 1)]; break;
+            case 1: if (n) { memmove(buf + at, buf + at + 1, n - at - 1); n--; } break;
+            case 2: if (n + 1 < cap) { memmove(buf + at + 1, buf + at, n - at);
+                                       buf[at] = alphabet[xorshift() % (sizeof(alphabet) - 1)]; n++; } break;
+            }
+        }
+    }
+    buf[n] = '\0';
+}
+
+static void test_fuzz()
+{
+    char in[32], out[40];
+    uint32_t accepted = 0;
+    for (uint32_t k = 0; k < FUZZ_N; ++k) {
+        mutate(in, sizeof(in));
+
+        const char* cmd = mqttCmdStrip(FLOOR, in);
+        if (cmd) TEST_ASSERT_TRUE_MESSAGE(cmd == in + 5 && memcmp(in, FLOOR "/", 5) == 0, in);
+
+        int8_t idx = mqttCmdOutputIdx(in);
+        TEST_ASSERT_TRUE_MESSAGE(idx >= -1 && idx < 32, in);
+        if (idx >= 0) {
+            snprintf(out, sizeof(out), "%c%u/set", idx < 16 ? 'Y' : 'X', idx % 16);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(out, in, "kabul edilen konu tek anlamlı değil");
+            accepted++;
+        }
+
+        uint32_t ms;
+        int8_t r = mqttCmdOnOff(in, MAX_S, &ms);
+        uint32_t ref = strncmp(in, "ON:", 3) == 0 ? refDurationMs(in + 3) : 0;
+        TEST_ASSERT_EQUAL_UINT32_MESSAGE(ref, ms, in);
+        if (ref) {
+            TEST_ASSERT_EQUAL_INT_MESSAGE(MQTT_CMD_ON, r, in);
+            accepted++;
+        } else if (r != MQTT_CMD_BAD) {
+            TEST_ASSERT_EQUAL_STRING(r == MQTT_CMD_ON ? "ON" : "OFF", in);
+        }
+
+        uint32_t m, c, m2, c2;
+        bool ok = mqttCmdMask(in, &m, &c);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(refMask(in, &m2, &c2), ok, in);
+        if (ok) {
+            TEST_ASSERT_EQUAL_HEX32(m2, m);
+            TEST_ASSERT_EQUAL_HEX32(c2, c);
+            accepted++;
+        }
+
+        char    nm[NAME_LEN];
+        uint8_t slot;
+        if (mqttCmdScene(in, SLOTS, nm, sizeof(nm), &slot, &m, &c) == MQTT_SCENE_DEFINE) {
+            const char* sep = strchr(in + 2, ':');
+            TEST_ASSERT_TRUE_MESSAGE(slot < SLOTS && sep && strlen(nm) == (size_t)(sep - in - 2), in);
+            TEST_ASSERT_TRUE_MESSAGE(refMask(sep + 1, &m2, &c2) && m2 == m && c2 == c, in);
+            accepted++;
+        }
+    }
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%u girdi, %lu kabul", FUZZ_N, (unsigned long)accepted);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_GREATER_THAN(0, accepted);      // tohumlar gerçekten kabul yoluna da giriyor
+}
+
+//--------------------------------------------------------------
+//  GECİKME
+//--------------------------------------------------------------
+static void test_latency()
+{
+    static const char* const topics[] = {
+        "up32/Y7/set", "up32/X12/set", "up32/outputs/set", "up32/Y99/set", "up33/Y1/set",
+    };
+    static const char* const payloads[] = { "ON", "OFF", "ON:300", "0xFFFF:0x00FF", "bogus" };
+    const uint32_t n = 500000;
+    volatile uint32_t sink = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t k = 0; k < n; ++k) {
+        const char* cmd = mqttCmdStrip(FLOOR, topics[k % 5]);
+        const char* arg = payloads[(k / 5) % 5];
+        if (!cmd) continue;
+        uint32_t a, b;
+        int8_t idx = mqttCmdOutputIdx(cmd);
+        if (idx >= 0) sink += mqttCmdOnOff(arg, MAX_S, &a) + a;
+        else if (mqttCmdMask(arg, &a, &b)) sink += a ^ b;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / n;
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "mesaj basina %.1f ns (host)", ns);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(2000.0, ns);
+    (void)sink;
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_strip);
+    RUN_TEST(test_output_idx);
+    RUN_TEST(test_on_off);
+    RUN_TEST(test_mask);
+    RUN_TEST(test_scene);
+    RUN_TEST(test_fuzz);
+    RUN_TEST(test_latency);
+    return UNITY_END();
+}
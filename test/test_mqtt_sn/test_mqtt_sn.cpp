@@ -0,0 +1,230 @@
+/**
+ * test_mqtt_sn.cpp — kartın MQTT-SN istemcisi (src/mqtt_sn.cpp)
+ * ------------------------------------------------------------
+ *  › pio test -e native -f test_mqtt_sn
+ *  › Gerçek MqttSnClient, test/shim/UIPEthernet.h’in RAM’deki UDP’siyle;
+ *    gateway her testte datagramlara yanıt veren küçük bir kanca.
+ *  › Saat shimAutoTick ile akar: yanıt bekleyen döngüler kartta olduğu
+ *    gibi SN_ACK_MS sonunda çıkar; çağrı başına bloklama süresi ölçülür.
+ * ------------------------------------------------------------*/
+#define MQTT_SN 1
+#include <unity.h>
+#include <stdarg.h>
+#include <string>
+#include <vector>
+
+#include "mqtt_payload.cpp"         // test_build_src = no → test edilen kaynaklar
+#include "mqtt_sn.cpp"
+
+/* log.h → son kayıt */
+static char lastLog[96];
+void logWrite_P(uint8_t, PGM_P fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(lastLog, sizeof(lastLog), fmt, ap);
+    va_end(ap);
+}
+
+#define WDT_TIMEOUT_MS 2000         // diagWatchdogEnable(): WDTO_2S
+#define BLOCK_MAX_MS   (WDT_TIMEOUT_MS / 2)   // ana döngü en kötü durumda bile bunun altında
+
+static EthernetUDP   udp;
+static MqttSnClient  sn(udp);
+static std::vector<std::string> rxTopics;
+static std::vector<std::string> rxPayloads;
+
+static void onMessage(char* topic, uint8_t* payload, unsigned int len)
+{
+    rxTopics.push_back(topic);
+    rxPayloads.push_back(std::string((const char*)payload, len));
+}
+
+/* Gateway: CONNECT / will / SUBSCRIBE’a yanıt verir (answer = false → sessiz,
+   dropWillMsg > 0 → o kadar WILLMSG’i yutar) */
+static bool    answer = true;
+static uint8_t dropWillMsg = 0;
+static void gateway(EthernetUDP& u, const Datagram& d)
+{
+    if (!answer || d.size() < 2) return;
+    if (d[1] == SN_WILLMSG && dropWillMsg) { dropWillMsg--; return; }
+    switch (d[1]) {
+    case SN_CONNECT:
+        u.inbox.push_back((d[2] & SN_FLAG_WILL) ? Datagram{ 2, SN_WILLTOPICREQ } : Datagram{ 3, SN_CONNACK, 0 });
+        break;
+    case SN_WILLTOPIC: u.inbox.push_back({ 2, SN_WILLMSGREQ });   break;
+    case SN_WILLMSG:   u.inbox.push_back({ 3, SN_CONNACK, 0 });   break;
+    case SN_SUBSCRIBE: u.inbox.push_back({ 8, SN_SUBACK, 0, 0, 0, d[3], d[4], 0 }); break;
+    }
+}
+
+static void push(uint8_t flags, uint16_t tid, uint16_t mid, const char* payload)
+{
+    Datagram d = { 0, SN_PUBLISH, flags, (uint8_t)(tid >> 8), (uint8_t)tid,
+                   (uint8_t)(mid >> 8), (uint8_t)mid };
+    d.insert(d.end(), payload, payload + strlen(payload));
+    d[0] = (uint8_t)d.size();
+    udp.inbox.push_back(d);
+}
+
+static size_t countSent(uint8_t type)
+{
+    size_t n = 0;
+    for (const Datagram& d : udp.sent) n += d.size() > 1 && d[1] == type;
+    return n;
+}
+
+void setUp()
+{
+    shimNow = 1000;
+    shimAutoTick = 1;
+    udp.inbox.clear();
+    udp.sent.clear();
+    udp.gateway = gateway;
+    answer = true;
+    dropWillMsg = 0;
+    udp.latencyMs = 0;
+    rxTopics.clear();
+    rxPayloads.clear();
+    sn.setServer(IPAddress(127, 0, 0, 1), MQTT_SN_PORT).setCallback(onMessage);
+}
+void tearDown() {}
+
+//--------------------------------------------------------------
+static void test_connect_with_will()
+{
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, FLOOR_ID "/status", 0, true, "offline"));
+    TEST_ASSERT_TRUE(sn.connected());
+    TEST_ASSERT_EQUAL_UINT32(1, countSent(SN_WILLTOPIC));
+    TEST_ASSERT_EQUAL_UINT32(1, countSent(SN_WILLMSG));
+    TEST_ASSERT_TRUE(sn.subscribe(FLOOR_ID "/+/set"));
+}
+
+/* Yavaş gateway (her yanıt SN_ACK_MS’ye yakın), ilk will el sıkışması yarıda
+   kalır: connect() SN_CONNECT_MS’de vazgeçer, reconnect() sonra yeniden dener */
+static void test_slow_gateway_connect_is_bounded()
+{
+    udp.latencyMs = SN_ACK_MS - 20;
+    dropWillMsg = 1;
+    uint32_t t0 = shimNow;
+    TEST_ASSERT_FALSE(sn.connect(FLOOR_ID, nullptr, nullptr, FLOOR_ID "/status", 0, true, "offline"));
+    TEST_ASSERT_EQUAL_INT(SN_CONNECTION_TIMEOUT, sn.state());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(SN_CONNECT_MS + 10, shimNow - t0);
+    TEST_ASSERT_LESS_THAN(BLOCK_MAX_MS, shimNow - t0);
+
+    t0 = shimNow;                                   // sessiz gateway
+    answer = false;
+    TEST_ASSERT_FALSE(sn.connect(FLOOR_ID, nullptr, nullptr, FLOOR_ID "/status", 0, true, "offline"));
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(SN_CONNECT_MS + 10, shimNow - t0);
+}
+
+/* SUBSCRIBE bloklamaz: SUBACK loop()’ta, yuva boşalır */
+static void test_subscribe_is_async()
+{
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, nullptr, 0, false, nullptr));
+    udp.latencyMs = SN_ACK_MS - 20;
+    uint32_t t0 = shimNow;
+    TEST_ASSERT_TRUE(sn.subscribe(FLOOR_ID "/discovery_hash"));
+    TEST_ASSERT_TRUE(sn.subscribe(FLOOR_ID "/+/set"));
+    TEST_ASSERT_TRUE(sn.subscribe(FLOOR_ID "/scene/define"));
+    TEST_ASSERT_LESS_THAN(10, shimNow - t0);
+    TEST_ASSERT_FALSE(sn.subscribe(FLOOR_ID "/fazla"));         // SN_SUB_SLOTS dolu
+    TEST_ASSERT_EQUAL_UINT32(3, countSent(SN_SUBSCRIBE));
+
+    while (shimNow - t0 < SN_ACK_MS) sn.loop();     // SUBACK’ler (tek tur SN_RX_PER_LOOP)
+    TEST_ASSERT_TRUE(sn.connected());
+    TEST_ASSERT_EQUAL_UINT32(3, countSent(SN_SUBSCRIBE));       // yeniden yollanmadı
+    TEST_ASSERT_TRUE(sn.subscribe(FLOOR_ID "/fazla"));          // yuvalar boşaldı
+}
+
+/* Yanıtsız SUBSCRIBE: SN_ACK_MS’de bir yeniden, SN_ACK_TRIES sonra kopuk */
+static void test_unanswered_subscribe_drops_connection()
+{
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, nullptr, 0, false, nullptr));
+    answer = false;
+    udp.sent.clear();
+    TEST_ASSERT_TRUE(sn.subscribe(FLOOR_ID "/+/set"));
+    uint32_t t0 = shimNow, worst = 0;
+    while (sn.connected() && shimNow - t0 < 10 * SN_ACK_MS) {
+        uint32_t t = shimNow;
+        sn.loop();
+        if (shimNow - t > worst) worst = shimNow - t;
+    }
+    TEST_ASSERT_FALSE(sn.connected());
+    TEST_ASSERT_EQUAL_UINT32(SN_ACK_TRIES, countSent(SN_SUBSCRIBE));
+    TEST_ASSERT_GREATER_OR_EQUAL(SN_ACK_TRIES * SN_ACK_MS, shimNow - t0);
+    TEST_ASSERT_LESS_THAN(10, worst);                           // hiçbir loop() bloklamadı
+}
+
+/* Gateway her bağlantıda MsgId’leri 1’den başlatır: yeniden bağlanınca
+   retained discovery_hash MsgId 1 ile gelir ve tekrar sanılmamalı. */
+static void test_msgid_filter_resets_on_connect()
+{
+    const uint16_t tid = mqttSnTopicId(FLOOR_ID, FLOOR_ID "/discovery_hash");
+    TEST_ASSERT_NOT_EQUAL(MQTT_SN_TOPIC_NONE, tid);
+    const uint8_t qos1r = SN_FLAG_QOS1 | SN_FLAG_RETAIN | SN_TOPIC_PREDEF;
+
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, nullptr, 0, false, nullptr));
+    push(qos1r, tid, 1, "e 1");
+    push(qos1r, tid, 1, "e 1");                     // PUBACK’imiz kayboldu → aynı MsgId
+    sn.loop();
+    TEST_ASSERT_EQUAL_UINT32(1, rxTopics.size());
+    TEST_ASSERT_EQUAL_UINT32(2, countSent(SN_PUBACK));
+    TEST_ASSERT_EQUAL_STRING(FLOOR_ID "/discovery_hash", rxTopics[0].c_str());
+
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, nullptr, 0, false, nullptr));
+    push(qos1r, tid, 1, "e 2");
+    sn.loop();
+    TEST_ASSERT_EQUAL_UINT32(2, rxTopics.size());
+    TEST_ASSERT_EQUAL_STRING("e 2", rxPayloads[1].c_str());
+}
+
+/* alert QoS1: PUBACK gelene kadar SN_RETRY_MS’de bir DUP ile yeniden */
+static void test_reliable_publish_retries_until_ack()
+{
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, nullptr, 0, false, nullptr));
+    shimAutoTick = 0;
+    udp.sent.clear();
+    TEST_ASSERT_TRUE(sn.publish(FLOOR_ID "/alert", "{\"mod\":1}"));
+    TEST_ASSERT_EQUAL_UINT32(1, udp.sent.size());
+    Datagram first = udp.sent[0];
+    TEST_ASSERT_EQUAL_HEX8(SN_FLAG_QOS1, first[2] & 0x60);
+
+    shimNow += SN_RETRY_MS;
+    sn.loop();
+    TEST_ASSERT_EQUAL_UINT32(2, udp.sent.size());
+    TEST_ASSERT_EQUAL_HEX8(SN_FLAG_DUP, udp.sent[1][2] & SN_FLAG_DUP);
+    TEST_ASSERT_EQUAL_HEX8(first[6], udp.sent[1][6]);               // aynı MsgId
+
+    udp.inbox.push_back({ 7, SN_PUBACK, first[3], first[4], first[5], first[6], 0 });
+    sn.loop();
+    shimNow += 5 * SN_RETRY_MS;
+    sn.loop();
+    TEST_ASSERT_EQUAL_UINT32(2, countSent(SN_PUBLISH));             // onaylandı, bitti
+}
+
+/* Telemetri QoS0, önceden tanımlı numara, konu metni yok */
+static void test_state_publish_uses_predefined_id()
+{
+    TEST_ASSERT_TRUE(sn.connect(FLOOR_ID, nullptr, nullptr, nullptr, 0, false, nullptr));
+    udp.sent.clear();
+    TEST_ASSERT_TRUE(sn.publish(FLOOR_ID "/Y3/state", "ON", true));
+    TEST_ASSERT_EQUAL_UINT32(1, udp.sent.size());
+    const Datagram& d = udp.sent[0];
+    const uint8_t want[] = { 9, SN_PUBLISH, SN_FLAG_RETAIN | SN_TOPIC_PREDEF, 0x01, 0x03, 0, 0, 'O', 'N' };
+    TEST_ASSERT_EQUAL_UINT32(sizeof(want), d.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(want, d.data(), sizeof(want));
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_connect_with_will);
+    RUN_TEST(test_slow_gateway_connect_is_bounded);
+    RUN_TEST(test_subscribe_is_async);
+    RUN_TEST(test_unanswered_subscribe_drops_connection);
+    RUN_TEST(test_msgid_filter_resets_on_connect);
+    RUN_TEST(test_reliable_publish_retries_until_ack);
+    RUN_TEST(test_state_publish_uses_predefined_id);
+    return UNITY_END();
+}
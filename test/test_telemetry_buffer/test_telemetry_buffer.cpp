@@ -0,0 +1,170 @@
+/**
+ * test_telemetry_buffer.cpp — çevrimdışı tampon (src/telemetry_buffer.cpp)
+ * ------------------------------------------------------------
+ *  › pio test -e native -f test_telemetry_buffer
+ *  › tbPeekAt() silmeden tbPeek + tbPop sırasını birebir vermeli;
+ *    tbReplay (mqttServiceReplay’in yolu) yayın başarısızsa hiç silmez →
+ *    aynı paket bir sonraki turda aynen yeniden kurulur.
+ *  › Kaçış kaydı (255 s’den uzun boşluk) kuyruğa gelince de zaman ve
+ *    silme sırası doğru kalmalı.
+ * ------------------------------------------------------------*/
+#include <unity.h>
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <string>
+#include <vector>
+
+#include "telemetry_buffer.cpp"     // test_build_src = no → test edilen kaynak
+
+volatile float Y_current[NUM_Y_CHANNELS];
+volatile float Y_powerW[NUM_Y_CHANNELS];
+volatile float Y_energyWh[NUM_Y_CHANNELS];
+bool hasCurrentSensor(uint8_t ch) { return ch < 2; }
+
+#define MAX_EV 32
+
+static void advance(uint32_t sec)
+{
+    for (uint32_t s = 0; s < sec; ++s) { shimNow += 1000; tbTick(); }
+}
+
+static void power(uint8_t ch, float w)
+{
+    Y_powerW[ch] = w;
+    tbRecordTelemetry();
+}
+
+static uint8_t peekAll(TbEvent* out)
+{
+    uint8_t n = 0;
+    while (n < MAX_EV && tbPeekAt(n, out[n])) n++;
+    return n;
+}
+
+static void assertSame(const TbEvent& a, const TbEvent& b)
+{
+    TEST_ASSERT_EQUAL_UINT32(a.ts, b.ts);
+    TEST_ASSERT_EQUAL_UINT8(a.kind, b.kind);
+    TEST_ASSERT_EQUAL_UINT8(a.ch, b.ch);
+    TEST_ASSERT_EQUAL_INT(a.val, b.val);
+    TEST_ASSERT_EQUAL_INT(a.epoch, b.epoch);
+}
+
+void setUp()
+{
+    memset(EEPROM.mem, 0xFF, sizeof(EEPROM.mem));
+    memset((void*)Y_powerW, 0, sizeof(Y_powerW));
+    memset((void*)Y_energyWh, 0, sizeof(Y_energyWh));
+    tbInit();
+}
+void tearDown() {}
+
+/* 2 uyarı + 5 güç kaydı (biri 600 s boşluktan sonra → kaçış kaydı) */
+static void fill()
+{
+    tbStoreAlert(1, 55.5f, true);
+    advance(10);
+    tbStoreAlert(2, 50.0f, false);
+    power(0, 100);
+    advance(30);
+    power(0, 200);
+    advance(600);
+    power(1, 50);
+    advance(5);
+    power(0, 0);
+    power(1, 0);
+}
+
+static void test_peek_at_matches_pop_order()
+{
+    fill();
+    TbEvent a[MAX_EV], ev;
+    uint16_t pending = tbPending();
+    uint8_t  n = peekAll(a);
+    TEST_ASSERT_EQUAL_UINT8(7, n);
+    TEST_ASSERT_EQUAL_UINT16(pending, tbPending());         // peek silmez
+
+    TEST_ASSERT_EQUAL_UINT8(TB_ALERT, a[0].kind);           TEST_ASSERT_EQUAL_INT(555, a[0].val);
+    TEST_ASSERT_EQUAL_UINT8(TB_RESTORED, a[1].kind);        TEST_ASSERT_EQUAL_UINT8(2, a[1].ch);
+    TEST_ASSERT_EQUAL_UINT32(a[2].ts + 30,  a[3].ts);
+    TEST_ASSERT_EQUAL_UINT32(a[3].ts + 600, a[4].ts);       // kaçış kaydının dt’si
+    TEST_ASSERT_EQUAL_UINT32(a[4].ts + 5,   a[5].ts);
+    TEST_ASSERT_EQUAL_UINT32(a[5].ts,       a[6].ts);
+
+    for (uint8_t i = 0; i < n; ++i) {
+        TEST_ASSERT_TRUE(tbPeek(ev));
+        assertSame(a[i], ev);
+        tbPop();
+    }
+    TEST_ASSERT_FALSE(tbPeek(ev));
+    TEST_ASSERT_EQUAL_UINT16(0, tbPending());
+}
+
+/* mqttServiceReplay’in publish’i: ilk publishFails çağrı başarısız */
+static std::vector<std::string> published;
+static uint8_t publishFails;
+static bool publishStub(const char* payload)
+{
+    published.push_back(payload);
+    if (publishFails) { publishFails--; return false; }
+    return true;
+}
+
+static void test_failed_publish_keeps_batch()
+{
+    fill();
+    TbEvent before[MAX_EV], after[MAX_EV];
+    uint8_t  n       = peekAll(before);
+    uint16_t pending = tbPending();
+    published.clear();
+
+    /* 1. tur: yayın başarısız → hiçbir olay silinmez */
+    publishFails = 1;
+    TEST_ASSERT_EQUAL_UINT8(0, tbReplay(publishStub));
+    TEST_ASSERT_EQUAL_UINT16(pending, tbPending());
+    TEST_ASSERT_EQUAL_UINT8(n, peekAll(after));
+    for (uint8_t i = 0; i < n; ++i) assertSame(before[i], after[i]);
+
+    /* 2. tur: aynı paket byte byte, başarılı → TB_REPLAY_BATCH olay silinir */
+    TEST_ASSERT_EQUAL_UINT8(TB_REPLAY_BATCH, tbReplay(publishStub));
+    TEST_ASSERT_EQUAL_UINT32(2, published.size());
+    TEST_ASSERT_EQUAL_STRING(published[0].c_str(), published[1].c_str());
+    char head[48];
+    snprintf(head, sizeof(head), "{\"clk\":\"up\",\"ev\":[[%lu,\"a\",1,555],", (unsigned long)before[0].ts);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(head, published[0].c_str(), strlen(head)));
+
+    TEST_ASSERT_EQUAL_UINT16(pending - TB_REPLAY_BATCH, tbPending());
+    TEST_ASSERT_EQUAL_UINT8(n - TB_REPLAY_BATCH, peekAll(after));
+    for (uint8_t i = 0; i < n - TB_REPLAY_BATCH; ++i) assertSame(before[TB_REPLAY_BATCH + i], after[i]);
+
+    /* kalan olaylar sonraki paketlerde, sonra tampon boş */
+    while (tbReplay(publishStub)) {}
+    TEST_ASSERT_EQUAL_UINT16(0, tbPending());
+    TEST_ASSERT_EQUAL_UINT8(0, tbReplay(publishStub));
+}
+
+static void test_escape_at_tail()
+{
+    power(0, 100);
+    advance(400);
+    power(0, 300);                                          // [P][ESC][P]
+    TbEvent a[MAX_EV], ev;
+    TEST_ASSERT_EQUAL_UINT8(2, peekAll(a));
+    TEST_ASSERT_EQUAL_UINT32(a[0].ts + 400, a[1].ts);
+
+    tbPop();                                                // kuyrukta artık ESC
+    TEST_ASSERT_TRUE(tbPeek(ev));
+    assertSame(a[1], ev);
+    tbPop();                                                // ESC + P birlikte
+    TEST_ASSERT_FALSE(tbPeek(ev));
+    TEST_ASSERT_EQUAL_UINT16(0, tbPending());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_peek_at_matches_pop_order);
+    RUN_TEST(test_failed_publish_keeps_batch);
+    RUN_TEST(test_escape_at_tail);
+    return UNITY_END();
+}
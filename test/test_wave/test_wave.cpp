@@ -0,0 +1,224 @@
+/**
+ * test_wave.cpp — ham dalga biçimi yakalama (src/wave_capture.cpp)
+ * ------------------------------------------------------------
+ *  › pio test -e native -f test_wave
+ *  › isr() current_sense.cpp’deki Timer1 kesmesinin kanal seçimini
+ *    taklit eder (Y3/Y7/Y11/Y15 sensörsüz); sinyal kanal başına farklı
+ *    genlikte 50 Hz sinüs, tik = 1 / CS_SAMPLE_HZ.
+ *  › Her waveSample() çağrısı kaydedilir; biten yakalama
+ *    tools/wave_plot.py’nin kuralıyla çözülür ve kayıtla karşılaştırılır
+ *    (ham değer, kanal, tetiğe göre zaman).
+ * ------------------------------------------------------------*/
+#define CS_HARMONICS 1              // lsInvalidate() çağrıları da sayılsın
+#include <unity.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "wave_capture.cpp"         // test_build_src = no → test edilen kaynak
+
+bool hasCurrentSensor(uint8_t ch) { return ch < NUM_Y_CHANNELS && (ch & 3) != 3; }
+static uint8_t lsInvalidated = 0;
+void lsInvalidate() { lsInvalidated++; }
+
+static const uint16_t OFS = 512;
+
+struct Rec { uint32_t tick; uint8_t ch; uint16_t raw; };
+static std::vector<Rec> rec;                // waveSample’a giden örnekler
+static uint32_t tick;
+static uint8_t  cur;
+static uint16_t seen;                       // son isr() turunda okunan kanallar
+static float    amp;                        // 0 → düz (tetik yok)
+
+static uint16_t signal(uint8_t ch, uint32_t t)
+{
+    return (uint16_t)lround(OFS + amp * (1 + ch / 4.0) * sin(2 * M_PI * 50 * t / CS_SAMPLE_HZ + 0.7));
+}
+
+static uint8_t next(uint8_t ch, uint16_t mask)
+{
+    for (uint8_t k = 0; k < NUM_Y_CHANNELS; k++)
+        if (mask & (1U << ((ch + k) & 0x0F))) return (ch + k) & 0x0F;
+    return 0;
+}
+
+/* current_sense.cpp: ISR(TIMER1_COMPA_vect) */
+static void isr()
+{
+    uint16_t valid = 0;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++)
+        if (hasCurrentSensor(ch)) valid |= 1U << ch;
+
+    uint16_t wm = waveMask, ws = waveStep;
+    cur = next(cur, ws ? ws : valid);
+    seen |= 1U << cur;
+    uint16_t raw = signal(cur, tick);
+    if (wm & (1U << cur)) {
+        rec.push_back({ tick, cur, raw });
+        waveSample(cur, raw, (int16_t)(raw - OFS));
+    }
+    cur = (cur + 1) & 0x0F;
+    tick++;
+    if (tick % 4 == 0) shimNow++;           // 4 kHz → 1 ms
+}
+
+static void runUntilDone(uint32_t maxTicks)
+{
+    for (uint32_t i = 0; i < maxTicks && wavePoll() != WAVE_DONE; i++) isr();
+}
+
+/* tools/wave_plot.py Capture.decode() ile aynı kural */
+struct Sample { uint32_t tick; uint8_t ch; uint16_t raw; };
+static std::vector<Sample> decode(const WaveInfo& w)
+{
+    const uint8_t* d = waveData();
+    std::vector<uint16_t> raw;
+    for (uint16_t g = 0; g < WAVE_SAMPLES / 4; g++)
+        for (uint8_t k = 0; k < 4; k++)
+            raw.push_back(d[5 * g + k] | ((d[5 * g + 4] >> (2 * k)) & 3) << 8);
+
+    std::vector<uint8_t> chans, order;
+    for (uint8_t ch = 0; ch < NUM_Y_CHANNELS; ch++) {
+        if (w.mask & (1U << ch)) chans.push_back(ch);
+        if (w.scan & (1U << ch)) order.push_back(ch);
+    }
+    auto at = [](const std::vector<uint8_t>& v, uint8_t ch) { return (int)(std::find(v.begin(), v.end(), ch) - v.begin()); };
+
+    std::vector<Sample> out;
+    int      pos = at(chans, w.firstCh);
+    uint32_t t   = 0;
+    for (uint16_t j = 0; j < WAVE_SAMPLES; j++) {
+        uint8_t ch = chans[(pos + j) % chans.size()];
+        if (j) {
+            int n   = order.size();
+            int gap = ((at(order, ch) - at(order, out.back().ch)) % n + n) % n;
+            t += (j < w.pre) ? (gap ? gap : n) : 1;
+        }
+        out.push_back({ t, ch, raw[(w.start + j) % WAVE_SAMPLES] });
+    }
+    return out;
+}
+
+static void checkRoundTrip()
+{
+    WaveInfo w;
+    TEST_ASSERT_TRUE(waveInfo(w));
+    TEST_ASSERT_TRUE(rec.size() >= WAVE_SAMPLES);
+    std::vector<Sample> got = decode(w);
+    const Rec* want = rec.data() + rec.size() - WAVE_SAMPLES;
+    for (uint16_t j = 0; j < WAVE_SAMPLES; j++) {
+        TEST_ASSERT_EQUAL_UINT8(want[j].ch, got[j].ch);
+        TEST_ASSERT_EQUAL_UINT16(want[j].raw, got[j].raw);
+        TEST_ASSERT_EQUAL_UINT32(want[j].tick - want[0].tick, got[j].tick);
+    }
+    if (w.pre) TEST_ASSERT_EQUAL_UINT8(w.trigCh, got[w.pre - 1].ch);
+}
+
+void setUp()
+{
+    waveAbort();
+    rec.clear();
+    tick = 0;
+    cur  = 0;
+    amp  = 150;
+    shimNow = 1000;
+    lsInvalidated = 0;
+    for (int i = 0; i < 37; i++) isr();     // kanal sırası rastgele bir yerde
+}
+void tearDown() {}
+
+//--------------------------------------------------------------
+/* Tetik beklenirken ISR normal sırasında: maskede olmayan kanallar da okunur */
+static void test_armed_keeps_round_robin()
+{
+    amp = 0;
+    TEST_ASSERT_TRUE(waveArm(1U << 5, 5, WAVE_TRIG_ZC, 0));
+    for (int r = 0; r < 100; r++) {
+        seen = 0;
+        for (int i = 0; i < 12; i++) isr();
+        TEST_ASSERT_EQUAL_HEX16(0x7777, seen);
+    }
+    TEST_ASSERT_EQUAL(WAVE_ARMED, wavePoll());
+    TEST_ASSERT_EQUAL_HEX16(0, waveStep);
+    TEST_ASSERT_EQUAL_UINT32(100, rec.size());          // Y5 her turda bir kez
+    TEST_ASSERT_EQUAL_UINT8(0, lsInvalidated);          // Goertzel blokları sürer
+}
+
+/* Tetikten sonra yalnız maske, bitince normal sıra; iki kısmın zamanı çözülür */
+static void test_trigger_then_mask_only()
+{
+    TEST_ASSERT_TRUE(waveArm((1U << 0) | (1U << 4) | (1U << 8), 0, WAVE_TRIG_LEVEL, 120));
+    while (wavePoll() == WAVE_ARMED) isr();
+    TEST_ASSERT_EQUAL_HEX16(0x0111, waveStep);
+    seen = 0;
+    runUntilDone(WAVE_SAMPLES);
+    TEST_ASSERT_EQUAL(WAVE_DONE, wavePoll());
+    TEST_ASSERT_EQUAL_HEX16(0x0111, seen);
+    TEST_ASSERT_EQUAL_UINT8(1, lsInvalidated);
+
+    WaveInfo w;
+    waveInfo(w);
+    TEST_ASSERT_EQUAL_HEX8(WAVE_F_TRIG, w.flags);
+    TEST_ASSERT_EQUAL_UINT16(WAVE_SAMPLES / 4, w.pre);
+    checkRoundTrip();
+
+    seen = 0;
+    for (int i = 0; i < 12; i++) isr();
+    TEST_ASSERT_EQUAL_HEX16(0x7777, seen);
+}
+
+static void test_zero_cross_single_channel()
+{
+    TEST_ASSERT_TRUE(waveArm(1U << 5, 5, WAVE_TRIG_ZC, 0));
+    runUntilDone(100000);
+    WaveInfo w;
+    TEST_ASSERT_TRUE(waveInfo(w));
+    TEST_ASSERT_EQUAL_HEX8(WAVE_F_TRIG, w.flags);
+    checkRoundTrip();
+}
+
+/* Tetik gelmezse WAVE_TRIG_TIMEOUT_MS sonunda zorla; o süre boyunca normal sıra */
+static void test_forced_after_timeout()
+{
+    amp = 0;
+    TEST_ASSERT_TRUE(waveArm((1U << 1) | (1U << 2), 2, WAVE_TRIG_LEVEL, 50));
+    runUntilDone((WAVE_TRIG_TIMEOUT_MS + 100) * (CS_SAMPLE_HZ / 1000));
+    WaveInfo w;
+    TEST_ASSERT_TRUE(waveInfo(w));
+    TEST_ASSERT_EQUAL_HEX8(WAVE_F_FORCED, w.flags);
+    checkRoundTrip();
+}
+
+static void test_untriggered_full_rate()
+{
+    TEST_ASSERT_TRUE(waveArm((1U << 6) | (1U << 9), 6, WAVE_TRIG_NONE, 0));
+    TEST_ASSERT_EQUAL_HEX16((1U << 6) | (1U << 9), waveStep);
+    runUntilDone(WAVE_SAMPLES + 1);
+    WaveInfo w;
+    TEST_ASSERT_TRUE(waveInfo(w));
+    TEST_ASSERT_EQUAL_UINT16(0, w.pre);
+    checkRoundTrip();
+    TEST_ASSERT_EQUAL_UINT32(WAVE_SAMPLES - 1, rec.back().tick - rec[rec.size() - WAVE_SAMPLES].tick);
+}
+
+static void test_abort_while_armed_keeps_goertzel()
+{
+    TEST_ASSERT_TRUE(waveArm(1U << 5, 5, WAVE_TRIG_ZC, 0));
+    for (int i = 0; i < 50; i++) isr();
+    waveAbort();
+    TEST_ASSERT_EQUAL_UINT8(0, lsInvalidated);
+    TEST_ASSERT_EQUAL_HEX16(0, waveMask);
+    TEST_ASSERT_EQUAL(WAVE_IDLE, wavePoll());
+}
+
+int main(int, char**)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_armed_keeps_round_robin);
+    RUN_TEST(test_trigger_then_mask_only);
+    RUN_TEST(test_zero_cross_single_channel);
+    RUN_TEST(test_forced_after_timeout);
+    RUN_TEST(test_untriggered_full_rate);
+    RUN_TEST(test_abort_while_armed_keeps_goertzel);
+    return UNITY_END();
+}
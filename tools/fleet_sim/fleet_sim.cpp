@@ -0,0 +1,864 @@
+/**
+ * fleet_sim.cpp — çoklu kart simülatörü + broker yük üreteci (Linux)
+ * ------------------------------------------------------------
+ *  › N adet sanal kart (FLOOR_ID = <prefix>000, <prefix>001, …) tek bir
+ *    poll() döngüsünde, gerçek karttaki sırayla bağlanır:
+ *      CONNECT (LWT <id>/status) → "online" → SUBSCRIBE <id>/discovery_hash
+ *      → yalnız özeti tutmayan discovery blokları (ilk bağlanmada 64 config)
+ *      → SUBSCRIBE <id>/+/set → her --telemetry-s’de 32 güç/enerji publish
+ *    Konu ve yükler src/mqtt_payload.cpp’den gelir (kartla aynı byte’lar).
+ *  › Senaryolar
+ *      – thundering herd : tüm kartlar aynı anda (±--jitter-ms) bağlanır,
+ *                          --cycles kez bağlantı koparılıp yeniden kurulur
+ *                          (elektrik kesintisi sonrası)
+ *      – komut fırtınası : ayrı bir “HA” istemcisi saniyede --cmd-rate
+ *                          <id>/Y<n>/set gönderir, <id>/Y<n>/state dönüşüne
+ *                          kadar geçen süreyi ölçer
+ *      – telemetri yükü  : --telemetry-s periyodunda kart başına 32 mesaj
+ *  › Rapor: saniyelik mesaj / byte hızı, CONNACK gecikmesi, discovery
+ *    bitiş süresi ve komut tur süresi yüzdelikleri, kart başına byte.
+ *  › --sn H:P : kartlar MQTT_SN=1 derlemesi gibi UDP / MQTT-SN ile
+ *    tools/mqttsn_gw.py’ye konuşur (önceden tanımlı konu numaraları,
+ *    homeassistant/… için REGISTER, komutlara PUBACK); “HA” yine TCP ile
+ *    broker’da → aynı komutla iki taşımanın tur süresi ve byte’ı
+ *    karşılaştırılır. Özetteki “tel” satırı kartın gördüğü çerçeveleri
+ *    tahmin eder: TCP’de publish başına 54 B başlık + uIP’nin beklediği
+ *    60 B’lık ACK, UDP’de datagram başına 42 B.
+ *  › --disc-full : eski kart gibi her bağlanmada tüm discovery (özet yok)
+ *    → --cycles ile yeniden bağlanma maliyeti karşılaştırılır.
+ *
+ *  Derleme: tools/fleet_sim/Makefile     Kullanım: ./fleet_sim --help
+ * ------------------------------------------------------------*/
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mqtt_payload.h"
+
+//--------------------------------------------------------------
+//  AYARLAR
+//--------------------------------------------------------------
+struct Options {
+    std::string host      = "127.0.0.1";
+    int         port      = 1883;
+    int         boards    = 10;
+    std::string prefix    = "sim";
+    std::string user      = "";
+    std::string pass      = "";
+    double      duration  = 60.0;   // s
+    double      telemetry = 10.0;   // s, kartla aynı
+    double      cmdRate   = 0.0;    // komut / s (tüm filo)
+    double      jitterMs  = 0.0;    // bağlanma dağılımı
+    int         cycles    = 0;      // ek kopma / yeniden bağlanma sayısı
+    double      cycleS    = 30.0;   // kopmalar arası süre
+    double      retryS    = 5.0;    // MQTT_RETRY_MS ile aynı
+    unsigned    seed      = 1;
+    std::string snHost    = "";     // boş değilse kartlar MQTT-SN / UDP
+    int         snPort    = 1885;
+    bool        discFull  = false;  // özet yok, her bağlanmada tüm discovery
+    double      discWaitS = 1.5;    // DISC_HASH_WAIT_MS ile aynı
+};
+
+static double now()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+//--------------------------------------------------------------
+//  MQTT 3.1.1 KODLAMA (yalnız gereken kadarı)
+//--------------------------------------------------------------
+static void putLen(std::string& s, size_t n)
+{
+    do {
+        uint8_t b = n % 128; n /= 128;
+        if (n) b |= 0x80;
+        s.push_back((char)b);
+    } while (n);
+}
+
+static void putStr(std::string& s, const std::string& v)
+{
+    s.push_back((char)(v.size() >> 8));
+    s.push_back((char)(v.size() & 0xFF));
+    s += v;
+}
+
+static std::string pktConnect(const std::string& id, const std::string& willTopic,
+                              const std::string& user, const std::string& pass)
+{
+    std::string vh, pl;
+    putStr(vh, "MQTT");
+    vh.push_back(4);                                    // 3.1.1
+    uint8_t flags = 0x02;                               // clean session
+    if (!willTopic.empty()) flags |= 0x04 | 0x20;       // will + retain, QoS0
+    if (!user.empty()) flags |= 0x80;
+    if (!pass.empty()) flags |= 0x40;
+    vh.push_back((char)flags);
+    vh.push_back(0); vh.push_back(60);                  // keepalive 60 s
+
+    putStr(pl, id);
+    if (!willTopic.empty()) { putStr(pl, willTopic); putStr(pl, "offline"); }
+    if (!user.empty()) putStr(pl, user);
+    if (!pass.empty()) putStr(pl, pass);
+
+    std::string p(1, (char)0x10);
+    putLen(p, vh.size() + pl.size());
+    return p + vh + pl;
+}
+
+static std::string pktPublish(const std::string& topic, const char* payload, size_t len, bool retain)
+{
+    std::string p(1, (char)(0x30 | (retain ? 1 : 0)));
+    putLen(p, 2 + topic.size() + len);
+    putStr(p, topic);
+    p.append(payload, len);
+    return p;
+}
+
+static std::string pktSubscribe(uint16_t id, const std::string& filter)
+{
+    std::string body;
+    body.push_back((char)(id >> 8)); body.push_back((char)(id & 0xFF));
+    putStr(body, filter);
+    body.push_back(0);                                  // QoS0
+    std::string p(1, (char)0x82);
+    putLen(p, body.size());
+    return p + body;
+}
+
+static const std::string PINGREQ("\xC0\x00", 2);
+
+//--------------------------------------------------------------
+//  MQTT-SN 1.2 KODLAMA (--sn, src/mqtt_sn.cpp ile aynı alt küme)
+//--------------------------------------------------------------
+enum : uint8_t {
+    SN_CONNECT = 0x04, SN_CONNACK, SN_WILLTOPICREQ, SN_WILLTOPIC, SN_WILLMSGREQ, SN_WILLMSG,
+    SN_REGISTER, SN_REGACK, SN_PUBLISH, SN_PUBACK,
+    SN_SUBSCRIBE = 0x12, SN_SUBACK, SN_PINGREQ = 0x16, SN_PINGRESP, SN_DISCONNECT,
+};
+
+static void put16(std::string& s, uint16_t v)
+{
+    s.push_back((char)(v >> 8));
+    s.push_back((char)(v & 0xFF));
+}
+
+static std::string snPacket(uint8_t type, const std::string& body)
+{
+    std::string p;
+    size_t n = 2 + body.size();
+    if (n <= 255) p.push_back((char)n);
+    else { p.push_back(1); put16(p, n + 2); }
+    p.push_back((char)type);
+    return p + body;
+}
+
+static std::string snPublish(uint8_t flags, uint16_t topicId, uint16_t mid, const char* payload, size_t len)
+{
+    std::string body(1, (char)flags);
+    put16(body, topicId);
+    put16(body, mid);
+    body.append(payload, len);
+    return snPacket(SN_PUBLISH, body);
+}
+
+/** Datagram → tip + gövde (tipten sonrası) */
+static bool snParse(const std::string& d, uint8_t& type, std::string& body)
+{
+    size_t n, hl;
+    if (d.size() >= 4 && (uint8_t)d[0] == 1) { n = ((uint8_t)d[1] << 8) | (uint8_t)d[2]; hl = 3; }
+    else if (d.size() >= 2)                  { n = (uint8_t)d[0]; hl = 1; }
+    else return false;
+    if (n != d.size() || n <= hl) return false;
+    type = d[hl];
+    body = d.substr(hl + 1);
+    return true;
+}
+
+static uint16_t get16(const std::string& s, size_t i)
+{
+    return ((uint8_t)s[i] << 8) | (uint8_t)s[i + 1];
+}
+
+struct SnLink {
+    int      fd = -1;
+    uint64_t bytesOut = 0, bytesIn = 0, dgOut = 0, dgIn = 0;
+
+    bool open()
+    {
+        if (fd < 0) fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        return fd >= 0;
+    }
+
+    void send(const sockaddr_in& gw, const std::string& pkt)
+    {
+        if (sendto(fd, pkt.data(), pkt.size(), 0, (const sockaddr*)&gw, sizeof(gw)) < 0) return;
+        bytesOut += pkt.size();
+        dgOut++;
+    }
+};
+
+//--------------------------------------------------------------
+//  BAĞLANTI
+//--------------------------------------------------------------
+struct Conn {
+    int         fd = -1;
+    std::string out;
+    std::string in;
+    bool        tcpUp = false;
+    uint64_t    bytesOut = 0, bytesIn = 0, msgsOut = 0;
+
+    bool open(const sockaddr_in& addr)
+    {
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+        if (fd < 0) return false;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        tcpUp = false;
+        out.clear(); in.clear();
+        int r = connect(fd, (const sockaddr*)&addr, sizeof(addr));
+        if (r == 0) tcpUp = true;
+        else if (errno != EINPROGRESS) { close(); return false; }
+        return true;
+    }
+
+    void close()
+    {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+        tcpUp = false;
+    }
+
+    void send(const std::string& pkt) { out += pkt; msgsOut++; }
+
+    /** false → bağlantı koptu */
+    bool flush()
+    {
+        while (!out.empty()) {
+            ssize_t n = ::send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+            bytesOut += n;
+            out.erase(0, n);
+        }
+        return true;
+    }
+
+    bool readSome()
+    {
+        char buf[4096];
+        for (;;) {
+            ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n > 0) { in.append(buf, n); bytesIn += n; continue; }
+            if (n == 0) return false;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+
+    /** Tam bir paket varsa ayır: type/flags + gövde */
+    bool nextPacket(uint8_t& hdr, std::string& body)
+    {
+        if (in.size() < 2) return false;
+        size_t len = 0, mul = 1, i = 1;
+        for (;; ++i) {
+            if (i >= in.size() || i > 4) return false;
+            uint8_t b = in[i];
+            len += (b & 0x7F) * mul;
+            mul *= 128;
+            if (!(b & 0x80)) break;
+        }
+        if (in.size() < i + 1 + len) return false;
+        hdr  = in[0];
+        body = in.substr(i + 1, len);
+        in.erase(0, i + 1 + len);
+        return true;
+    }
+};
+
+static bool parsePublish(uint8_t hdr, const std::string& body, std::string& topic, std::string& payload)
+{
+    if (body.size() < 2) return false;
+    size_t tl = ((uint8_t)body[0] << 8) | (uint8_t)body[1];
+    size_t off = 2 + tl + (((hdr >> 1) & 3) ? 2 : 0);  // QoS>0 → packet id
+    if (body.size() < off) return false;
+    topic   = body.substr(2, tl);
+    payload = body.substr(off);
+    return true;
+}
+
+//--------------------------------------------------------------
+//  İSTATİSTİK
+//--------------------------------------------------------------
+struct Series {
+    std::vector<double> v;
+    void add(double x) { v.push_back(x); }
+    double pct(double p)
+    {
+        if (v.empty()) return 0;
+        std::sort(v.begin(), v.end());
+        size_t k = std::min(v.size() - 1, (size_t)(p / 100.0 * v.size()));
+        return v[k];
+    }
+    void print(const char* name, double scale, const char* unit)
+    {
+        printf("  %-22s n=%-6zu p50=%8.2f p95=%8.2f p99=%8.2f max=%8.2f %s\n",
+               name, v.size(), pct(50) * scale, pct(95) * scale, pct(99) * scale,
+               v.empty() ? 0.0 : *std::max_element(v.begin(), v.end()) * scale, unit);
+    }
+};
+
+static Series connLat, discLat, cmdLat;
+static uint64_t connFails = 0;
+
+//--------------------------------------------------------------
+//  SANAL KART
+//--------------------------------------------------------------
+struct Board {
+    enum State { IDLE, WAIT_CONNACK, UP } st = IDLE;
+    std::string id;
+    Conn        c;
+    double      tStart = 0, tConnAck = 0, nextTry = 0, nextTele = 0, nextPing = 0;
+    bool        discPending = false, discWait = false;
+    bool        pin[MQTT_SWITCH_ITEMS] = {};
+    std::string statusTopic, cmdFilter, hashTopic, discText;
+    uint32_t    discHash[MQTT_DISCOVERY_ITEMS / MQTT_DISC_BLOCK] = {};
+
+    /* --sn: kart gibi UDP; REGISTER’lar kartta olduğu gibi sırayla */
+    struct RegPub { std::string topic, payload; bool retain; };
+    const sockaddr_in*              gw = nullptr;
+    SnLink                          u;
+    std::map<std::string, uint16_t> reg;
+    std::deque<RegPub>              regQueue;
+    uint16_t                        regMid = 0, nextMid = 0, lastCmdMid = 0;
+
+    void begin(double t) { st = IDLE; nextTry = t; }
+
+    void drop()
+    {
+        c.close();
+        st = IDLE;
+    }
+
+    uint64_t msgsOut()  const { return gw ? u.dgOut    : c.msgsOut; }
+    uint64_t bytesOut() const { return gw ? u.bytesOut : c.bytesOut; }
+    uint64_t bytesIn()  const { return gw ? u.bytesIn  : c.bytesIn; }
+    uint16_t mid()            { if (++nextMid == 0) nextMid = 1; return nextMid; }
+
+    void startConnect(const sockaddr_in& addr, const Options& o, double t)
+    {
+        tStart = t;
+        if (gw) {
+            if (!u.open()) { connFails++; nextTry = t + o.retryS; return; }
+            reg.clear(); regQueue.clear(); regMid = 0; lastCmdMid = 0;
+            std::string body(1, (char)(0x08 | 0x04));   // will + clean
+            body.push_back(1);
+            put16(body, 30);                            // SN_KEEPALIVE_S
+            body += id;
+            u.send(*gw, snPacket(SN_CONNECT, body));
+            st = WAIT_CONNACK;
+            return;
+        }
+        if (!c.open(addr)) { connFails++; nextTry = t + o.retryS; return; }
+        c.send(pktConnect(id, statusTopic, o.user, o.pass));
+        st = WAIT_CONNACK;
+    }
+
+    void sendRegister()
+    {
+        if (regMid || regQueue.empty()) return;
+        regMid = mid();
+        std::string body;
+        put16(body, 0);
+        put16(body, regMid);
+        body += regQueue.front().topic;
+        u.send(*gw, snPacket(SN_REGISTER, body));
+    }
+
+    void pub(const std::string& topic, const char* payload, size_t len, bool retain)
+    {
+        if (!gw) { c.send(pktPublish(topic, payload, len, retain)); return; }
+        uint8_t  flags = retain ? 0x10 : 0;
+        uint16_t tid   = mqttSnTopicId(id.c_str(), topic.c_str());
+        if (tid) { u.send(*gw, snPublish(flags | 0x01, tid, 0, payload, len)); return; }
+        auto it = reg.find(topic);
+        if (it != reg.end()) { u.send(*gw, snPublish(flags, it->second, 0, payload, len)); return; }
+        regQueue.push_back({ topic, std::string(payload, len), retain });
+        sendRegister();
+    }
+
+    bool discoveryDone() const { return !discWait && (gw ? regQueue.empty() : c.out.empty()); }
+
+    static constexpr uint8_t DISC_BLOCKS = MQTT_DISCOVERY_ITEMS / MQTT_DISC_BLOCK;
+
+    /** Karttaki discoveryHashBlock(): blok başına FNV-1a (konu, \0, yük) */
+    void hashDiscovery()
+    {
+        char topic[64], payload[1024];
+        StaticJsonDocument<MQTT_DISCOVERY_DOC> doc;
+        for (uint8_t i = 0; i < MQTT_DISCOVERY_ITEMS; i++) {
+            uint32_t& h = discHash[i / MQTT_DISC_BLOCK];
+            if (i % MQTT_DISC_BLOCK == 0) h = MQTT_HASH_SEED;
+            if (!mqttDiscoveryItem(id.c_str(), i, topic, sizeof(topic), doc)) continue;
+            size_t len = serializeJson(doc, payload, sizeof(payload));
+            h = mqttHashAdd(h, topic, strlen(topic) + 1);
+            h = mqttHashAdd(h, payload, len);
+        }
+        char buf[8 + DISC_BLOCKS * 9];
+        size_t n = mqttDiscHashText('e', discHash, DISC_BLOCKS, buf, sizeof(buf));
+        discText.assign(buf, n);
+    }
+
+    void publishDiscovery(uint32_t stale)
+    {
+        char topic[64], payload[1024];
+        StaticJsonDocument<MQTT_DISCOVERY_DOC> doc;
+        for (uint8_t i = 0; i < MQTT_DISCOVERY_ITEMS; i++) {
+            if (!(stale & (1UL << (i / MQTT_DISC_BLOCK)))) continue;
+            if (!mqttDiscoveryItem(id.c_str(), i, topic, sizeof(topic), doc)) continue;
+            size_t len = serializeJson(doc, payload, sizeof(payload));
+            pub(topic, payload, len, true);
+        }
+        discWait = false;
+        if (!hashTopic.empty()) pub(hashTopic, discText.data(), discText.size(), true);
+    }
+
+    /** Retained <id>/discovery_hash (karttaki cmdDiscoveryHash) */
+    void onDiscoveryHash(const std::string& payload)
+    {
+        if (!discWait) return;                          // kendi yayınımızın yankısı
+        uint32_t stale = mqttDiscStale(payload.data(), payload.size(), 'e', discHash, DISC_BLOCKS);
+        if (stale) publishDiscovery(stale);
+        discWait = false;
+    }
+
+    void subscribe(const std::string& filter)
+    {
+        if (!gw) { c.send(pktSubscribe(mid(), filter)); return; }
+        std::string body(1, (char)0x20);                // QoS1, konu adı
+        put16(body, mid());
+        body += filter;
+        u.send(*gw, snPacket(SN_SUBSCRIBE, body));
+    }
+
+    /** Karttaki reconnect() başarı dalı */
+    void onConnAck(double t, const Options& o)
+    {
+        st = UP;
+        tConnAck = t;
+        connLat.add(t - tStart);
+
+        pub(statusTopic, "online", 6, true);
+
+        discPending = true;
+        if (o.discFull) {
+            publishDiscovery(0xFFFFFFFFUL);
+        } else {
+            discWait = true;                            // karar onDiscoveryHash / zaman aşımında
+            subscribe(hashTopic);
+        }
+        subscribe(cmdFilter);
+        nextTele = t + o.telemetry;
+        nextPing = t + 30;
+    }
+
+    void ping()
+    {
+        if (gw) u.send(*gw, snPacket(SN_PINGREQ, ""));
+        else    c.send(PINGREQ);
+    }
+
+    void publishTelemetry()
+    {
+        char topic[48], buf[16];
+        for (uint8_t ch = 0; ch < MQTT_SENSOR_CHANNELS; ch++) {
+            float w = pin[ch] ? 100.0f + ch : 0.0f;
+            size_t n = mqttFormatValue(w, 1, buf, sizeof(buf));
+            mqttTelemetryTopic(id.c_str(), ch, false, topic, sizeof(topic));
+            pub(topic, buf, n, false);
+
+            n = mqttFormatValue(w * 0.5f, 2, buf, sizeof(buf));
+            mqttTelemetryTopic(id.c_str(), ch, true, topic, sizeof(topic));
+            pub(topic, buf, n, false);
+        }
+    }
+
+    /** <id>/Y7/set → durum değiştir, state publish (karttaki callback) */
+    void onCommand(const std::string& topic, const std::string& payload)
+    {
+        size_t p = topic.find('/');
+        if (p == std::string::npos) return;
+        std::string alias = topic.substr(p + 1, topic.rfind('/') - p - 1);
+        if (alias.size() < 2 || (alias[0] != 'Y' && alias[0] != 'X')) return;
+        int num = atoi(alias.c_str() + 1);
+        if (num < 0 || num > 15) return;
+        int idx = (alias[0] == 'Y') ? num : 16 + num;
+        pin[idx] = payload.compare(0, 2, "ON") == 0;
+
+        char st[48];
+        mqttStateTopic(id.c_str(), idx, st, sizeof(st));
+        const char* v = pin[idx] ? "ON" : "OFF";
+        pub(st, v, strlen(v), true);
+    }
+
+    /** --sn: gateway’den gelen datagram; false → bağlantı bitti */
+    bool onDatagram(const std::string& d, double t, const Options& o)
+    {
+        uint8_t type; std::string body;
+        if (!snParse(d, type, body)) return true;
+        switch (type) {
+        case SN_WILLTOPICREQ: {
+            std::string b(1, (char)0x10);               // retain
+            u.send(*gw, snPacket(SN_WILLTOPIC, b + statusTopic));
+            break;
+        }
+        case SN_WILLMSGREQ:
+            u.send(*gw, snPacket(SN_WILLMSG, "offline"));
+            break;
+        case SN_CONNACK:
+            if (st != WAIT_CONNACK) break;
+            if (body.empty() || body[0] != 0) return false;
+            onConnAck(t, o);
+            break;
+        case SN_REGACK: {
+            if (body.size() < 5 || !regMid || get16(body, 2) != regMid || regQueue.empty()) break;
+            RegPub& r = regQueue.front();
+            uint16_t tid = get16(body, 0);
+            if (body[4] == 0) {
+                reg[r.topic] = tid;
+                u.send(*gw, snPublish(r.retain ? 0x10 : 0, tid, 0, r.payload.data(), r.payload.size()));
+            }
+            regQueue.pop_front();
+            regMid = 0;
+            sendRegister();
+            break;
+        }
+        case SN_PUBLISH: {
+            if (body.size() < 5) break;
+            uint8_t  flags = body[0];
+            uint16_t tid = get16(body, 1), m = get16(body, 3);
+            char name[64];
+            bool known = (flags & 0x03) == 0x01 && mqttSnTopicName(id.c_str(), tid, name, sizeof(name));
+            if ((flags & 0x60) == 0x20) {
+                std::string ack = body.substr(1, 4);
+                ack.push_back(known ? 0 : 2);
+                u.send(*gw, snPacket(SN_PUBACK, ack));
+                if (m == lastCmdMid) break;             // tekrar
+                lastCmdMid = m;
+            }
+            if (known && name == hashTopic) onDiscoveryHash(body.substr(5));
+            else if (known) onCommand(name, body.substr(5));
+            break;
+        }
+        case SN_DISCONNECT:
+            return false;
+        default:                                        // SUBACK, PINGRESP
+            break;
+        }
+        return true;
+    }
+
+    bool readDatagrams(double t, const Options& o)
+    {
+        char buf[2048];
+        for (;;) {
+            ssize_t n = recv(u.fd, buf, sizeof(buf), 0);
+            if (n <= 0) return true;
+            u.bytesIn += n;
+            u.dgIn++;
+            if (!onDatagram(std::string(buf, n), t, o)) return false;
+        }
+    }
+};
+
+//--------------------------------------------------------------
+//  ANA
+//--------------------------------------------------------------
+static volatile sig_atomic_t stopFlag = 0;
+static void onSig(int) { stopFlag = 1; }
+
+static void usage()
+{
+    puts("fleet_sim — çoklu kart MQTT yük testi\n"
+         "  --host H --port P          broker (127.0.0.1:1883)\n"
+         "  --boards N --prefix S      N kart, FLOOR_ID = S000…\n"
+         "  --user U --pass P          MQTT kimlik\n"
+         "  --duration S               test süresi (60)\n"
+         "  --telemetry-s S            telemetri periyodu (10)\n"
+         "  --cmd-rate R               saniyede komut (0)\n"
+         "  --jitter-ms J              bağlanma dağılımı (0 = sürü)\n"
+         "  --cycles K --cycle-s S     K kez hepsini kopar / yeniden bağla\n"
+         "  --sn H:P                   kartlar MQTT-SN / UDP ile gateway’e (mqttsn_gw.py)\n"
+         "  --disc-full                her bağlanmada tüm discovery (özetsiz eski kart)\n"
+         "  --seed N");
+}
+
+static bool resolve(const std::string& host, int port, sockaddr_in& addr)
+{
+    addr.sin_family = AF_INET;
+    addr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) == 1) return true;
+    hostent* he = gethostbyname(host.c_str());
+    if (!he) { fprintf(stderr, "host çözülemedi: %s\n", host.c_str()); return false; }
+    memcpy(&addr.sin_addr, he->h_addr, sizeof(addr.sin_addr));
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv, Options& o)
+{
+    static const option longOpts[] = {
+        {"host", 1, 0, 'h'}, {"port", 1, 0, 'p'}, {"boards", 1, 0, 'n'},
+        {"prefix", 1, 0, 'x'}, {"user", 1, 0, 'u'}, {"pass", 1, 0, 'w'},
+        {"duration", 1, 0, 'd'}, {"telemetry-s", 1, 0, 't'}, {"cmd-rate", 1, 0, 'r'},
+        {"jitter-ms", 1, 0, 'j'}, {"cycles", 1, 0, 'k'}, {"cycle-s", 1, 0, 'c'},
+        {"seed", 1, 0, 's'}, {"sn", 1, 0, 'g'}, {"disc-full", 0, 0, 'f'}, {"help", 0, 0, '?'}, {0, 0, 0, 0}};
+    int ch;
+    while ((ch = getopt_long(argc, argv, "", longOpts, nullptr)) != -1) {
+        switch (ch) {
+        case 'h': o.host = optarg; break;
+        case 'p': o.port = atoi(optarg); break;
+        case 'n': o.boards = atoi(optarg); break;
+        case 'x': o.prefix = optarg; break;
+        case 'u': o.user = optarg; break;
+        case 'w': o.pass = optarg; break;
+        case 'd': o.duration = atof(optarg); break;
+        case 't': o.telemetry = atof(optarg); break;
+        case 'r': o.cmdRate = atof(optarg); break;
+        case 'j': o.jitterMs = atof(optarg); break;
+        case 'k': o.cycles = atoi(optarg); break;
+        case 'c': o.cycleS = atof(optarg); break;
+        case 's': o.seed = (unsigned)atoi(optarg); break;
+        case 'f': o.discFull = true; break;
+        case 'g': {
+            std::string v = optarg;
+            size_t c = v.rfind(':');
+            o.snHost = v.substr(0, c);
+            if (c != std::string::npos) o.snPort = atoi(v.c_str() + c + 1);
+            break;
+        }
+        default:  usage(); return false;
+        }
+    }
+    return o.boards > 0 && o.boards <= 1000;
+}
+
+int main(int argc, char** argv)
+{
+    Options o;
+    if (!parseArgs(argc, argv, o)) return 1;
+    signal(SIGINT, onSig);
+
+    sockaddr_in addr{}, gwAddr{};
+    if (!resolve(o.host, o.port, addr)) return 1;
+    bool sn = !o.snHost.empty();
+    if (sn && !resolve(o.snHost, o.snPort, gwAddr)) return 1;
+
+    std::mt19937 rng(o.seed);
+    std::uniform_real_distribution<double> jitter(0.0, o.jitterMs / 1000.0);
+
+    const double t0 = now();
+    std::vector<Board> boards(o.boards);
+    for (int i = 0; i < o.boards; i++) {
+        char id[32];
+        snprintf(id, sizeof(id), "%s%03d", o.prefix.c_str(), i);
+        Board& b = boards[i];
+        b.id = id;
+        if (sn) b.gw = &gwAddr;
+        char buf[64];
+        mqttStatusTopic(id, buf, sizeof(buf));   b.statusTopic = buf;
+        mqttCommandFilter(id, buf, sizeof(buf)); b.cmdFilter   = buf;
+        if (!o.discFull) b.hashTopic = std::string(id) + "/discovery_hash";
+        b.hashDiscovery();
+        b.begin(t0 + jitter(rng));
+    }
+
+    /* “HA” tarafı: komut gönderir, state dönüşünü bekler */
+    Conn ha;
+    bool haUp = false;
+    std::map<std::string, double> inflight;      // state konusu → gönderim anı
+    std::uniform_int_distribution<int> pickBoard(0, o.boards - 1), pickOut(0, MQTT_SWITCH_ITEMS - 1);
+    if (o.cmdRate > 0) {
+        if (!ha.open(addr)) { perror("ha connect"); return 1; }
+        ha.send(pktConnect(o.prefix + "_ha", "", o.user, o.pass));
+        ha.send(pktSubscribe(1, "+/+/state"));
+    }
+    double nextCmd = t0 + 1.0, cmdAcc = 0;
+
+    int    cyclesLeft = o.cycles;
+    double nextCycle  = t0 + o.cycleS;
+    double nextReport = t0 + 1.0;
+    uint64_t lastMsgs = 0, lastBytes = 0;
+
+    if (sn) printf("fleet_sim: %d kart → MQTT-SN %s:%d (HA → %s:%d), %.0f s\n", o.boards,
+                   o.snHost.c_str(), o.snPort, o.host.c_str(), o.port, o.duration);
+    else    printf("fleet_sim: %d kart → %s:%d, %.0f s\n", o.boards, o.host.c_str(), o.port, o.duration);
+    printf("%6s %5s %9s %9s %7s\n", "t[s]", "up", "msg/s", "kB/s", "cmd");
+
+    std::vector<pollfd> pfds;
+    std::vector<int>    owners;                  // kart indeksi, -1 → HA
+    while (!stopFlag) {
+        double t = now();
+        if (t - t0 >= o.duration) break;
+
+        /* ---- kopma döngüsü (elektrik kesintisi) ---- */
+        if (cyclesLeft > 0 && t >= nextCycle) {
+            for (Board& b : boards) { b.drop(); b.begin(t + jitter(rng)); }
+            cyclesLeft--;
+            nextCycle = t + o.cycleS;
+        }
+
+        /* ---- kart zamanlayıcıları ---- */
+        for (Board& b : boards) {
+            if (b.st == Board::IDLE && t >= b.nextTry) b.startConnect(addr, o, t);
+            if (sn && b.st == Board::WAIT_CONNACK && t - b.tStart > 1.0) {   // UDP: yanıt yok
+                connFails++;
+                b.drop();
+                b.nextTry = t + o.retryS;
+            }
+            if (b.st != Board::UP) continue;
+            if (t >= b.nextTele) { b.publishTelemetry(); b.nextTele += o.telemetry; }
+            if (t >= b.nextPing) { b.ping(); b.nextPing = t + 30; }
+            if (b.discWait && t - b.tConnAck > o.discWaitS) b.publishDiscovery(0xFFFFFFFFUL);
+            if (b.discPending && b.discoveryDone()) { discLat.add(t - b.tConnAck); b.discPending = false; }
+        }
+
+        /* ---- komut fırtınası ---- */
+        if (haUp && t >= nextCmd) {
+            cmdAcc += o.cmdRate * (t - nextCmd + 0.01);
+            nextCmd = t + 0.01;
+            for (; cmdAcc >= 1.0; cmdAcc -= 1.0) {
+                Board& b = boards[pickBoard(rng)];
+                if (b.st != Board::UP) continue;
+                int idx = pickOut(rng);
+                char st[48];
+                mqttStateTopic(b.id.c_str(), idx, st, sizeof(st));
+                std::string cmd(st);
+                cmd.replace(cmd.rfind("/state"), 6, "/set");
+                const char* v = b.pin[idx] ? "OFF" : "ON";
+                ha.send(pktPublish(cmd, v, strlen(v), false));
+                inflight[st] = t;
+            }
+        }
+
+        /* ---- poll ---- */
+        pfds.clear(); owners.clear();
+        for (int i = 0; i < o.boards; i++) {
+            if (sn) {
+                if (boards[i].u.fd < 0) continue;
+                pfds.push_back({boards[i].u.fd, POLLIN, 0});
+                owners.push_back(i);
+                continue;
+            }
+            Conn& c = boards[i].c;
+            if (c.fd < 0) continue;
+            short ev = POLLIN;
+            if (!c.tcpUp || !c.out.empty()) ev |= POLLOUT;
+            pfds.push_back({c.fd, ev, 0});
+            owners.push_back(i);
+        }
+        if (ha.fd >= 0) {
+            short ev = POLLIN;
+            if (!ha.tcpUp || !ha.out.empty()) ev |= POLLOUT;
+            pfds.push_back({ha.fd, ev, 0});
+            owners.push_back(-1);
+        }
+        poll(pfds.data(), pfds.size(), 5);
+        t = now();
+
+        for (size_t k = 0; k < pfds.size(); k++) {
+            Board* b = (owners[k] < 0) ? nullptr : &boards[owners[k]];
+            Conn*  c = b ? &b->c : &ha;
+            short re = pfds[k].revents;
+            bool ok = true;
+
+            if (b && sn) {
+                if ((re & POLLIN) && !b->readDatagrams(t, o)) {
+                    connFails++;
+                    b->drop();
+                    b->nextTry = t + o.retryS;
+                }
+                continue;
+            }
+
+            if (re & (POLLERR | POLLHUP)) ok = false;
+            if (ok && (re & POLLOUT)) { c->tcpUp = true; ok = c->flush(); }
+            if (ok && (re & POLLIN))  ok = c->readSome();
+
+            uint8_t hdr; std::string body;
+            while (ok && c->nextPacket(hdr, body)) {
+                uint8_t type = hdr >> 4;
+                if (type == 2) {                                   // CONNACK
+                    bool accepted = body.size() >= 2 && body[1] == 0;
+                    if (!b) { haUp = accepted; continue; }
+                    if (accepted) b->onConnAck(t, o);
+                    else          ok = false;
+                } else if (type == 3) {                            // PUBLISH
+                    std::string topic, payload;
+                    if (!parsePublish(hdr, body, topic, payload)) continue;
+                    if (b && topic == b->hashTopic) { b->onDiscoveryHash(payload); continue; }
+                    if (b) { b->onCommand(topic, payload); continue; }
+                    auto it = inflight.find(topic);
+                    if (it != inflight.end()) { cmdLat.add(t - it->second); inflight.erase(it); }
+                }
+            }
+
+            if (!ok) {
+                if (!b) { fprintf(stderr, "HA bağlantısı koptu\n"); ha.close(); haUp = false; continue; }
+                connFails++;
+                b->drop();
+                b->nextTry = t + o.retryS;
+            }
+        }
+        for (Board& b : boards)
+            if (b.c.fd >= 0 && !b.c.out.empty() && b.c.tcpUp && !b.c.flush()) { b.drop(); b.nextTry = t + o.retryS; }
+
+        /* ---- saniyelik satır ---- */
+        if (t >= nextReport) {
+            uint64_t msgs = 0, bytes = 0; int up = 0;
+            for (Board& b : boards) { msgs += b.msgsOut(); bytes += b.bytesOut(); up += b.st == Board::UP; }
+            printf("%6.1f %5d %9llu %9.1f %7zu\n", t - t0, up,
+                   (unsigned long long)(msgs - lastMsgs), (bytes - lastBytes) / 1024.0, cmdLat.v.size());
+            fflush(stdout);
+            lastMsgs = msgs; lastBytes = bytes;
+            nextReport += 1.0;
+        }
+    }
+
+    /* ---- özet ---- */
+    uint64_t msgs = 0, out = 0, in = 0;
+    for (Board& b : boards) { msgs += b.msgsOut(); out += b.bytesOut(); in += b.bytesIn(); }
+    double el = now() - t0;
+    /* Kartın ağ tarafında gördüğü: TCP → segment başına 54 B + uIP’nin beklediği
+       60 B’lık ACK; UDP → datagram başına 42 B, ACK yok */
+    double wire = sn ? out + msgs * 42.0 : out + msgs * (54.0 + 60.0);
+    printf("\nÖzet (%.1f s, %d kart, %s)\n", el, o.boards, sn ? "MQTT-SN/UDP" : "MQTT/TCP");
+    printf("  paket                  %llu  (%.1f msg/s)\n", (unsigned long long)msgs, msgs / el);
+    printf("  kart başına gönderilen %.1f kB, alınan %.1f kB\n",
+           out / 1024.0 / o.boards, in / 1024.0 / o.boards);
+    printf("  kart başına tel (tah.) %.1f kB gönderilen + ACK\n", wire / 1024.0 / o.boards);
+    printf("  bağlantı hatası        %llu\n", (unsigned long long)connFails);
+    connLat.print("CONNACK gecikmesi", 1000, "ms");
+    discLat.print("discovery bitişi", 1000, "ms");
+    cmdLat.print("komut → state", 1000, "ms");
+    if (!inflight.empty()) printf("  yanıtsız komut         %zu\n", inflight.size());
+    return 0;
+}
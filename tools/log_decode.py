@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""log_decode.py — LOG_BINARY=1 ile derlenmiş kartın seri çıktısını çözer.
+
+İkili kayıt (src/log.cpp):
+    A5 | len | lvl | fmt(2, LE) | ms(4, LE) | arg...
+        fmt : flash'taki format dizgisinin adresi → ELF'in .text bölümünden okunur
+        arg : %d/%u/%x/%c → 2 byte, %l.. → 4 byte, %s/%S → '\\0' ile biten dizgi
+        fmt == 0 → "N kayıt atıldı" bildirimi (arg: uint16)
+Kayıt dışındaki byte'lar (konsol cevapları vb.) olduğu gibi basılır.
+
+Kullanım:
+    python3 tools/log_decode.py .pio/build/megaatmega2560/firmware.elf capture.bin
+    python3 tools/log_decode.py firmware.elf /dev/ttyACM0 --baud 9600     (pyserial)
+"""
+import argparse
+import os
+import re
+import struct
+import subprocess
+import sys
+import tempfile
+
+SYNC = 0xA5
+LEVELS = "-EWID"
+SPEC = re.compile(rb"%([-+ #0]*)(\d*)(?:\.(\d+))?(l?)([diuxXocsS%])")
+
+
+def load_flash(elf, objcopy):
+    """ELF → .text bölümünün ham görüntüsü (adres 0'dan başlar)."""
+    with tempfile.NamedTemporaryFile(suffix=".bin", delete=False) as tmp:
+        path = tmp.name
+    try:
+        subprocess.check_call([objcopy, "-O", "binary", "-j", ".text", elf, path])
+        with open(path, "rb") as f:
+            return f.read()
+    finally:
+        os.unlink(path)
+
+
+def c_string(buf, off):
+    end = buf.index(b"\0", off)
+    return buf[off:end], end + 1
+
+
+def render(fmt, args):
+    """C formatını ham argüman byte'larıyla doldur."""
+    out, pos, a = [], 0, 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()].decode("latin-1"))
+        pos = m.end()
+        flags, width, prec, is_long, conv = m.groups()
+        conv = conv.decode()
+        if conv == "%":
+            out.append("%")
+            continue
+        spec = "%" + (flags + width).decode()
+        if prec is not None:
+            spec += "." + prec.decode()
+        if conv in "sS":
+            s, a = c_string(args, a)
+            out.append((spec + "s") % s.decode("latin-1"))
+            continue
+        size = 4 if is_long else 2
+        if a + size > len(args):
+            out.append("<?>")
+            break
+        signed = conv in "di"
+        v = int.from_bytes(args[a:a + size], "little", signed=signed)
+        a += size
+        out.append((spec + ("c" if conv == "c" else conv.replace("u", "d"))) % v)
+    out.append(fmt[pos:].decode("latin-1"))
+    return "".join(out)
+
+
+def decode_record(flash, payload):
+    lvl, fmt_addr, ms = struct.unpack_from("<BHI", payload, 0)
+    args = payload[7:]
+    tag = LEVELS[lvl] if lvl < len(LEVELS) else "?"
+    if fmt_addr == 0:
+        cnt = int.from_bytes(args[:2], "little")
+        return "[%s %u] log: %u kayit atildi" % (tag, ms, cnt)
+    try:
+        fmt, _ = c_string(flash, fmt_addr)
+        text = render(fmt, args)
+    except (ValueError, IndexError):
+        text = "<fmt@0x%04x ?> %s" % (fmt_addr, args.hex())
+    return "[%s %u] %s" % (tag, ms, text)
+
+
+def stream(src, flash, out):
+    buf = bytearray()
+    while True:
+        chunk = src.read(256)
+        if not chunk:
+            break
+        buf += chunk
+        while buf:
+            i = buf.find(bytes([SYNC]))
+            if i < 0:
+                out.write(buf.decode("latin-1"))
+                buf.clear()
+                break
+            if i > 0:
+                out.write(buf[:i].decode("latin-1"))
+                del buf[:i]
+            if len(buf) < 2 or len(buf) < 2 + buf[1]:
+                break                           # kaydın devamını bekle
+            n = buf[1]
+            if n < 7:                           # sahte senkron byte'ı
+                out.write(chr(buf[0]))
+                del buf[:1]
+                continue
+            out.write(decode_record(flash, bytes(buf[2:2 + n])) + "\n")
+            del buf[:2 + n]
+        out.flush()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf")
+    ap.add_argument("input", help="yakalama dosyası, '-' (stdin) ya da seri port")
+    ap.add_argument("--baud", type=int, default=9600)
+    ap.add_argument("--objcopy", default="avr-objcopy")
+    opt = ap.parse_args()
+
+    flash = load_flash(opt.elf, opt.objcopy)
+
+    if opt.input == "-":
+        src = sys.stdin.buffer
+    elif opt.input.startswith("/dev/") or opt.input.upper().startswith("COM"):
+        import serial                            # pyserial
+        src = serial.Serial(opt.input, opt.baud, timeout=1)
+    else:
+        src = open(opt.input, "rb")
+    stream(src, flash, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
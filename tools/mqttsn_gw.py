@@ -0,0 +1,573 @@
+#!/usr/bin/env python3
+"""mqttsn_gw.py — kartın MQTT-SN (UDP) taşıması için gateway / test yerine geçen (Linux).
+
+Kart MQTT_SN=1 ile derlenince ([env:megaatmega2560_sn]) broker yerine bu
+sürece UDP ile konuşur. Her kart için broker’a ayrı bir TCP bağlantısı açılır
+(istemci kimliği ve LWT kartınki) → HA tarafında hiçbir şey değişmez.
+
+    kart ──UDP/MQTT-SN──▶ mqttsn_gw.py ──TCP/MQTT 3.1.1──▶ Mosquitto ◀── HA
+
+Konu numaraları src/mqtt_payload.cpp (mqttSnTopicId) ile AYNI olmalı:
+    0x0001‥0x0014  <id>/status … <id>/diag/wave      (FIXED sırası)
+    0x0100 + idx   <id>/{Y|X}<n>/state      0x0200 + idx   <id>/{Y|X}<n>/set
+    0x0300 + ch    <id>/Y<n>/power          0x0320 + ch    <id>/Y<n>/energy
+    0x0400 + 32·k + ch                      <id>/Y<n>/{thd|load|anomaly}
+Tabloda olmayanlar (homeassistant/…) kartın REGISTER’ıyla 0x1000’den numaralanır.
+
+Güvenilirlik: broker’dan karta giden komutlar QoS1 (PUBACK gelmezse
+--retry-ms’de bir DUP, en çok --retries kez); karttan gelen QoS1
+(alert, power/event, diag/crash) broker’a iletildikten sonra PUBACK’lenir.
+Kart CONNECT’teki keepalive’ın 1.5 katı sessiz kalırsa broker bağlantısı DISCONNECT’siz
+kapatılır → broker kartın LWT’sini ("offline") yayınlar.
+
+--standalone: broker yok; karttan gelenler ekrana, stdin’den
+"<konu> <yük>" satırları (ör. "up32/Y3/set ON") komut olarak karta gider.
+
+Kullanım:
+    python3 tools/mqttsn_gw.py --broker 127.0.0.1:1883 --user mqttuser --pass 123
+    python3 tools/mqttsn_gw.py --standalone --listen 0.0.0.0:1885
+"""
+import argparse
+import collections
+import selectors
+import socket
+import struct
+import sys
+import time
+
+# --------------------------------------------------------------------------
+#  KONU TABLOSU (src/mqtt_payload.cpp ile aynı)
+# --------------------------------------------------------------------------
+FIXED = ["status", "alert", "replay", "stats", "power/state", "power/event",
+         "diag/ram", "diag/crash", "diag/profile",
+         "outputs/set", "scene/set", "scene/define", "rules/set", "time/set",
+         "profile/set", "budget/set", "priority/set", "discovery_hash",
+         "wave/set", "diag/wave"]
+SIG = ["thd", "load", "anomaly"]
+ID_STATE, ID_SET, ID_POWER, ID_ENERGY, ID_SIG = 0x0100, 0x0200, 0x0300, 0x0320, 0x0400
+REG_BASE = 0x1000
+QUEUE_MAX = 32                                      # kart başına bekleyen komut
+
+
+def alias(s):
+    """"Y7/…" | "X10/…" → (idx, kalan); aksi (None, None)."""
+    if len(s) < 3 or s[0] not in "YX":
+        return None, None
+    head, _, rest = s[1:].partition("/")
+    if not rest or not head.isdigit() or len(head) > 2 or (len(head) == 2 and head[0] == "0"):
+        return None, None
+    num = int(head)
+    if num > 15:
+        return None, None
+    return (num if s[0] == "Y" else 16 + num), rest
+
+
+def topic_id(floor, topic):
+    if not topic.startswith(floor + "/"):
+        return 0
+    s = topic[len(floor) + 1:]
+    if s in FIXED:
+        return 1 + FIXED.index(s)
+    idx, rest = alias(s)
+    if idx is None:
+        return 0
+    if rest == "state":
+        return ID_STATE + idx
+    if rest == "set":
+        return ID_SET + idx
+    if idx >= 16:
+        return 0
+    if rest == "power":
+        return ID_POWER + idx
+    if rest == "energy":
+        return ID_ENERGY + idx
+    if rest in SIG:
+        return ID_SIG + 32 * SIG.index(rest) + idx
+    return 0
+
+
+def topic_name(floor, tid):
+    if 1 <= tid <= len(FIXED):
+        return "%s/%s" % (floor, FIXED[tid - 1])
+    lo = tid & 0x1F
+    if tid & 0xFFE0 in (ID_STATE, ID_SET):
+        return "%s/%s%d/%s" % (floor, "Y" if lo < 16 else "X", lo % 16,
+                               "set" if tid & 0xFFE0 == ID_SET else "state")
+    if tid & 0xFFF0 in (ID_POWER, ID_ENERGY):
+        return "%s/Y%d/%s" % (floor, tid & 0x0F, "energy" if tid & 0xFFF0 == ID_ENERGY else "power")
+    if ID_SIG <= tid < ID_SIG + 32 * len(SIG) and lo < 16:
+        return "%s/Y%d/%s" % (floor, lo, SIG[(tid - ID_SIG) // 32])
+    return None
+
+
+def topic_match(flt, topic):
+    f, t = flt.split("/"), topic.split("/")
+    for i, part in enumerate(f):
+        if part == "#":
+            return True
+        if i >= len(t) or (part != "+" and part != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+# --------------------------------------------------------------------------
+#  MQTT-SN 1.2 KODLAMA
+# --------------------------------------------------------------------------
+CONNECT, CONNACK, WILLTOPICREQ, WILLTOPIC, WILLMSGREQ, WILLMSG = 0x04, 0x05, 0x06, 0x07, 0x08, 0x09
+REGISTER, REGACK, PUBLISH, PUBACK = 0x0A, 0x0B, 0x0C, 0x0D
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 0x12, 0x13, 0x16, 0x17, 0x18
+F_DUP, F_QOS1, F_RETAIN, F_WILL = 0x80, 0x20, 0x10, 0x08
+T_NORMAL, T_PREDEF = 0x00, 0x01
+RC_OK, RC_CONGESTION, RC_INVALID_TOPIC, RC_NOT_SUPPORTED = 0, 1, 2, 3
+
+
+def sn_pack(mtype, body=b""):
+    n = 2 + len(body)
+    if n <= 255:
+        return bytes((n, mtype)) + body
+    return struct.pack(">BHB", 1, n + 2, mtype) + body
+
+
+def sn_unpack(d):
+    if len(d) >= 4 and d[0] == 1:
+        n, hl = struct.unpack(">H", d[1:3])[0], 3
+    elif len(d) >= 2:
+        n, hl = d[0], 1
+    else:
+        return None, None
+    if n != len(d) or n <= hl:
+        return None, None
+    return d[hl], d[hl + 1:]
+
+
+def sn_publish(flags, tid, mid, payload):
+    return sn_pack(PUBLISH, struct.pack(">BHH", flags, tid, mid) + payload)
+
+
+# --------------------------------------------------------------------------
+#  MQTT 3.1.1 (broker tarafı; yalnız gereken kadarı)
+# --------------------------------------------------------------------------
+def mq_str(s):
+    b = s.encode() if isinstance(s, str) else s
+    return struct.pack(">H", len(b)) + b
+
+
+def mq_len(n):
+    out = bytearray()
+    while True:
+        b, n = n % 128, n // 128
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def mq_packet(hdr, body):
+    return bytes((hdr,)) + mq_len(len(body)) + body
+
+
+class Broker:
+    """Tek bir kart adına broker bağlantısı (engellemesiz)."""
+
+    def __init__(self, addr, user, pwd):
+        self.addr, self.user, self.pwd = addr, user, pwd
+        self.sock, self.inbuf, self.outbuf = None, b"", b""
+        self.next_pid, self.last_tx = 1, 0.0
+
+    def open(self, cid, will):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.sock.setblocking(False)
+        self.sock.connect_ex(self.addr)
+        flags = 0x02
+        payload = mq_str(cid)
+        if will:
+            flags |= 0x04 | (0x20 if will[2] else 0)
+            payload += mq_str(will[0]) + mq_str(will[1])
+        if self.user:
+            flags |= 0x80
+            payload += mq_str(self.user)
+        if self.pwd:
+            flags |= 0x40
+            payload += mq_str(self.pwd)
+        self.send(mq_packet(0x10, mq_str("MQTT") + bytes((4, flags)) + struct.pack(">H", 60) + payload))
+
+    def send(self, pkt):
+        self.outbuf += pkt
+        self.last_tx = time.monotonic()
+
+    def publish(self, topic, payload, retain):
+        self.send(mq_packet(0x30 | (1 if retain else 0), mq_str(topic) + payload))
+
+    def subscribe(self, flt):
+        pid, self.next_pid = self.next_pid, self.next_pid % 0xFFFF + 1
+        self.send(mq_packet(0x82, struct.pack(">H", pid) + mq_str(flt) + b"\x00"))
+
+    def flush(self):
+        try:
+            while self.outbuf:
+                n = self.sock.send(self.outbuf)
+                self.outbuf = self.outbuf[n:]
+        except OSError:                             # bağlanıyor / dolu → sonraki turda
+            pass
+
+    def read(self):
+        """→ [(tip, gövde)] ya da None (bağlantı koptu)."""
+        try:
+            d = self.sock.recv(4096)
+        except (BlockingIOError, InterruptedError):
+            return []
+        except OSError:
+            return None
+        if not d:
+            return None
+        self.inbuf += d
+        out = []
+        while len(self.inbuf) >= 2:
+            n, mul, i = 0, 1, 1
+            while True:
+                if i >= len(self.inbuf) or i > 4:
+                    return out
+                n += (self.inbuf[i] & 0x7F) * mul
+                mul *= 128
+                if not self.inbuf[i] & 0x80:
+                    break
+                i += 1
+            if len(self.inbuf) < i + 1 + n:
+                return out
+            out.append((self.inbuf[0], self.inbuf[i + 1:i + 1 + n]))
+            self.inbuf = self.inbuf[i + 1 + n:]
+        return out
+
+    def close(self, graceful):
+        if self.sock is None:
+            return
+        if graceful:
+            self.outbuf += b"\xe0\x00"              # DISCONNECT → LWT yok
+            self.flush()
+        self.sock.close()
+        self.sock = None
+
+
+# --------------------------------------------------------------------------
+#  GATEWAY
+# --------------------------------------------------------------------------
+class Client:
+    def __init__(self, addr):
+        self.addr = addr
+        self.cid = None
+        self.keepalive = 60
+        self.last_rx = time.monotonic()
+        self.state = "new"                          # will_topic, will_msg, wait_broker, up
+        self.will_topic = self.will_msg = None
+        self.will_retain = False
+        self.reg = {}                               # numara → ad (REGISTER)
+        self.reg_by_name = {}
+        self.subs = []
+        self.queue = collections.deque()            # karta gidecek komutlar (konu no, yük)
+        self.inflight = None                        # [MsgId, paket, son gönderim, deneme, ilk gönderim]
+        self.next_mid = 1
+        self.broker = None
+
+    def mid(self):
+        m, self.next_mid = self.next_mid, self.next_mid % 0xFFFF + 1
+        return m
+
+
+class Stats:
+    def __init__(self):
+        self.rx = self.tx = self.rx_bytes = self.tx_bytes = 0
+        self.up = self.down = self.retries = self.lost = self.dropped = 0
+        self.rtt = []
+
+
+class Gateway:
+    def __init__(self, args):
+        self.a = args
+        host, port = args.listen.rsplit(":", 1)
+        self.udp = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.udp.bind((host, int(port)))
+        self.udp.setblocking(False)
+        self.sel = selectors.DefaultSelector()
+        self.sel.register(self.udp, selectors.EVENT_READ, "udp")
+        if args.standalone:
+            self.sel.register(sys.stdin, selectors.EVENT_READ, "stdin")
+            self.broker_addr = None
+        else:
+            bh, bp = args.broker.rsplit(":", 1)
+            self.broker_addr = (socket.gethostbyname(bh), int(bp))
+        self.clients = {}                           # (ip, port) → Client
+        self.st = Stats()
+        self.t_stats = time.monotonic() + args.stats_s
+
+    # ---------------- UDP ----------------
+    def sendto(self, c, pkt):
+        self.udp.sendto(pkt, c.addr)
+        self.st.tx += 1
+        self.st.tx_bytes += len(pkt)
+
+    def on_datagram(self, data, addr):
+        self.st.rx += 1
+        self.st.rx_bytes += len(data)
+        mtype, body = sn_unpack(data)
+        if mtype is None:
+            return
+        c = self.clients.get(addr)
+        if mtype == CONNECT:
+            if c:
+                self.drop(c, graceful=True)
+            c = self.clients[addr] = Client(addr)
+            self.on_connect(c, body)
+            return
+        if c is None:                               # gateway yeniden başlamış → kart yeniden bağlansın
+            self.udp.sendto(sn_pack(DISCONNECT), addr)
+            return
+        c.last_rx = time.monotonic()
+
+        if mtype == WILLTOPIC and c.state == "will_topic":
+            c.will_retain = bool(body[0] & F_RETAIN) if body else False
+            c.will_topic = body[1:].decode(errors="replace")
+            c.state = "will_msg"
+            self.sendto(c, sn_pack(WILLMSGREQ))
+        elif mtype == WILLMSG and c.state == "will_msg":
+            c.will_msg = bytes(body)
+            self.open_broker(c)
+        elif mtype == REGISTER and len(body) >= 4:
+            self.on_register(c, body)
+        elif mtype == PUBLISH and len(body) >= 5:
+            self.on_publish(c, body)
+        elif mtype == PUBACK and len(body) >= 5:
+            mid, rc = struct.unpack(">H", body[2:4])[0], body[4]
+            if c.inflight and c.inflight[0] == mid:
+                self.st.rtt.append(time.monotonic() - c.inflight[4])
+                if rc != RC_OK:
+                    log("%s: PUBACK rc=%d" % (c.cid, rc))
+                c.inflight = None
+                self.pump(c)
+        elif mtype == SUBSCRIBE and len(body) >= 3:
+            self.on_subscribe(c, body)
+        elif mtype == PINGREQ:
+            self.sendto(c, sn_pack(PINGRESP))
+        elif mtype == DISCONNECT:
+            self.sendto(c, sn_pack(DISCONNECT))
+            self.drop(c, graceful=True)
+        elif mtype == REGACK:
+            pass                                    # kart bizim REGISTER’ımızı reddeder; yollamıyoruz
+
+    def on_connect(self, c, body):
+        if len(body) < 5 or body[1] != 0x01:
+            self.sendto(c, sn_pack(CONNACK, bytes((RC_NOT_SUPPORTED,))))
+            return
+        c.cid = body[4:].decode(errors="replace")
+        c.keepalive = struct.unpack(">H", body[2:4])[0] or 60
+        if body[0] & F_WILL:
+            c.state = "will_topic"
+            self.sendto(c, sn_pack(WILLTOPICREQ))
+        else:
+            self.open_broker(c)
+
+    def open_broker(self, c):
+        if self.broker_addr is None:                # --standalone
+            c.state = "up"
+            self.sendto(c, sn_pack(CONNACK, bytes((RC_OK,))))
+            log("%s bağlandı %s:%d" % (c.cid, c.addr[0], c.addr[1]))
+            return
+        c.state = "wait_broker"
+        c.broker = Broker(self.broker_addr, self.a.user, self.a.pwd)
+        will = (c.will_topic, c.will_msg, c.will_retain) if c.will_topic else None
+        c.broker.open(c.cid, will)
+        self.sel.register(c.broker.sock, selectors.EVENT_READ, c)
+
+    def resolve(self, c, flags, tid):
+        if flags & 0x03 == T_PREDEF:
+            return topic_name(c.cid, tid)
+        if flags & 0x03 == T_NORMAL:
+            return c.reg.get(tid)
+        return None
+
+    def on_register(self, c, body):
+        mid = struct.unpack(">H", body[2:4])[0]
+        name = body[4:].decode(errors="replace")
+        tid = c.reg_by_name.get(name)
+        if tid is None:
+            tid = REG_BASE + len(c.reg)
+            c.reg[tid], c.reg_by_name[name] = name, tid
+        self.sendto(c, sn_pack(REGACK, struct.pack(">HHB", tid, mid, RC_OK)))
+
+    def on_publish(self, c, body):
+        flags, tid, mid = struct.unpack(">BHH", body[:5])
+        payload = bytes(body[5:])
+        qos1 = flags & 0x60 == F_QOS1
+        topic = self.resolve(c, flags, tid) if c.state == "up" else None
+        if topic is None:
+            if qos1:
+                self.sendto(c, sn_pack(PUBACK, struct.pack(">HHB", tid, mid, RC_INVALID_TOPIC)))
+            self.st.dropped += 1
+            return
+        retain = bool(flags & F_RETAIN)
+        if c.broker:
+            c.broker.publish(topic, payload, retain)
+            c.broker.flush()
+        else:
+            log("%s%s %s" % (topic, " [r]" if retain else "", payload.decode(errors="replace")))
+        self.st.up += 1
+        if qos1:
+            self.sendto(c, sn_pack(PUBACK, struct.pack(">HHB", tid, mid, RC_OK)))
+
+    def on_subscribe(self, c, body):
+        flags, mid = body[0], struct.unpack(">H", body[1:3])[0]
+        flt = body[3:].decode(errors="replace")
+        rc = RC_OK if flags & 0x03 == T_NORMAL else RC_NOT_SUPPORTED
+        if rc == RC_OK and flt not in c.subs:
+            c.subs.append(flt)
+            if c.broker:
+                c.broker.subscribe(flt)
+                c.broker.flush()
+        self.sendto(c, sn_pack(SUBACK, struct.pack(">BHHB", F_QOS1, 0, mid, rc)))
+
+    # ---------------- karta komut ----------------
+    # Kart yalnız son MsgId’yi hatırlar (tekrar eleme) → kart başına tek
+    # onaysız komut; gerisi sırayla bekler.
+    def to_board(self, c, topic, payload):
+        tid = topic_id(c.cid, topic)
+        if not tid:
+            log("%s: önceden tanımlı değil, atıldı: %s" % (c.cid, topic))
+            self.st.dropped += 1
+            return
+        if len(c.queue) >= QUEUE_MAX:
+            c.queue.popleft()
+            self.st.dropped += 1
+        c.queue.append((tid, payload))
+        self.pump(c)
+
+    def pump(self, c):
+        if c.inflight or not c.queue:
+            return
+        tid, payload = c.queue.popleft()
+        mid = c.mid()
+        pkt = sn_publish(F_QOS1 | T_PREDEF, tid, mid, payload)
+        now = time.monotonic()
+        c.inflight = [mid, pkt, now, 0, now]
+        self.sendto(c, pkt)
+        self.st.down += 1
+
+    def on_broker(self, c):
+        pkts = c.broker.read()
+        if pkts is None:
+            log("%s: broker bağlantısı koptu" % c.cid)
+            self.drop(c, graceful=False, notify=True)
+            return
+        for hdr, body in pkts:
+            kind = hdr >> 4
+            if kind == 2 and c.state == "wait_broker":             # CONNACK
+                rc = body[1] if len(body) >= 2 else 5
+                self.sendto(c, sn_pack(CONNACK, bytes((RC_OK if rc == 0 else RC_NOT_SUPPORTED,))))
+                if rc:
+                    log("%s: broker reddetti (rc=%d)" % (c.cid, rc))
+                    self.drop(c, graceful=False)
+                    return
+                c.state = "up"
+                log("%s bağlandı %s:%d" % (c.cid, c.addr[0], c.addr[1]))
+            elif kind == 3:                                        # PUBLISH
+                tl = struct.unpack(">H", body[:2])[0]
+                off = 2 + tl + (2 if (hdr >> 1) & 3 else 0)
+                self.to_board(c, body[2:2 + tl].decode(errors="replace"), bytes(body[off:]))
+
+    def on_stdin(self):
+        line = sys.stdin.readline()
+        if not line:
+            self.sel.unregister(sys.stdin)
+            return
+        topic, _, payload = line.strip().partition(" ")
+        if not topic:
+            return
+        for c in list(self.clients.values()):
+            if c.state == "up" and any(topic_match(f, topic) for f in c.subs):
+                self.to_board(c, topic, payload.encode())
+
+    # ---------------- zamanlayıcılar ----------------
+    def drop(self, c, graceful, notify=False):
+        if notify:
+            self.udp.sendto(sn_pack(DISCONNECT), c.addr)
+        if c.broker and c.broker.sock:
+            self.sel.unregister(c.broker.sock)
+            c.broker.close(graceful)
+        self.clients.pop(c.addr, None)
+
+    def tick(self):
+        now = time.monotonic()
+        for c in list(self.clients.values()):
+            if now - c.last_rx > c.keepalive * 1.5:
+                log("%s: keepalive doldu (LWT)" % c.cid)
+                self.drop(c, graceful=False)
+                continue
+            p = c.inflight
+            if p and now - p[2] >= self.a.retry_ms / 1000.0:
+                if p[3] >= self.a.retries:
+                    log("%s: PUBACK yok, komut düştü (MsgId %d)" % (c.cid, p[0]))
+                    c.inflight = None
+                    self.st.lost += 1
+                    self.pump(c)
+                else:
+                    fl = 4 if p[1][0] == 1 else 2   # bayrak: boy + tip’ten sonra
+                    p[1] = p[1][:fl] + bytes((p[1][fl] | F_DUP,)) + p[1][fl + 1:]
+                    p[2], p[3] = now, p[3] + 1
+                    self.sendto(c, p[1])
+                    self.st.retries += 1
+            if c.broker and c.broker.sock:
+                if now - c.broker.last_tx > 30:
+                    c.broker.send(b"\xc0\x00")      # PINGREQ
+                c.broker.flush()
+        if now >= self.t_stats:
+            self.report()
+            self.t_stats = now + self.a.stats_s
+
+    def report(self):
+        s = self.st
+        rtt = sorted(s.rtt)
+        pct = lambda p: rtt[min(len(rtt) - 1, int(p / 100.0 * len(rtt)))] * 1000 if rtt else 0.0
+        log("kart %d | datagram al %d (%d B) ver %d (%d B) | yukarı %d aşağı %d | "
+            "tekrar %d kayıp %d atılan %d | komut PUBACK p50 %.1f p95 %.1f ms"
+            % (sum(c.state == "up" for c in self.clients.values()), s.rx, s.rx_bytes, s.tx,
+               s.tx_bytes, s.up, s.down, s.retries, s.lost, s.dropped, pct(50), pct(95)))
+
+    def run(self):
+        log("MQTT-SN %s → %s" % (self.a.listen, "standalone" if self.broker_addr is None
+                                  else "%s:%d" % self.broker_addr))
+        try:
+            while True:
+                for key, _ in self.sel.select(timeout=0.05):
+                    if key.data == "udp":
+                        while True:
+                            try:
+                                data, addr = self.udp.recvfrom(2048)
+                            except BlockingIOError:
+                                break
+                            self.on_datagram(data, addr)
+                    elif key.data == "stdin":
+                        self.on_stdin()
+                    else:
+                        self.on_broker(key.data)
+                self.tick()
+        except KeyboardInterrupt:
+            self.report()
+
+
+def log(msg):
+    print("%s %s" % (time.strftime("%H:%M:%S"), msg), flush=True)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--listen", default="0.0.0.0:1885", help="UDP adres:port (config.h MQTT_SN_PORT)")
+    ap.add_argument("--broker", default="127.0.0.1:1883")
+    ap.add_argument("--user", default="")
+    ap.add_argument("--pass", dest="pwd", default="")
+    ap.add_argument("--standalone", action="store_true", help="broker yok: ekrana yaz, stdin’den komut")
+    ap.add_argument("--retry-ms", type=int, default=500, help="komut PUBACK bekleme")
+    ap.add_argument("--retries", type=int, default=3)
+    ap.add_argument("--stats-s", type=float, default=10.0, help="sayaç satırı aralığı")
+    Gateway(ap.parse_args()).run()
+
+
+if __name__ == "__main__":
+    main()
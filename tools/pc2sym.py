@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+"""pc2sym.py — kartın gönderdiği flash adreslerini ELF sembollerine çevirir.
+
+Girdi (src/diag.cpp, src/mqtt_haberlesme.cpp):
+    <FLOOR_ID>/diag/crash    {"pc":"0x01a2b4","task":"mqtt","sp":"0x21c0",...}
+    <FLOOR_ID>/diag/profile  {"run":1,"n":N,"shift":11,"b":[[bölge,sayı],...],
+                              "task":{...},"pc":[byte adresi,...]}
+    ya da komut satırında çıplak adresler (0x1a2b4 / 107188, byte adresi).
+
+Profil bölgeleri 2^shift byte’lık flash dilimleridir; her bölge için o
+dilimle örtüşen fonksiyonlar (en büyük örtüşme önce) listelenir.
+
+Kullanım:
+    python3 tools/pc2sym.py .pio/build/megaatmega2560/firmware.elf 0x1a2b4
+    mosquitto_sub -t up32/diag/crash -C 1 | python3 tools/pc2sym.py firmware.elf -
+    python3 tools/pc2sym.py firmware.elf profile.json --lines   (avr-addr2line)
+"""
+import argparse
+import bisect
+import json
+import subprocess
+import sys
+
+
+def load_symbols(elf, nm):
+    """ELF → [(adres, boy, ad)] yalnız .text sembolleri, adrese göre sıralı."""
+    out = subprocess.check_output([nm, "-n", "-S", "-C", "--defined-only", elf], text=True)
+    syms = []
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in "tTwW":
+            syms.append((int(parts[0], 16), int(parts[1], 16), parts[3]))
+        elif len(parts) == 3 and parts[1] in "tTwW":
+            syms.append((int(parts[0], 16), 0, parts[2]))
+    return syms
+
+
+class SymTab:
+    def __init__(self, syms):
+        self.syms = syms
+        self.addrs = [s[0] for s in syms]
+
+    def lookup(self, pc):
+        i = bisect.bisect_right(self.addrs, pc) - 1
+        if i < 0:
+            return "?"
+        addr, size, name = self.syms[i]
+        if size and pc >= addr + size:
+            return "? (%s+0x%x sonrası)" % (name, size)
+        return "%s+0x%x" % (name, pc - addr)
+
+    def overlapping(self, lo, hi):
+        """[lo, hi) ile örtüşen fonksiyonlar, örtüşme büyükten küçüğe."""
+        res = []
+        i = max(bisect.bisect_right(self.addrs, lo) - 1, 0)
+        for addr, size, name in self.syms[i:]:
+            if addr >= hi:
+                break
+            end = addr + max(size, 2)
+            ov = min(end, hi) - max(addr, lo)
+            if ov > 0:
+                res.append((ov, name))
+        res.sort(reverse=True)
+        return res
+
+
+def addr2line(elf, tool, pcs):
+    if not pcs:
+        return {}
+    out = subprocess.check_output([tool, "-e", elf, "-f", "-C"] + ["0x%x" % p for p in pcs],
+                                  text=True).splitlines()
+    return {pc: out[2 * k + 1] for k, pc in enumerate(pcs)}
+
+
+def parse_addr(s):
+    return int(s, 16) if s.lower().startswith("0x") else int(s)
+
+
+def show_pcs(tab, pcs, lines):
+    for pc in pcs:
+        extra = ("  " + lines[pc]) if pc in lines else ""
+        print("  0x%06x  %s%s" % (pc, tab.lookup(pc), extra))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("elf")
+    ap.add_argument("inputs", nargs="+", help="adres | JSON dosyası | - (stdin)")
+    ap.add_argument("--nm", default="avr-nm")
+    ap.add_argument("--addr2line", default="avr-addr2line")
+    ap.add_argument("--lines", action="store_true", help="dosya:satır da göster")
+    ap.add_argument("--top", type=int, default=3, help="bölge başına gösterilecek fonksiyon")
+    args = ap.parse_args()
+
+    tab = SymTab(load_symbols(args.elf, args.nm))
+
+    for inp in args.inputs:
+        try:
+            pc = parse_addr(inp)
+        except ValueError:
+            pc = None
+        if pc is not None:
+            lines = addr2line(args.elf, args.addr2line, [pc]) if args.lines else {}
+            show_pcs(tab, [pc], lines)
+            continue
+
+        text = sys.stdin.read() if inp == "-" else open(inp).read()
+        doc = json.loads(text)
+
+        if "b" in doc:                                      # diag/profile
+            shift, total = doc.get("shift", 11), sum(c for _, c in doc["b"]) or 1
+            print("profil: %d örnek (%s)" % (doc.get("n", total), "açık" if doc.get("run") else "kapalı"))
+            for region, cnt in sorted(doc["b"], key=lambda x: -x[1]):
+                lo, hi = region << shift, (region + 1) << shift
+                funcs = ", ".join(n for _, n in tab.overlapping(lo, hi)[:args.top])
+                print("  %5.1f%%  0x%06x-0x%06x  %s" % (100.0 * cnt / total, lo, hi - 1, funcs))
+            tasks = doc.get("task", {})
+            ttotal = sum(tasks.values()) or 1
+            print("görevler:")
+            for name, cnt in sorted(tasks.items(), key=lambda x: -x[1]):
+                print("  %5.1f%%  %s" % (100.0 * cnt / ttotal, name))
+            pcs = [p for p in doc.get("pc", []) if p]
+            if pcs:
+                print("son PC’ler:")
+                show_pcs(tab, pcs, addr2line(args.elf, args.addr2line, pcs) if args.lines else {})
+        elif "pc" in doc:                                   # diag/crash
+            pc = parse_addr(str(doc["pc"]))
+            print("WDT reset x%s  görev=%s  sp=%s  yığın=%s B  uptime=%s s" %
+                  (doc.get("n"), doc.get("task"), doc.get("sp"), doc.get("stack"), doc.get("up")))
+            show_pcs(tab, [pc], addr2line(args.elf, args.addr2line, [pc]) if args.lines else {})
+        else:
+            sys.exit("tanınmayan JSON: %s" % inp)
+
+
+if __name__ == "__main__":
+    main()
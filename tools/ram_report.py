@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""ram_report.py — firmware.map’ten statik RAM dökümü (+ isteğe bağlı .su).
+
+Girdi:
+    .pio/build/<env>/firmware.map   platformio.ini: -Wl,-Map,${BUILD_DIR}/firmware.map
+    .pio/build/<env>/**/*.su        yalnız [env:megaatmega2560_noheap] (-fstack-usage)
+
+Çıktı:
+    .data / .bss / .noinit toplamları ve yığın + heap’e kalan RAM,
+    nesne dosyası başına byte (büyükten küçüğe),
+    en büyük semboller (AVR çekirdeği -fdata-sections ile derler → girdi
+    bölümü adı “.bss.<sembol>”dür; adsızlar dosya adıyla görünür),
+    --su ile en büyük yığın çerçeveleri (fonksiyon başına, byte).
+
+Kullanım:
+    python3 tools/ram_report.py .pio/build/megaatmega2560/firmware.map
+    python3 tools/ram_report.py firmware.map --top 30 --su .pio/build/megaatmega2560_noheap
+"""
+import argparse
+import collections
+import os
+import re
+import shutil
+import subprocess
+import sys
+
+RAM_SECTIONS = (".data", ".bss", ".noinit")
+HEX = r"0x[0-9a-fA-F]+"
+INPUT_RE = re.compile(r"^ (\S+)\s+(" + HEX + r")\s+(" + HEX + r")\s+(.+)$")
+WRAPPED_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$")
+
+
+def parse_map(path):
+    """→ [(çıktı bölümü, girdi bölümü, boy, nesne)] yalnız RAM bölümleri."""
+    out, current, pending = [], None, None
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line and not line[0].isspace():              # çıktı bölümü başlığı
+                name = line.split()[0]
+                current = name if name in RAM_SECTIONS else None
+                pending = None
+                continue
+            if current is None:
+                continue
+            if pending is not None:                         # uzun ad → sonraki satır
+                m = WRAPPED_RE.match(line)
+                if m:
+                    out.append((current, pending, int(m.group(2), 16), m.group(3).strip()))
+                pending = None
+                continue
+            m = INPUT_RE.match(line)
+            if m:
+                out.append((current, m.group(1), int(m.group(3), 16), m.group(4).strip()))
+            elif re.match(r"^ (\.\S+|COMMON)$", line):
+                pending = line.strip()
+    return [r for r in out if r[2] > 0]
+
+
+def short_obj(obj):
+    """.pio/build/env/src/main.cpp.o → src/main.cpp.o,  libFrameworkArduino.a(HardwareSerial0.cpp.o) aynen."""
+    obj = obj.replace("\\", "/")
+    m = re.search(r"/([^/]+\.a\(.*\))$", obj)
+    if m:
+        return m.group(1)
+    parts = obj.split("/")
+    return "/".join(parts[-2:]) if len(parts) > 1 else obj
+
+
+def symbol_of(section, out_section, obj):
+    for prefix in RAM_SECTIONS:
+        if section.startswith(prefix + ".") and section != prefix:
+            return section[len(prefix) + 1:]
+    return "(%s %s)" % (out_section, short_obj(obj))
+
+
+def demangle(names, tool):
+    exe = shutil.which(tool) or shutil.which("c++filt")
+    if not exe or not names:
+        return {n: n for n in names}
+    res = subprocess.run([exe], input="\n".join(names), capture_output=True, text=True)
+    lines = res.stdout.splitlines()
+    return dict(zip(names, lines)) if len(lines) == len(names) else {n: n for n in names}
+
+
+def read_su(root):
+    """GCC -fstack-usage: "dosya:satır:sütun:fonksiyon<TAB>byte<TAB>tür"."""
+    frames = []
+    for dirpath, _, files in os.walk(root):
+        for fn in files:
+            if not fn.endswith(".su"):
+                continue
+            with open(os.path.join(dirpath, fn), errors="replace") as f:
+                for line in f:
+                    parts = line.rstrip("\n").split("\t")
+                    if len(parts) >= 3 and parts[1].isdigit():
+                        loc = parts[0].rsplit(":", 1)
+                        frames.append((int(parts[1]), parts[2], loc[-1],
+                                       os.path.basename(loc[0].split(":")[0])))
+    frames.sort(reverse=True)
+    return frames
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("map")
+    ap.add_argument("--ram", type=int, default=8192, help="SRAM (byte), ATmega2560: 8192")
+    ap.add_argument("--top", type=int, default=20, help="listelenecek sembol / çerçeve")
+    ap.add_argument("--su", metavar="DIZIN", help=".su dosyalarının kök dizini")
+    ap.add_argument("--cxxfilt", default="avr-c++filt")
+    args = ap.parse_args()
+
+    rows = parse_map(args.map)
+    if not rows:
+        sys.exit("RAM bölümü bulunamadı: %s (ld -Map çıktısı mı?)" % args.map)
+
+    per_sec = collections.Counter()
+    per_obj = collections.defaultdict(collections.Counter)
+    per_sym = collections.Counter()
+    for out_sec, sec, size, obj in rows:
+        per_sec[out_sec] += size
+        per_obj[short_obj(obj)][out_sec] += size
+        per_sym[(symbol_of(sec, out_sec, obj), out_sec, short_obj(obj))] += size
+
+    static = sum(per_sec.values())
+    print("statik RAM: %d B  (%s)" % (static, "  ".join("%s %d" % (s, per_sec[s]) for s in RAM_SECTIONS)))
+    print("yığın + heap’e kalan: %d B / %d" % (args.ram - static, args.ram))
+
+    print("\nnesne dosyası              toplam    data     bss  noinit")
+    for obj, c in sorted(per_obj.items(), key=lambda x: -sum(x[1].values())):
+        print("  %-24s %6d  %6d  %6d  %6d" % (obj[-24:], sum(c.values()),
+                                               c[".data"], c[".bss"], c[".noinit"]))
+
+    top = per_sym.most_common(args.top)
+    names = demangle([k[0] for k, _ in top], args.cxxfilt)
+    print("\nen büyük %d sembol:" % len(top))
+    for (sym, sec, obj), size in top:
+        print("  %6d  %-7s %-40s %s" % (size, sec, names.get(sym, sym)[:40], obj))
+
+    if args.su:
+        frames = read_su(args.su)
+        print("\nen büyük %d yığın çerçevesi (%d fonksiyon):" % (min(args.top, len(frames)), len(frames)))
+        for size, kind, func, src in frames[:args.top]:
+            print("  %6d  %-16s %-40s %s" % (size, kind, func[:40], src))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""rules_compile.py — kural metnini karttaki bytecode'a (src/rules.h) derler.
+
+Her satır bir kural:
+    <koşul> -> on|off|copy <çıkış>
+Koşul:
+    Y0 / X3            çıkış durumu (0/1)
+    Y4.amp             Irms (A)          → kartta ×100 tamsayı
+    Y4.w               güç (W)
+    M1.temp            modül sıcaklığı (°C, M0..M3) → kartta ×10
+    > < ==  and or not ( )   sayılar: 8, 7.5, 1500
+Örnek:
+    Y4.amp > 8 -> off X3          # Y4 8 A'yi geçerse X3'ü kapat
+    Y0 -> on X0                   # Y0 açılınca X0'ı da aç
+    M2.temp > 60 and not Y9 -> off Y8
+
+Kullanım:
+    python3 tools/rules_compile.py rules.txt
+    mosquitto_pub -t up32/rules/set -m "$(python3 tools/rules_compile.py rules.txt)"
+"""
+import re
+import sys
+
+OP = dict(END=0x00, PIN=0x01, AMP=0x02, WATT=0x03, TEMP=0x04, CONST=0x05,
+          GT=0x06, LT=0x07, EQ=0x08, AND=0x09, OR=0x0A, NOT=0x0B,
+          ON=0x0C, OFF=0x0D, COPY=0x0E)
+MAX_CODE = 240
+MAX_STACK = 8
+SCALE = {"amp": 100, "temp": 10, "w": 1, "pin": 1}
+
+TOKEN = re.compile(r"\s*(->|==|[<>()]|[A-Za-z_][A-Za-z0-9_.]*|\d+(?:\.\d+)?)")
+
+
+class RuleError(Exception):
+    pass
+
+
+def tokenize(text):
+    pos, out = 0, []
+    text = text.strip()
+    while pos < len(text):
+        m = TOKEN.match(text, pos)
+        if not m:
+            raise RuleError("anlaşılmayan: %r" % text[pos:])
+        out.append(m.group(1))
+        pos = m.end()
+    return out
+
+
+def output_index(name):
+    m = re.fullmatch(r"([YX])(\d{1,2})", name)
+    if not m or int(m.group(2)) > 15:
+        raise RuleError("çıkış adı hatalı: %s" % name)
+    return int(m.group(2)) + (0 if m.group(1) == "Y" else 16)
+
+
+class Parser:
+    """Özyinelemeli iniş; her düğüm (kod, birim) döndürür, sabit = (değer, None)."""
+
+    def __init__(self, toks):
+        self.t, self.i = toks, 0
+
+    def peek(self):
+        return self.t[self.i] if self.i < len(self.t) else None
+
+    def take(self, want=None):
+        tok = self.peek()
+        if tok is None or (want and tok != want):
+            raise RuleError("beklenen %s, gelen %s" % (want or "ifade", tok))
+        self.i += 1
+        return tok
+
+    def expr(self):
+        code = self.conj()
+        while self.peek() == "or":
+            self.take()
+            code = code + self.conj() + [OP["OR"]]
+        return code
+
+    def conj(self):
+        code = self.neg()
+        while self.peek() == "and":
+            self.take()
+            code = code + self.neg() + [OP["AND"]]
+        return code
+
+    def neg(self):
+        if self.peek() == "not":
+            self.take()
+            return self.neg() + [OP["NOT"]]
+        return self.cmp()
+
+    def cmp(self):
+        left = self.atom()
+        if self.peek() in (">", "<", "=="):
+            op = {">": "GT", "<": "LT", "==": "EQ"}[self.take()]
+            right = self.atom()
+            unit = left[1] or right[1] or "w"
+            return emit(left, unit) + emit(right, unit) + [OP[op]]
+        return emit(left, "pin")
+
+    def atom(self):
+        tok = self.take()
+        if tok == "(":
+            code = self.expr()
+            self.take(")")
+            return (code, "pin")
+        if re.fullmatch(r"\d+(?:\.\d+)?", tok):
+            return (float(tok), None)
+        m = re.fullmatch(r"([YXM])(\d{1,2})(?:\.(amp|w|temp))?", tok)
+        if not m:
+            raise RuleError("bilinmeyen: %s" % tok)
+        kind, n, field = m.group(1), int(m.group(2)), m.group(3)
+        if kind == "M":
+            if field != "temp" or n > 3:
+                raise RuleError("modül: M0..M3.temp")
+            return ([OP["TEMP"], n], "temp")
+        if field is None:
+            return ([OP["PIN"], output_index(tok)], "pin")
+        if kind != "Y" or n > 15 or field == "temp":
+            raise RuleError("akım/güç yalnız Y0..Y15: %s" % tok)
+        return ([OP["AMP" if field == "amp" else "WATT"], n], field)
+
+
+def emit(node, unit):
+    value, own = node
+    if own is not None:
+        return value
+    v = int(round(value * SCALE[unit]))
+    if not -32768 <= v <= 32767:
+        raise RuleError("sabit int16 dışında: %s" % value)
+    return [OP["CONST"], v & 0xFF, (v >> 8) & 0xFF]
+
+
+def stack_depth(code):
+    width = {OP["CONST"]: 2}
+    for k in ("PIN", "AMP", "WATT", "TEMP", "ON", "OFF", "COPY"):
+        width[OP[k]] = 1
+    delta = {OP[k]: +1 for k in ("PIN", "AMP", "WATT", "TEMP", "CONST")}
+    delta.update({OP[k]: -1 for k in ("GT", "LT", "EQ", "AND", "OR", "ON", "OFF", "COPY")})
+    depth = peak = i = 0
+    while i < len(code):
+        depth += delta.get(code[i], 0)
+        peak = max(peak, depth)
+        i += 1 + width.get(code[i], 0)
+    return peak
+
+
+def compile_rule(line):
+    toks = tokenize(line)
+    if "->" not in toks:
+        raise RuleError("'->' yok")
+    k = toks.index("->")
+    p = Parser(toks[:k])
+    cond = p.expr()
+    if p.peek() is not None:
+        raise RuleError("fazla: %s" % p.peek())
+    action = toks[k + 1:]
+    if len(action) != 2 or action[0] not in ("on", "off", "copy"):
+        raise RuleError("eylem: on|off|copy <çıkış>")
+    return cond + [OP[action[0].upper()], output_index(action[1])]
+
+
+def compile_text(text):
+    code = []
+    for no, raw in enumerate(text.splitlines(), 1):
+        line = raw.split("#", 1)[0].strip()
+        if not line:
+            continue
+        try:
+            rule = compile_rule(line)
+        except RuleError as e:
+            raise RuleError("satır %d: %s" % (no, e))
+        if stack_depth(rule) > MAX_STACK:
+            raise RuleError("satır %d: yığın > %d" % (no, MAX_STACK))
+        code += rule
+    code.append(OP["END"])
+    if len(code) > MAX_CODE:
+        raise RuleError("program %d byte > %d" % (len(code), MAX_CODE))
+    return bytes(code)
+
+
+def main():
+    src = open(sys.argv[1]).read() if len(sys.argv) > 1 else sys.stdin.read()
+    try:
+        print(compile_text(src).hex().upper())
+    except RuleError as e:
+        sys.exit("hata: %s" % e)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,311 @@
+#!/usr/bin/env python3
+"""wave_plot.py — kartın ham akım dalga biçimi yakalamasını alır, çözer, çizer.
+
+Kart (WAVE_CAPTURE=1, src/wave_capture.cpp) <FLOOR_ID>/wave/set ile kurulur,
+biten yakalamayı <FLOOR_ID>/diag/wave’e ikili parçalarla akıtır:
+
+    her parça   sıra(1) toplam(1) id(2, LE) …
+    sıra 0      ver(1)=2 flags(1) mask(2) hz(2) n(2) start(2) pre(2)
+                firstCh(1) trigCh(1) scan(2) ofset(2) × maskedeki kanal (artan)
+    sıra 1‥     10 bit paketli halka tampon: 4 örnek → 4 alt byte + 1 byte
+                (örnek k’nın üst 2 biti, bit 2k‥2k+1)
+
+Halka `start`’tan döndürülünce zaman sırası çıkar; k kanal maskede artan
+sırayla, `firstCh`’den başlayarak dönüşümlü örneklenmiştir. Tetikli
+yakalamada tetik örneği `pre`-1. sıradadır; ona kadar ISR normal sırasında
+(`scan` maskesindeki kanallar, her biri bir tik, 1/hz s) gezdiğinden iki
+örnek arası scan sırasındaki uzaklıktır, tetikten sonra her örnek bir tik.
+
+Kullanım:
+    python3 tools/wave_plot.py --broker 192.168.1.113 --id up32 --arm "Y5:zc"
+    python3 tools/wave_plot.py --broker … --arm "Y0,Y4,Y8" --csv y.csv --png y.png
+    python3 tools/wave_plot.py --load cap.bin            (--save ile kaydedilmiş)
+matplotlib yoksa kanal başına özet + metin grafiği basılır.
+"""
+import argparse
+import socket
+import struct
+import sys
+import time
+
+ADC_TO_AMP = 5.0 / 1023.0 / 0.100       # src/current_sense.cpp: ACS712-20A, 100 mV/A
+F_TRIG, F_FORCED = 0x01, 0x02
+
+
+# --------------------------------------------------------------------------
+#  EN KÜÇÜK MQTT 3.1.1 İSTEMCİSİ (QoS0)
+# --------------------------------------------------------------------------
+def mq_str(s):
+    b = s.encode() if isinstance(s, str) else s
+    return struct.pack(">H", len(b)) + b
+
+
+def mq_packet(hdr, body):
+    out, n = bytearray((hdr,)), len(body)
+    while True:
+        b, n = n % 128, n // 128
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out) + body
+
+
+class Mqtt:
+    def __init__(self, host, port, cid, user=None, pwd=None):
+        self.sock = socket.create_connection((host, port), timeout=5)
+        self.buf = b""
+        flags = 0x02 | (0x80 if user else 0) | (0x40 if pwd else 0)
+        body = mq_str("MQTT") + bytes((4, flags)) + struct.pack(">H", 60) + mq_str(cid)
+        if user:
+            body += mq_str(user)
+        if pwd:
+            body += mq_str(pwd)
+        self.sock.sendall(mq_packet(0x10, body))
+        pkt = self.read(5)
+        if not pkt or pkt[0] >> 4 != 2 or pkt[1][1] != 0:
+            raise SystemExit("broker bağlantıyı reddetti")
+
+    def subscribe(self, topic):
+        self.sock.sendall(mq_packet(0x82, struct.pack(">H", 1) + mq_str(topic) + b"\x00"))
+
+    def publish(self, topic, payload):
+        self.sock.sendall(mq_packet(0x30, mq_str(topic) + payload))
+
+    def read(self, timeout):
+        """Sıradaki paket (hdr, gövde); süre dolarsa None."""
+        end = time.monotonic() + timeout
+        while True:
+            if len(self.buf) >= 2:
+                n, mul, i = 0, 1, 1
+                while i < len(self.buf):
+                    b = self.buf[i]
+                    n += (b & 0x7F) * mul
+                    mul *= 128
+                    i += 1
+                    if not b & 0x80:
+                        break
+                else:
+                    i = None
+                if i is not None and len(self.buf) >= i + n:
+                    hdr, body = self.buf[0], self.buf[i:i + n]
+                    self.buf = self.buf[i + n:]
+                    return hdr, body
+            left = end - time.monotonic()
+            if left <= 0:
+                return None
+            self.sock.settimeout(left)
+            try:
+                data = self.sock.recv(4096)
+            except socket.timeout:
+                return None
+            if not data:
+                raise SystemExit("broker bağlantısı koptu")
+            self.buf += data
+
+
+def publish_payload(hdr, body):
+    tl = struct.unpack(">H", body[:2])[0]
+    off = 2 + tl + (2 if (hdr >> 1) & 3 else 0)
+    return body[2:2 + tl].decode(errors="replace"), body[off:]
+
+
+# --------------------------------------------------------------------------
+#  PARÇALARI BİRLEŞTİR / ÇÖZ
+# --------------------------------------------------------------------------
+class Capture:
+    def __init__(self):
+        self.id = None
+        self.total = None
+        self.parts = {}
+
+    def add(self, chunk):
+        """Parçayı ekle; yeni bir id gelirse eskisi atılır. True → tamam."""
+        if len(chunk) < 4:
+            return False
+        seq, total, cid = chunk[0], chunk[1], struct.unpack("<H", chunk[2:4])[0]
+        if cid != self.id:
+            self.id, self.total, self.parts = cid, total, {}
+        self.parts[seq] = chunk
+        return len(self.parts) == self.total
+
+    def missing(self):
+        return [s for s in range(self.total or 0) if s not in self.parts]
+
+    def decode(self):
+        meta = self.parts[0][4:]
+        ver, flags, mask, hz, n, start, pre, first, trig, scan = struct.unpack("<BBHHHHHBBH", meta[:16])
+        if ver != 2:
+            raise SystemExit("bilinmeyen biçim sürümü %d" % ver)
+        chans = [ch for ch in range(16) if mask & (1 << ch)]
+        offs = struct.unpack("<%dH" % len(chans), meta[16:16 + 2 * len(chans)])
+        order = [ch for ch in range(16) if scan & (1 << ch)]
+        data = b"".join(self.parts[s][4:] for s in range(1, self.total))
+
+        raw = []
+        for g in range(n // 4):
+            grp = data[5 * g:5 * g + 5]
+            for k in range(4):
+                raw.append(grp[k] | ((grp[4] >> (2 * k)) & 3) << 8)
+        raw = raw[start:] + raw[:start]                 # zaman sırası
+
+        pos = chans.index(first)
+        series = {ch: [] for ch in chans}               # ch → [(t_ms, ham, A)]
+        tick, prev, t_trig = 0, None, None
+        for j, r in enumerate(raw):
+            ch = chans[(pos + j) % len(chans)]
+            if prev is not None:
+                gap = (order.index(ch) - order.index(prev)) % len(order) or len(order)
+                tick += gap if j < pre else 1           # tetiğe kadar normal ISR sırası
+            prev = ch
+            if j == pre - 1:
+                t_trig = tick * 1000.0 / hz
+            off = offs[chans.index(ch)]
+            series[ch].append((tick * 1000.0 / hz, r, (r - off) * ADC_TO_AMP))
+        return {
+            "id": self.id, "flags": flags, "hz": hz, "n": n, "pre": pre, "trig": trig,
+            "chans": chans, "offs": dict(zip(chans, offs)), "series": series,
+            "t_trig": t_trig if flags & (F_TRIG | F_FORCED) else None,
+        }
+
+
+def save(cap, path):
+    with open(path, "wb") as f:
+        for s in range(cap.total):
+            f.write(bytes((len(cap.parts[s]),)) + cap.parts[s])
+
+
+def load(path):
+    cap = Capture()
+    with open(path, "rb") as f:
+        data = f.read()
+    i = 0
+    while i < len(data):
+        n = data[i]
+        cap.add(data[i + 1:i + 1 + n])
+        i += 1 + n
+    return cap
+
+
+# --------------------------------------------------------------------------
+#  ÇIKTI
+# --------------------------------------------------------------------------
+def summary(w):
+    trig = "yok"
+    if w["flags"] & F_TRIG:
+        trig = "Y%d @ %.2f ms" % (w["trig"], w["t_trig"])
+    elif w["flags"] & F_FORCED:
+        trig = "zaman aşımı (zorla)"
+    k = len(w["chans"])
+    print("yakalama %d: %d örnek, %d kanal × %.0f Hz, tetik %s"
+          % (w["id"], w["n"], k, w["hz"] / k, trig))
+    for ch in w["chans"]:
+        a = [s[2] for s in w["series"][ch]]
+        rms = (sum(x * x for x in a) / len(a)) ** 0.5
+        print("  Y%-2d ofset %4d  min %7.2f A  max %7.2f A  rms %6.2f A"
+              % (ch, w["offs"][ch], min(a), max(a), rms))
+
+
+def text_plot(w, width=72, height=9):
+    for ch in w["chans"]:
+        a = [s[2] for s in w["series"][ch]]
+        lo, hi = min(a), max(a)
+        span = (hi - lo) or 1.0
+        step = max(1, len(a) // width)
+        cols = [a[i] for i in range(0, len(a), step)][:width]
+        print("Y%d  [%.2f … %.2f A]" % (ch, lo, hi))
+        for row in range(height - 1, -1, -1):
+            line = "".join("*" if int((v - lo) / span * (height - 1) + 0.5) == row else " " for v in cols)
+            print("  |" + line)
+
+
+def write_csv(w, path):
+    with open(path, "w") as f:
+        f.write("t_ms,ch,raw,amp\n")
+        rows = sorted((t, ch, r, a) for ch in w["chans"] for (t, r, a) in w["series"][ch])
+        for t, ch, r, a in rows:
+            f.write("%.3f,Y%d,%d,%.4f\n" % (t, ch, r, a))
+
+
+def mpl_plot(w, png):
+    try:
+        import matplotlib
+        if png:
+            matplotlib.use("Agg")
+        import matplotlib.pyplot as plt
+    except ImportError:
+        return False
+    fig, ax = plt.subplots(figsize=(10, 4))
+    for ch in w["chans"]:
+        s = w["series"][ch]
+        ax.plot([x[0] for x in s], [x[2] for x in s], ".-", ms=2, lw=0.8, label="Y%d" % ch)
+    if w["t_trig"] is not None:
+        ax.axvline(w["t_trig"], color="k", ls=":", lw=0.8)
+    ax.set_xlabel("ms")
+    ax.set_ylabel("A")
+    ax.set_title("yakalama %d" % w["id"])
+    ax.grid(True, alpha=0.3)
+    ax.legend()
+    if png:
+        fig.savefig(png, dpi=120, bbox_inches="tight")
+    else:
+        plt.show()
+    return True
+
+
+# --------------------------------------------------------------------------
+def receive(args):
+    host, _, port = args.broker.partition(":")
+    m = Mqtt(host, int(port or 1883), "%s_wave" % args.id, args.user, args.pwd)
+    m.subscribe("%s/diag/wave" % args.id)
+    if args.arm:
+        m.read(0.3)                                      # SUBACK
+        m.publish("%s/wave/set" % args.id, args.arm.encode())
+    cap = Capture()
+    end = time.monotonic() + args.timeout
+    while time.monotonic() < end:
+        pkt = m.read(end - time.monotonic())
+        if not pkt or pkt[0] >> 4 != 3:
+            continue
+        topic, payload = publish_payload(*pkt)
+        if topic.endswith("/diag/wave") and cap.add(payload):
+            return cap
+    if cap.total:
+        sys.exit("eksik parça: %s (MQTT-SN’de QoS0 — yeniden kurun)" % cap.missing())
+    sys.exit("yakalama gelmedi (%d s)" % args.timeout)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--broker", help="host[:port]")
+    ap.add_argument("--id", default="up32", help="FLOOR_ID")
+    ap.add_argument("--user")
+    ap.add_argument("--pass", dest="pwd")
+    ap.add_argument("--arm", help='wave/set yükü, ör. "Y5:zc", "Y0,Y4:lvl200", "all"')
+    ap.add_argument("--timeout", type=float, default=15.0, help="yakalama bekleme (s)")
+    ap.add_argument("--load", help="--save ile kaydedilmiş parçalar")
+    ap.add_argument("--save", help="ham parçaları kaydet")
+    ap.add_argument("--csv", help="t_ms,ch,raw,amp")
+    ap.add_argument("--png", help="matplotlib ile dosyaya çiz")
+    ap.add_argument("--text", action="store_true", help="matplotlib yerine metin grafiği")
+    args = ap.parse_args()
+
+    if args.load:
+        cap = load(args.load)
+        if not cap.total or cap.missing():
+            sys.exit("eksik parça: %s" % cap.missing())
+    elif args.broker:
+        cap = receive(args)
+    else:
+        ap.error("--broker ya da --load gerekli")
+
+    if args.save:
+        save(cap, args.save)
+    w = cap.decode()
+    summary(w)
+    if args.csv:
+        write_csv(w, args.csv)
+    if args.text or not mpl_plot(w, args.png):
+        text_plot(w)
+
+
+if __name__ == "__main__":
+    main()